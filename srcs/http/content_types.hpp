@@ -351,76 +351,49 @@ class ContentType
         return fromMimeString(media);
     }
 
-    // 7. 拡張子からの生成 (fromExtension)
-    static ContentType fromExtension(const char* extension)
+    // 7. 拡張子との対応表（http::MimeTypes の初期値。検索は MimeTypes で行う）
+    struct ExtensionEntry
     {
-        if (extension == NULL)
-            return UNKNOWN;
-
-        // 先頭の "." を削除
-        const char* ext = extension;
-        if (ext[0] == '.')
-            ext++;
-
-        if (std::strcmp(ext, "html") == 0 || std::strcmp(ext, "htm") == 0)
-            return TEXT_HTML;
-        if (std::strcmp(ext, "txt") == 0)
-            return TEXT_PLAIN;
-        if (std::strcmp(ext, "css") == 0)
-            return TEXT_CSS;
-        if (std::strcmp(ext, "js") == 0)
-            return TEXT_JAVASCRIPT;
-        if (std::strcmp(ext, "xml") == 0)
-            return TEXT_XML;
-        if (std::strcmp(ext, "csv") == 0)
-            return TEXT_CSV;
-        if (std::strcmp(ext, "json") == 0)
-            return APPLICATION_JSON;
-        if (std::strcmp(ext, "pdf") == 0)
-            return APPLICATION_PDF;
-        if (std::strcmp(ext, "zip") == 0)
-            return APPLICATION_ZIP;
-        if (std::strcmp(ext, "png") == 0)
-            return IMAGE_PNG;
-        if (std::strcmp(ext, "jpg") == 0 || std::strcmp(ext, "jpeg") == 0)
-            return IMAGE_JPEG;
-        if (std::strcmp(ext, "gif") == 0)
-            return IMAGE_GIF;
-        if (std::strcmp(ext, "svg") == 0)
-            return IMAGE_SVG_XML;
-        if (std::strcmp(ext, "webp") == 0)
-            return IMAGE_WEBP;
-        if (std::strcmp(ext, "bmp") == 0)
-            return IMAGE_BMP;
-        if (std::strcmp(ext, "ico") == 0)
-            return IMAGE_ICO;
-        if (std::strcmp(ext, "mp4") == 0)
-            return VIDEO_MP4;
-        if (std::strcmp(ext, "mpeg") == 0 || std::strcmp(ext, "mpg") == 0)
-            return VIDEO_MPEG;
-        if (std::strcmp(ext, "webm") == 0)
-            return VIDEO_WEBM;
-        if (std::strcmp(ext, "mp3") == 0)
-            return AUDIO_MPEG;
-        if (std::strcmp(ext, "wav") == 0)
-            return AUDIO_WAV;
-        if (std::strcmp(ext, "ogg") == 0)
-            return AUDIO_OGG;
-        if (std::strcmp(ext, "woff") == 0)
-            return FONT_WOFF;
-        if (std::strcmp(ext, "woff2") == 0)
-            return FONT_WOFF2;
-        if (std::strcmp(ext, "ttf") == 0)
-            return FONT_TTF;
-        if (std::strcmp(ext, "otf") == 0)
-            return FONT_OTF;
-
-        return APPLICATION_OCTET_STREAM;
-    }
+        const char* extension;  // 小文字、先頭の '.' なし
+        Type type;
+    };
 
-    static ContentType fromExtension(const std::string& extension)
+    // 拡張子の昇順（strcmp 順）に並んだ組み込みの対応表
+    static const ExtensionEntry* extensionTable(size_t* count)
     {
-        return fromExtension(extension.c_str());
+        static const ExtensionEntry kTable[] = {
+            {"bmp", IMAGE_BMP},
+            {"css", TEXT_CSS},
+            {"csv", TEXT_CSV},
+            {"gif", IMAGE_GIF},
+            {"htm", TEXT_HTML},
+            {"html", TEXT_HTML},
+            {"ico", IMAGE_ICO},
+            {"jpeg", IMAGE_JPEG},
+            {"jpg", IMAGE_JPEG},
+            {"js", TEXT_JAVASCRIPT},
+            {"json", APPLICATION_JSON},
+            {"mp3", AUDIO_MPEG},
+            {"mp4", VIDEO_MP4},
+            {"mpeg", VIDEO_MPEG},
+            {"mpg", VIDEO_MPEG},
+            {"ogg", AUDIO_OGG},
+            {"otf", FONT_OTF},
+            {"pdf", APPLICATION_PDF},
+            {"png", IMAGE_PNG},
+            {"svg", IMAGE_SVG_XML},
+            {"ttf", FONT_TTF},
+            {"txt", TEXT_PLAIN},
+            {"wav", AUDIO_WAV},
+            {"webm", VIDEO_WEBM},
+            {"webp", IMAGE_WEBP},
+            {"woff", FONT_WOFF},
+            {"woff2", FONT_WOFF2},
+            {"xml", TEXT_XML},
+            {"zip", APPLICATION_ZIP},
+        };
+        *count = sizeof(kTable) / sizeof(kTable[0]);
+        return kTable;
     }
 
     // 8. デフォルト値の取得
@@ -0,0 +1,122 @@
+#include "http/fastcgi_record.hpp"
+
+namespace http
+{
+
+const size_t FastCgiRecord::kHeaderSize;
+const size_t FastCgiRecord::kMaxContentLength;
+const size_t FastCgiRecord::kEndRequestBodySize;
+
+namespace
+{
+
+const unsigned char kVersion1 = 1;
+const unsigned int kRoleResponder = 1;
+const unsigned char kFlagKeepConn = 1;
+
+}  // namespace
+
+void FastCgiRecord::appendHeader_(unsigned char type, unsigned int request_id,
+    size_t content_length, size_t padding_length, std::string* out)
+{
+    out->push_back(static_cast<char>(kVersion1));
+    out->push_back(static_cast<char>(type));
+    out->push_back(static_cast<char>((request_id >> 8) & 0xFF));
+    out->push_back(static_cast<char>(request_id & 0xFF));
+    out->push_back(static_cast<char>((content_length >> 8) & 0xFF));
+    out->push_back(static_cast<char>(content_length & 0xFF));
+    out->push_back(static_cast<char>(padding_length));
+    out->push_back('\0');  // reserved
+}
+
+// len <= kMaxContentLength であること
+void FastCgiRecord::appendRecord_(unsigned char type, unsigned int request_id,
+    const char* data, size_t len, std::string* out)
+{
+    const size_t padding = (8 - (len % 8)) % 8;
+    appendHeader_(type, request_id, len, padding, out);
+    if (len > 0)
+        out->append(data, len);
+    out->append(padding, '\0');
+}
+
+void FastCgiRecord::appendBeginRequest(
+    unsigned int request_id, bool keep_conn, std::string* out)
+{
+    char body[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    body[0] = static_cast<char>((kRoleResponder >> 8) & 0xFF);
+    body[1] = static_cast<char>(kRoleResponder & 0xFF);
+    body[2] = static_cast<char>(keep_conn ? kFlagKeepConn : 0);
+    appendRecord_(kBeginRequest, request_id, body, sizeof(body), out);
+}
+
+// 長さは 127 以下なら1バイト、それ以上は最上位ビットを立てた4バイト
+void FastCgiRecord::appendLength_(size_t len, std::string* out)
+{
+    if (len < 128)
+    {
+        out->push_back(static_cast<char>(len));
+        return;
+    }
+    out->push_back(static_cast<char>(((len >> 24) & 0x7F) | 0x80));
+    out->push_back(static_cast<char>((len >> 16) & 0xFF));
+    out->push_back(static_cast<char>((len >> 8) & 0xFF));
+    out->push_back(static_cast<char>(len & 0xFF));
+}
+
+void FastCgiRecord::appendParams(unsigned int request_id,
+    const std::map<std::string, std::string>& params, std::string* out)
+{
+    std::string pairs;
+    for (std::map<std::string, std::string>::const_iterator it =
+             params.begin();
+        it != params.end(); ++it)
+    {
+        appendLength_(it->first.size(), &pairs);
+        appendLength_(it->second.size(), &pairs);
+        pairs.append(it->first);
+        pairs.append(it->second);
+    }
+    // name-value pair はレコードをまたいでよい
+    appendStream(kParams, request_id, pairs.data(), pairs.size(), out);
+    appendStream(kParams, request_id, NULL, 0, out);
+}
+
+void FastCgiRecord::appendStream(Type type, unsigned int request_id,
+    const char* data, size_t len, std::string* out)
+{
+    if (len == 0)
+    {
+        appendRecord_(static_cast<unsigned char>(type), request_id, NULL, 0,
+            out);
+        return;
+    }
+    size_t pos = 0;
+    while (pos < len)
+    {
+        const size_t n =
+            (len - pos < kMaxContentLength) ? len - pos : kMaxContentLength;
+        appendRecord_(static_cast<unsigned char>(type), request_id, data + pos,
+            n, out);
+        pos += n;
+    }
+}
+
+bool FastCgiRecord::parseHeader(const char* data, size_t len, Header* out)
+{
+    if (len < kHeaderSize)
+        return false;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    out->type = p[1];
+    out->request_id = (static_cast<unsigned int>(p[2]) << 8) | p[3];
+    out->content_length = (static_cast<size_t>(p[4]) << 8) | p[5];
+    out->padding_length = p[6];
+    return true;
+}
+
+int FastCgiRecord::endRequestProtocolStatus(const char* content)
+{
+    return static_cast<unsigned char>(content[4]);
+}
+
+}  // namespace http
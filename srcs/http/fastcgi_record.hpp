@@ -0,0 +1,85 @@
+#ifndef HTTP_FASTCGI_RECORD_HPP_
+#define HTTP_FASTCGI_RECORD_HPP_
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace http
+{
+
+// FastCGI 1.0 のレコードの組み立てとヘッダの読み取り。
+// レコード = 8バイトのヘッダ + content + padding（8バイト境界に揃える）。
+class FastCgiRecord
+{
+   public:
+    enum Type
+    {
+        kBeginRequest = 1,
+        kAbortRequest = 2,
+        kEndRequest = 3,
+        kParams = 4,
+        kStdin = 5,
+        kStdout = 6,
+        kStderr = 7
+    };
+
+    // FCGI_END_REQUEST の protocolStatus
+    enum ProtocolStatus
+    {
+        kRequestComplete = 0,
+        kCantMpxConn = 1,
+        kOverloaded = 2,
+        kUnknownRole = 3
+    };
+
+    static const size_t kHeaderSize = 8;
+    static const size_t kMaxContentLength = 65535;
+    static const size_t kEndRequestBodySize = 8;
+
+    struct Header
+    {
+        unsigned char type;
+        unsigned int request_id;
+        size_t content_length;
+        size_t padding_length;
+
+        // ヘッダを含むレコード全体のバイト数
+        size_t recordSize() const
+        {
+            return kHeaderSize + content_length + padding_length;
+        }
+    };
+
+    // FCGI_BEGIN_REQUEST（role は Responder）
+    static void appendBeginRequest(
+        unsigned int request_id, bool keep_conn, std::string* out);
+    // FCGI_PARAMS を終端の空レコードまで
+    static void appendParams(unsigned int request_id,
+        const std::map<std::string, std::string>& params, std::string* out);
+    // FCGI_STDIN 等のストリーム。len == 0 ならストリーム終端の空レコード。
+    // kMaxContentLength を超える分は複数のレコードに分ける。
+    static void appendStream(Type type, unsigned int request_id,
+        const char* data, size_t len, std::string* out);
+
+    // len が kHeaderSize 未満なら false
+    static bool parseHeader(const char* data, size_t len, Header* out);
+    // FCGI_END_REQUEST の content から protocolStatus を取り出す
+    static int endRequestProtocolStatus(const char* content);
+
+   private:
+    static void appendHeader_(unsigned char type, unsigned int request_id,
+        size_t content_length, size_t padding_length, std::string* out);
+    static void appendRecord_(unsigned char type, unsigned int request_id,
+        const char* data, size_t len, std::string* out);
+    static void appendLength_(size_t len, std::string* out);
+
+    FastCgiRecord();
+    FastCgiRecord(const FastCgiRecord& rhs);
+    FastCgiRecord& operator=(const FastCgiRecord& rhs);
+    ~FastCgiRecord();
+};
+
+}  // namespace http
+
+#endif
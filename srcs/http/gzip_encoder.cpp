@@ -0,0 +1,694 @@
+#include "http/gzip_encoder.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace http
+{
+
+namespace
+{
+
+// RFC 1951 Section 3.2.5: 長さ符号 257..285 の基底値と拡張ビット数
+const unsigned short kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15,
+    17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227,
+    258};
+const unsigned char kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2,
+    2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// 距離符号 0..29 の基底値と拡張ビット数
+const unsigned short kDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49,
+    65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577};
+const unsigned char kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5,
+    6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// level ごとのハッシュチェイン探索の上限
+const size_t kMaxChainByLevel[10] = {
+    0, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+
+const unsigned int kEndOfBlock = 256;
+
+// リテラル/長さ符号と距離符号の数（RFC 1951 Section 3.2.5）
+const size_t kNumLitLen = 286;
+const size_t kNumDist = 30;
+// 符号長を符号化する符号（Section 3.2.7）
+const size_t kNumCodeLen = 19;
+const unsigned char kCodeLenOrder[kNumCodeLen] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+const int kMaxCodeBits = 15;
+const int kMaxCodeLenBits = 7;
+
+// この距離より遠い長さ3の一致は、リテラル3つより得にならないことが多い
+const size_t kTooFarForMinMatch = 4096;
+// 遅延一致の比較を省く一致長（十分長ければそのまま使う）
+const size_t kLazyGoodLength = 128;
+
+unsigned int hash3_(const utils::Byte* p)
+{
+    return ((static_cast<unsigned int>(p[0]) << 10) ^
+               (static_cast<unsigned int>(p[1]) << 5) ^
+               static_cast<unsigned int>(p[2])) &
+           ((1u << 15) - 1);
+}
+
+size_t lengthIndex_(size_t len)
+{
+    size_t li = 28;
+    while (kLengthBase[li] > len)
+        --li;
+    return li;
+}
+
+size_t distIndex_(size_t dist)
+{
+    size_t di = 29;
+    while (kDistBase[di] > dist)
+        --di;
+    return di;
+}
+
+// 出現回数から、limit ビット以下のハフマン符号長を求める。
+// 超えた場合は出現回数を均してから作り直す。
+void buildLengths_(
+    const unsigned long* freq, size_t n, int limit, unsigned char* out_lens)
+{
+    typedef std::pair<unsigned long, size_t> Node;
+    std::vector<unsigned long> f(freq, freq + n);
+    for (;;)
+    {
+        // 0..n-1 が葉、n 以降が内部ノード（親は必ず子より後に作られる）
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node> > q;
+        std::vector<size_t> parent(2 * n, 0);
+        for (size_t s = 0; s < n; ++s)
+        {
+            out_lens[s] = 0;
+            if (f[s] > 0)
+                q.push(Node(f[s], s));
+        }
+        if (q.empty())
+            return;
+        if (q.size() == 1)
+        {
+            out_lens[q.top().second] = 1;
+            return;
+        }
+
+        size_t next = n;
+        while (q.size() > 1)
+        {
+            const Node a = q.top();
+            q.pop();
+            const Node b = q.top();
+            q.pop();
+            parent[a.second] = next;
+            parent[b.second] = next;
+            q.push(Node(a.first + b.first, next));
+            ++next;
+        }
+
+        const size_t root = next - 1;
+        std::vector<int> depth(next, 0);
+        for (size_t node = root; node-- > n;)
+            depth[node] = depth[parent[node]] + 1;
+        int max_len = 0;
+        for (size_t s = 0; s < n; ++s)
+        {
+            if (f[s] == 0)
+                continue;
+            const int d = depth[parent[s]] + 1;
+            out_lens[s] = static_cast<unsigned char>(d);
+            if (d > max_len)
+                max_len = d;
+        }
+        if (max_len <= limit)
+            return;
+        for (size_t s = 0; s < n; ++s)
+        {
+            if (f[s] > 0)
+                f[s] = (f[s] >> 1) | 1;
+        }
+    }
+}
+
+// 符号長から正準ハフマン符号を作る（Section 3.2.2）。
+// 符号は MSB から詰めるので、putBits_ でそのまま書けるよう反転して持つ。
+void buildCodes_(const unsigned char* lens, size_t n, unsigned short* out_codes)
+{
+    unsigned int bl_count[kMaxCodeBits + 1] = {0};
+    for (size_t s = 0; s < n; ++s)
+        ++bl_count[lens[s]];
+    bl_count[0] = 0;
+
+    unsigned int next_code[kMaxCodeBits + 1] = {0};
+    unsigned int code = 0;
+    for (int bits = 1; bits <= kMaxCodeBits; ++bits)
+    {
+        code = (code + bl_count[bits - 1]) << 1;
+        next_code[bits] = code;
+    }
+
+    for (size_t s = 0; s < n; ++s)
+    {
+        out_codes[s] = 0;
+        if (lens[s] == 0)
+            continue;
+        unsigned int c = next_code[lens[s]]++;
+        unsigned int rev = 0;
+        for (int i = 0; i < lens[s]; ++i)
+        {
+            rev = (rev << 1) | (c & 1);
+            c >>= 1;
+        }
+        out_codes[s] = static_cast<unsigned short>(rev);
+    }
+}
+
+// Section 3.2.6: 固定ハフマン符号
+struct FixedCodes
+{
+    unsigned char lit_lens[288];
+    unsigned short lit_codes[288];
+    unsigned char dist_lens[kNumDist];
+    unsigned short dist_codes[kNumDist];
+};
+
+const FixedCodes& fixedCodes_()
+{
+    static FixedCodes codes;
+    static bool ready = false;
+    if (!ready)
+    {
+        for (size_t s = 0; s < 288; ++s)
+        {
+            codes.lit_lens[s] = (s <= 143)   ? 8
+                                : (s <= 255) ? 9
+                                : (s <= 279) ? 7
+                                             : 8;
+        }
+        buildCodes_(codes.lit_lens, 288, codes.lit_codes);
+        for (size_t s = 0; s < kNumDist; ++s)
+            codes.dist_lens[s] = 5;
+        buildCodes_(codes.dist_lens, kNumDist, codes.dist_codes);
+        ready = true;
+    }
+    return codes;
+}
+
+// 符号長の列を 16（直前の繰り返し）/ 17, 18（0 の繰り返し）で縮める。
+// first が符号、second が拡張ビットの値。
+void runLengthEncode_(const unsigned char* lens, size_t n,
+    std::vector<std::pair<unsigned char, unsigned char> >* out)
+{
+    typedef std::pair<unsigned char, unsigned char> Sym;
+    size_t i = 0;
+    while (i < n)
+    {
+        const unsigned char cur = lens[i];
+        size_t run = 1;
+        while (i + run < n && lens[i + run] == cur)
+            ++run;
+        i += run;
+
+        if (cur == 0)
+        {
+            while (run >= 11)
+            {
+                const size_t r = std::min<size_t>(run, 138);
+                out->push_back(Sym(18, static_cast<unsigned char>(r - 11)));
+                run -= r;
+            }
+            if (run >= 3)
+            {
+                out->push_back(Sym(17, static_cast<unsigned char>(run - 3)));
+                run = 0;
+            }
+        }
+        else
+        {
+            out->push_back(Sym(cur, 0));
+            --run;
+            while (run >= 3)
+            {
+                const size_t r = std::min<size_t>(run, 6);
+                out->push_back(Sym(16, static_cast<unsigned char>(r - 3)));
+                run -= r;
+            }
+        }
+        for (; run > 0; --run)
+            out->push_back(Sym(cur, 0));
+    }
+}
+
+int codeLenExtraBits_(unsigned char sym)
+{
+    return (sym == 16) ? 2 : (sym == 17) ? 3 : (sym == 18) ? 7 : 0;
+}
+
+}  // namespace
+
+const int GzipEncoder::kMinLevel;
+const int GzipEncoder::kMaxLevel;
+const size_t GzipEncoder::kWindowSize;
+const size_t GzipEncoder::kHashSize;
+const size_t GzipEncoder::kMinMatch;
+const size_t GzipEncoder::kMaxMatch;
+const size_t GzipEncoder::kMaxBlockTokens;
+const int GzipEncoder::kDynamicMinLevel;
+
+GzipEncoder::GzipEncoder(int level)
+    : max_chain_(0),
+      level_(level),
+      window_(),
+      window_base_(0),
+      head_(kHashSize, 0),
+      prev_(kWindowSize, 0),
+      tokens_(),
+      crc_(0),
+      total_in_(0),
+      bit_buf_(0),
+      bit_count_(0),
+      header_written_(false),
+      finished_(false)
+{
+    if (level_ < kMinLevel)
+        level_ = kMinLevel;
+    if (level_ > kMaxLevel)
+        level_ = kMaxLevel;
+    max_chain_ = kMaxChainByLevel[level_];
+    window_.reserve(2 * kWindowSize);
+    tokens_.reserve(kMaxBlockTokens);
+}
+
+GzipEncoder::~GzipEncoder() {}
+
+unsigned long GzipEncoder::crc32Update_(
+    unsigned long crc, const utils::Byte* data, size_t len)
+{
+    static unsigned long table[256];
+    static bool table_ready = false;
+    if (!table_ready)
+    {
+        for (unsigned long n = 0; n < 256; ++n)
+        {
+            unsigned long c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+            table[n] = c;
+        }
+        table_ready = true;
+    }
+
+    unsigned long c = crc ^ 0xFFFFFFFFUL;
+    for (size_t i = 0; i < len; ++i)
+        c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return (c ^ 0xFFFFFFFFUL) & 0xFFFFFFFFUL;
+}
+
+// RFC 1952 Section 2.3: 固定10バイトのヘッダ（ファイル名/時刻なし）
+void GzipEncoder::writeHeader_(std::vector<utils::Byte>* out)
+{
+    const utils::Byte xfl = (level_ == kMaxLevel)   ? 2
+                            : (level_ == kMinLevel) ? 4
+                                                    : 0;
+    const utils::Byte header[10] = {
+        0x1f, 0x8b, 8 /* deflate */, 0, 0, 0, 0, 0, xfl, 3 /* unix */};
+    out->insert(out->end(), header, header + sizeof(header));
+    header_written_ = true;
+}
+
+void GzipEncoder::putBits_(
+    unsigned long value, int nbits, std::vector<utils::Byte>* out)
+{
+    bit_buf_ |= value << bit_count_;
+    bit_count_ += nbits;
+    while (bit_count_ >= 8)
+    {
+        out->push_back(static_cast<utils::Byte>(bit_buf_ & 0xFF));
+        bit_buf_ >>= 8;
+        bit_count_ -= 8;
+    }
+}
+
+// トークン列と終端を、与えられたハフマン符号で書く
+void GzipEncoder::putTokens_(const unsigned char* lit_lens,
+    const unsigned short* lit_codes, const unsigned char* dist_lens,
+    const unsigned short* dist_codes, std::vector<utils::Byte>* out)
+{
+    for (size_t i = 0; i < tokens_.size(); ++i)
+    {
+        const Token& t = tokens_[i];
+        if (t.dist == 0)
+        {
+            putBits_(lit_codes[t.value], lit_lens[t.value], out);
+            continue;
+        }
+        const size_t li = lengthIndex_(t.value);
+        putBits_(lit_codes[257 + li], lit_lens[257 + li], out);
+        putBits_(static_cast<unsigned long>(t.value - kLengthBase[li]),
+            kLengthExtra[li], out);
+        const size_t di = distIndex_(t.dist);
+        putBits_(dist_codes[di], dist_lens[di], out);
+        putBits_(static_cast<unsigned long>(t.dist - kDistBase[di]),
+            kDistExtra[di], out);
+    }
+    putBits_(lit_codes[kEndOfBlock], lit_lens[kEndOfBlock], out);
+}
+
+void GzipEncoder::alignToByte_(std::vector<utils::Byte>* out)
+{
+    if (bit_count_ > 0)
+        out->push_back(static_cast<utils::Byte>(bit_buf_ & 0xFF));
+    bit_buf_ = 0;
+    bit_count_ = 0;
+}
+
+// 辞書として要るのは直近 kWindowSize バイトだけなので、後ろ側を先頭へ移す。
+// 領域が埋まったときだけ行うので、移動は kWindowSize バイトの入力ごとに1回。
+void GzipEncoder::slideWindow_()
+{
+    const size_t drop = window_.size() - kWindowSize;
+    std::copy(window_.begin() + static_cast<std::ptrdiff_t>(drop),
+        window_.end(), window_.begin());
+    window_.resize(kWindowSize);
+    window_base_ += static_cast<unsigned long>(drop);
+}
+
+void GzipEncoder::insertHash_(size_t index)
+{
+    const unsigned int h = hash3_(&window_[index]);
+    const unsigned long pos = window_base_ + index;
+    prev_[pos & (kWindowSize - 1)] = head_[h];
+    head_[h] = pos + 1;
+}
+
+// window_[index..end) の先頭と最長一致する過去の位置を探す
+size_t GzipEncoder::longestMatch_(
+    size_t index, size_t end, size_t* out_dist) const
+{
+    const unsigned long pos = window_base_ + index;
+    size_t max_len = end - index;
+    if (max_len > kMaxMatch)
+        max_len = kMaxMatch;
+
+    // 最適化なしビルドでも速度が落ちないよう、探索は生ポインタで行う
+    const utils::Byte* cur = &window_[index];
+    const unsigned long* prev = &prev_[0];
+    size_t best_len = 0;
+    unsigned long cand1 = head_[hash3_(cur)];
+    for (size_t chain = max_chain_; cand1 != 0 && chain > 0; --chain)
+    {
+        const unsigned long cand = cand1 - 1;
+        if (cand >= pos || pos - cand > kWindowSize || cand < window_base_)
+            break;
+
+        const utils::Byte* p = &window_[0] + (cand - window_base_);
+        if (p[best_len] == cur[best_len])
+        {
+            size_t l = 0;
+            while (l < max_len && p[l] == cur[l])
+                ++l;
+            if (l > best_len)
+            {
+                best_len = l;
+                *out_dist = static_cast<size_t>(pos - cand);
+                if (l == max_len)
+                    break;
+            }
+        }
+
+        // より新しい位置で上書き済みのスロットはチェインが切れている
+        const unsigned long next = prev[cand & (kWindowSize - 1)];
+        if (next == 0 || next - 1 >= cand)
+            break;
+        cand1 = next;
+    }
+    return best_len;
+}
+
+// window_[start..end) を LZ77 でトークンにする。
+// level 4 以上は遅延一致: 1つ先の位置でより長く一致するなら、今の位置は
+// リテラルにして先の一致を使う。
+void GzipEncoder::compress_(
+    size_t start, size_t end, std::vector<utils::Byte>* out)
+{
+    const bool lazy = (level_ >= kDynamicMinLevel);
+    bool has_next = false;
+    size_t next_len = 0;
+    size_t next_dist = 0;
+
+    size_t i = start;
+    while (i < end)
+    {
+        size_t match_len = 0;
+        size_t match_dist = 0;
+        if (end - i >= kMinMatch)
+        {
+            if (has_next)
+            {
+                match_len = next_len;
+                match_dist = next_dist;
+            }
+            else
+            {
+                match_len = longestMatch_(i, end, &match_dist);
+            }
+            insertHash_(i);
+            if (match_len == kMinMatch && match_dist > kTooFarForMinMatch)
+                match_len = 0;
+        }
+        has_next = false;
+
+        if (lazy && match_len >= kMinMatch && match_len < kLazyGoodLength &&
+            end - (i + 1) >= kMinMatch)
+        {
+            next_len = longestMatch_(i + 1, end, &next_dist);
+            has_next = true;
+            if (next_len > match_len)
+            {
+                pushLiteral_(window_[i], out);
+                ++i;
+                continue;
+            }
+        }
+
+        if (match_len >= kMinMatch)
+        {
+            pushMatch_(match_len, match_dist, out);
+            for (size_t k = 1; k < match_len; ++k)
+            {
+                if (end - (i + k) >= kMinMatch)
+                    insertHash_(i + k);
+            }
+            i += match_len;
+            has_next = false;
+        }
+        else
+        {
+            pushLiteral_(window_[i], out);
+            ++i;
+        }
+    }
+}
+
+void GzipEncoder::pushLiteral_(utils::Byte lit, std::vector<utils::Byte>* out)
+{
+    Token t;
+    t.value = lit;
+    t.dist = 0;
+    tokens_.push_back(t);
+    if (tokens_.size() >= kMaxBlockTokens)
+        flushBlock_(out);
+}
+
+void GzipEncoder::pushMatch_(
+    size_t len, size_t dist, std::vector<utils::Byte>* out)
+{
+    Token t;
+    t.value = static_cast<unsigned short>(len);
+    t.dist = static_cast<unsigned short>(dist);
+    tokens_.push_back(t);
+    if (tokens_.size() >= kMaxBlockTokens)
+        flushBlock_(out);
+}
+
+// 貯めたトークンを1ブロック（BFINAL=0）として書く。
+// 固定ハフマンと動的ハフマンのビット数を見積もり、小さい方を使う。
+void GzipEncoder::flushBlock_(std::vector<utils::Byte>* out)
+{
+    if (tokens_.empty())
+        return;
+
+    unsigned long lit_freq[kNumLitLen] = {0};
+    unsigned long dist_freq[kNumDist] = {0};
+    unsigned long extra_bits = 0;
+    for (size_t i = 0; i < tokens_.size(); ++i)
+    {
+        const Token& t = tokens_[i];
+        if (t.dist == 0)
+        {
+            ++lit_freq[t.value];
+            continue;
+        }
+        const size_t li = lengthIndex_(t.value);
+        const size_t di = distIndex_(t.dist);
+        ++lit_freq[257 + li];
+        ++dist_freq[di];
+        extra_bits += kLengthExtra[li] + kDistExtra[di];
+    }
+    lit_freq[kEndOfBlock] = 1;
+
+    const FixedCodes& fixed = fixedCodes_();
+    unsigned long fixed_bits = 3 + extra_bits;
+    for (size_t s = 0; s < kNumLitLen; ++s)
+        fixed_bits += lit_freq[s] * fixed.lit_lens[s];
+    for (size_t s = 0; s < kNumDist; ++s)
+        fixed_bits += dist_freq[s] * fixed.dist_lens[s];
+
+    if (level_ >= kDynamicMinLevel)
+    {
+        // 符号長（リテラル/長さ と 距離 を続けた列）
+        unsigned char lens[kNumLitLen + kNumDist];
+        unsigned char* lit_lens = lens;
+        buildLengths_(lit_freq, kNumLitLen, kMaxCodeBits, lit_lens);
+        unsigned char dist_lens[kNumDist];
+        buildLengths_(dist_freq, kNumDist, kMaxCodeBits, dist_lens);
+        // 距離符号が1つも無くても、長さ1の符号を1つ送る（Section 3.2.7）
+        size_t ndist = kNumDist;
+        while (ndist > 1 && dist_lens[ndist - 1] == 0)
+            --ndist;
+        if (dist_lens[0] == 0 && ndist == 1)
+            dist_lens[0] = 1;
+        size_t nlit = kNumLitLen;
+        while (nlit > 257 && lit_lens[nlit - 1] == 0)
+            --nlit;
+        for (size_t s = 0; s < ndist; ++s)
+            lens[nlit + s] = dist_lens[s];
+
+        std::vector<std::pair<unsigned char, unsigned char> > rle;
+        runLengthEncode_(lens, nlit + ndist, &rle);
+
+        unsigned long cl_freq[kNumCodeLen] = {0};
+        for (size_t i = 0; i < rle.size(); ++i)
+            ++cl_freq[rle[i].first];
+        // 1種類だけの符号長符号は不完全な符号になるので、もう1つ足しておく
+        size_t cl_used = 0;
+        for (size_t s = 0; s < kNumCodeLen; ++s)
+            cl_used += (cl_freq[s] > 0) ? 1 : 0;
+        if (cl_used < 2)
+            ++cl_freq[(cl_freq[0] > 0) ? 1 : 0];
+        unsigned char cl_lens[kNumCodeLen];
+        buildLengths_(cl_freq, kNumCodeLen, kMaxCodeLenBits, cl_lens);
+        size_t ncl = kNumCodeLen;
+        while (ncl > 4 && cl_lens[kCodeLenOrder[ncl - 1]] == 0)
+            --ncl;
+
+        unsigned long dynamic_bits = 3 + 5 + 5 + 4 + 3 * ncl + extra_bits;
+        for (size_t i = 0; i < rle.size(); ++i)
+        {
+            dynamic_bits +=
+                cl_lens[rle[i].first] + codeLenExtraBits_(rle[i].first);
+        }
+        for (size_t s = 0; s < nlit; ++s)
+            dynamic_bits += lit_freq[s] * lit_lens[s];
+        for (size_t s = 0; s < ndist; ++s)
+            dynamic_bits += dist_freq[s] * dist_lens[s];
+
+        if (dynamic_bits < fixed_bits)
+        {
+            unsigned short lit_codes[kNumLitLen];
+            unsigned short dist_codes[kNumDist];
+            unsigned short cl_codes[kNumCodeLen];
+            buildCodes_(lit_lens, nlit, lit_codes);
+            buildCodes_(dist_lens, ndist, dist_codes);
+            buildCodes_(cl_lens, kNumCodeLen, cl_codes);
+
+            // BFINAL=0, BTYPE=10(動的ハフマン)
+            putBits_(0, 1, out);
+            putBits_(2, 2, out);
+            putBits_(static_cast<unsigned long>(nlit - 257), 5, out);
+            putBits_(static_cast<unsigned long>(ndist - 1), 5, out);
+            putBits_(static_cast<unsigned long>(ncl - 4), 4, out);
+            for (size_t i = 0; i < ncl; ++i)
+                putBits_(cl_lens[kCodeLenOrder[i]], 3, out);
+            for (size_t i = 0; i < rle.size(); ++i)
+            {
+                const unsigned char sym = rle[i].first;
+                putBits_(cl_codes[sym], cl_lens[sym], out);
+                putBits_(rle[i].second, codeLenExtraBits_(sym), out);
+            }
+            putTokens_(lit_lens, lit_codes, dist_lens, dist_codes, out);
+            tokens_.clear();
+            return;
+        }
+    }
+
+    // BFINAL=0, BTYPE=01(固定ハフマン)
+    putBits_(0, 1, out);
+    putBits_(1, 2, out);
+    putTokens_(fixed.lit_lens, fixed.lit_codes, fixed.dist_lens,
+        fixed.dist_codes, out);
+    tokens_.clear();
+}
+
+void GzipEncoder::update(
+    const utils::Byte* data, size_t len, std::vector<utils::Byte>* out)
+{
+    if (finished_ || data == NULL || len == 0)
+        return;
+    if (!header_written_)
+        writeHeader_(out);
+
+    crc_ = crc32Update_(crc_, data, len);
+    total_in_ += static_cast<unsigned long>(len);
+
+    // 領域（2 * kWindowSize）に収まる分ずつ積んで圧縮する
+    size_t consumed = 0;
+    while (consumed < len)
+    {
+        if (window_.size() >= 2 * kWindowSize)
+            slideWindow_();
+        size_t n = 2 * kWindowSize - window_.size();
+        if (n > len - consumed)
+            n = len - consumed;
+        const size_t start = window_.size();
+        window_.insert(window_.end(), data + consumed, data + consumed + n);
+        compress_(start, window_.size(), out);
+        consumed += n;
+    }
+    flushBlock_(out);
+
+    // sync flush: 空の非圧縮ブロックでバイト境界に揃える
+    putBits_(0, 1, out);
+    putBits_(0, 2, out);
+    alignToByte_(out);
+    const utils::Byte empty_stored[4] = {0x00, 0x00, 0xFF, 0xFF};
+    out->insert(out->end(), empty_stored, empty_stored + 4);
+}
+
+void GzipEncoder::finish(std::vector<utils::Byte>* out)
+{
+    if (finished_)
+        return;
+    if (!header_written_)
+        writeHeader_(out);
+
+    // BFINAL=1, BTYPE=01 の空ブロック
+    const FixedCodes& fixed = fixedCodes_();
+    putBits_(1, 1, out);
+    putBits_(1, 2, out);
+    putBits_(fixed.lit_codes[kEndOfBlock], fixed.lit_lens[kEndOfBlock], out);
+    alignToByte_(out);
+
+    // RFC 1952: CRC32 と ISIZE（いずれも little endian）
+    for (int i = 0; i < 4; ++i)
+        out->push_back(static_cast<utils::Byte>((crc_ >> (8 * i)) & 0xFF));
+    for (int i = 0; i < 4; ++i)
+        out->push_back(
+            static_cast<utils::Byte>((total_in_ >> (8 * i)) & 0xFF));
+    finished_ = true;
+}
+
+}  // namespace http
@@ -0,0 +1,99 @@
+#ifndef HTTP_GZIP_ENCODER_HPP_
+#define HTTP_GZIP_ENCODER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "utils/data_type.hpp"
+
+namespace http
+{
+
+// gzip (RFC 1952) のストリーミング圧縮器。
+// deflate (RFC 1951) は LZ77（ハッシュチェイン）+ ハフマン符号。
+// - ブロックごとに固定ハフマンと動的ハフマンの小さい方で書く
+//   （動的ハフマンと遅延一致は level 4 以上。level 1〜3 は固定のみで速度優先）。
+// - update() ごとに sync flush するので、それまでに渡した入力は
+//   受信側で即座に復元できる（CGI の逐次出力向け）。
+// - 直近 32KiB を辞書として保持し、update() をまたいだ一致も使う。
+//   辞書は 64KiB の領域に積み、埋まったときだけ後半を前へ移す。
+class GzipEncoder
+{
+   public:
+    static const int kMinLevel = 1;
+    static const int kMaxLevel = 9;
+
+    // level: 1(速い)〜9(よく縮む)。範囲外は丸める。
+    explicit GzipEncoder(int level);
+    ~GzipEncoder();
+
+    // data を圧縮して out に追記する
+    void update(
+        const utils::Byte* data, size_t len, std::vector<utils::Byte>* out);
+    // 最終ブロックと trailer（CRC32 / 入力長）を out に追記する
+    void finish(std::vector<utils::Byte>* out);
+
+   private:
+    static const size_t kWindowSize = 32768;
+    static const size_t kHashSize = 1 << 15;
+    static const size_t kMinMatch = 3;
+    static const size_t kMaxMatch = 258;
+    // 1ブロックに貯めるトークン数の上限
+    static const size_t kMaxBlockTokens = 16384;
+    static const int kDynamicMinLevel = 4;
+
+    // LZ77 の出力1つ。dist == 0 ならリテラル（value は値）、
+    // それ以外は一致（value は長さ）
+    struct Token
+    {
+        unsigned short value;
+        unsigned short dist;
+    };
+
+    size_t max_chain_;
+    int level_;
+
+    // 辞書（直近 kWindowSize バイト以上）+ 今回の入力。容量は 2 * kWindowSize
+    std::vector<utils::Byte> window_;
+    // window_[0] のストリーム先頭からの位置
+    unsigned long window_base_;
+    // hash -> 最後に現れた位置 + 1（0 は「なし」）
+    std::vector<unsigned long> head_;
+    // (位置 & (kWindowSize-1)) -> 同じ hash の1つ前の位置 + 1
+    std::vector<unsigned long> prev_;
+    std::vector<Token> tokens_;
+
+    unsigned long crc_;
+    unsigned long total_in_;
+    unsigned long bit_buf_;
+    int bit_count_;
+    bool header_written_;
+    bool finished_;
+
+    void writeHeader_(std::vector<utils::Byte>* out);
+    void slideWindow_();
+    void insertHash_(size_t index);
+    size_t longestMatch_(size_t index, size_t end, size_t* out_dist) const;
+    void compress_(size_t start, size_t end, std::vector<utils::Byte>* out);
+    void pushLiteral_(utils::Byte lit, std::vector<utils::Byte>* out);
+    void pushMatch_(
+        size_t len, size_t dist, std::vector<utils::Byte>* out);
+    void flushBlock_(std::vector<utils::Byte>* out);
+
+    void putBits_(unsigned long value, int nbits, std::vector<utils::Byte>* out);
+    void putTokens_(const unsigned char* lit_lens,
+        const unsigned short* lit_codes, const unsigned char* dist_lens,
+        const unsigned short* dist_codes, std::vector<utils::Byte>* out);
+    void alignToByte_(std::vector<utils::Byte>* out);
+
+    static unsigned long crc32Update_(
+        unsigned long crc, const utils::Byte* data, size_t len);
+
+    GzipEncoder();
+    GzipEncoder(const GzipEncoder& rhs);
+    GzipEncoder& operator=(const GzipEncoder& rhs);
+};
+
+}  // namespace http
+
+#endif
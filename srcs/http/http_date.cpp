@@ -0,0 +1,29 @@
+#include "http/http_date.hpp"
+
+#include "http/syntax.hpp"
+#include "utils/timestamp.hpp"
+
+namespace http
+{
+
+long HttpDate::cached_epoch_seconds_ = -1;
+std::string HttpDate::cached_line_;
+
+void HttpDate::update(long epoch_seconds)
+{
+    if (epoch_seconds == cached_epoch_seconds_)
+        return;
+    cached_epoch_seconds_ = epoch_seconds;
+    cached_line_ = "Date: ";
+    cached_line_ += utils::Timestamp::formatHttpDate(epoch_seconds);
+    cached_line_ += HttpSyntax::kCrlf;
+}
+
+const std::string& HttpDate::headerLine()
+{
+    if (cached_epoch_seconds_ < 0)
+        update(utils::Timestamp::nowEpochSeconds());
+    return cached_line_;
+}
+
+}  // namespace http
@@ -0,0 +1,34 @@
+#ifndef HTTP_HTTP_DATE_HPP_
+#define HTTP_HTTP_DATE_HPP_
+
+#include <string>
+
+namespace http
+{
+
+// レスポンスの Date ヘッダー行（"Date: <IMF-fixdate>\r\n"）のキャッシュ。
+// - Date は秒精度なので、イベントループが update() で秒が変わったときだけ
+//   整形し直し、エンコーダは headerLine() をそのまま連結する。
+// - シングルスレッド前提（同期はしない）。
+class HttpDate
+{
+   public:
+    // epoch_seconds が前回と同じなら何もしない
+    static void update(long epoch_seconds);
+
+    // 一度も update() されていなければ現在時刻で初期化する
+    static const std::string& headerLine();
+
+   private:
+    static long cached_epoch_seconds_;
+    static std::string cached_line_;
+
+    HttpDate();
+    HttpDate(const HttpDate& other);
+    HttpDate& operator=(const HttpDate& other);
+    ~HttpDate();
+};
+
+}  // namespace http
+
+#endif
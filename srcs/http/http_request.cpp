@@ -216,6 +216,7 @@ HttpRequest::HttpRequest()
       content_type_params_(),
       body_framing_(kNoBody),
       decoded_body_bytes_(0),
+      content_length_(0),
       content_length_remaining_(0),
       chunk_phase_(kChunkSizeLine),
       chunk_bytes_remaining_(0),
@@ -242,6 +243,7 @@ HttpRequest::HttpRequest(const HttpRequest& rhs)
       content_type_params_(rhs.content_type_params_),
       body_framing_(rhs.body_framing_),
       decoded_body_bytes_(rhs.decoded_body_bytes_),
+      content_length_(rhs.content_length_),
       content_length_remaining_(rhs.content_length_remaining_),
       chunk_phase_(rhs.chunk_phase_),
       chunk_bytes_remaining_(rhs.chunk_bytes_remaining_),
@@ -268,6 +270,7 @@ HttpRequest& HttpRequest::operator=(const HttpRequest& rhs)
         phase_ = rhs.phase_;
         parse_error_status_ = rhs.parse_error_status_;
         body_framing_ = rhs.body_framing_;
+        content_length_ = rhs.content_length_;
         content_length_remaining_ = rhs.content_length_remaining_;
         cursor_ = rhs.cursor_;
         leading_empty_lines_ = rhs.leading_empty_lines_;
@@ -338,10 +341,72 @@ bool HttpRequest::isChunkedEncoding() const
     return body_framing_ == kChunked;
 }
 
+// "q=0", "q=0.0" 等、重みが 0（=拒否）かどうか
+static bool isZeroQuality_(const std::string& params)
+{
+    std::string::size_type pos = 0;
+    while (pos < params.size())
+    {
+        std::string::size_type semi = params.find(';', pos);
+        if (semi == std::string::npos)
+            semi = params.size();
+        const std::string p = trimOws_(params.substr(pos, semi - pos));
+        pos = semi + 1;
+        if (p.size() < 2 || (p[0] != 'q' && p[0] != 'Q') || p[1] != '=')
+            continue;
+        const std::string v = p.substr(2);
+        if (v.empty() || v[0] != '0')
+            return false;
+        for (size_t i = 1; i < v.size(); ++i)
+        {
+            if (v[i] != '0' && v[i] != '.')
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool HttpRequest::acceptsContentCoding(
+    const std::string& coding_lowercase) const
+{
+    HeaderMap::const_iterator it = headers_.find("Accept-Encoding");
+    if (it == headers_.end())
+        return false;
+
+    std::vector<std::string> items;
+    splitCommaSeparatedValues(it->second, items);
+
+    bool has_wildcard = false;
+    bool wildcard_accepts = false;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const std::string::size_type semi = items[i].find(';');
+        const std::string name =
+            toLowerAscii(trimOws_(items[i].substr(0, semi)));
+        const std::string params = (semi == std::string::npos)
+                                       ? std::string()
+                                       : items[i].substr(semi + 1);
+        if (name == coding_lowercase)
+            return !isZeroQuality_(params);
+        if (name == "*")
+        {
+            has_wildcard = true;
+            wildcard_accepts = !isZeroQuality_(params);
+        }
+    }
+    return has_wildcard && wildcard_accepts;
+}
+
 bool HttpRequest::hasBody() const { return body_framing_ != kNoBody; }
 
 size_t HttpRequest::getDecodedBodyBytes() const { return decoded_body_bytes_; }
 
+unsigned long HttpRequest::getContentLength() const
+{
+    return (body_framing_ == kContentLength) ? content_length_ : 0;
+}
+
 ContentType HttpRequest::getContentType() const { return content_type_; }
 
 bool HttpRequest::hasContentTypeParam(const std::string& key_lowercase) const
@@ -677,6 +742,7 @@ Result<void> HttpRequest::validateHeaders(bool skip_body_size_check)
     }
 
     body_framing_ = kNoBody;
+    content_length_ = 0;
     content_length_remaining_ = 0;
 
     // Keep-Alive 判定
@@ -820,6 +886,7 @@ Result<void> HttpRequest::validateHeaders(bool skip_body_size_check)
             }
         }
 
+        content_length_ = first;
         content_length_remaining_ = first;
         if (!skip_body_size_check)
         {
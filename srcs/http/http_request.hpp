@@ -90,8 +90,14 @@ class HttpRequest
         const std::string& name) const;
     bool hasHeader(const std::string& name) const;
     bool isChunkedEncoding() const;
+
+    // Accept-Encoding (RFC 9110 Section 12.5.3)
+    // coding_lowercase が q>0 で受理されるか。明示が無ければ "*" に従う。
+    bool acceptsContentCoding(const std::string& coding_lowercase) const;
     bool hasBody() const;
     size_t getDecodedBodyBytes() const;
+    // Content-Length で宣言されたボディ長（chunked/ボディなしは 0）
+    unsigned long getContentLength() const;
 
     // Content-Type
     // headers の Content-Type をパースした結果を返す。
@@ -170,6 +176,7 @@ class HttpRequest
     size_t decoded_body_bytes_;
 
     // content-lengthタイプの管理
+    unsigned long content_length_;
     unsigned long content_length_remaining_;
 
     // chunkタイプの実デコード管理
@@ -16,6 +16,7 @@ HttpResponse::HttpResponse()
       status_(HttpStatus::OK),
       reason_phrase_(HttpStatus(HttpStatus::OK).getMessage()),
       headers_(),
+      preformatted_headers_(NULL),
       has_expected_content_length_(false),
       expected_content_length_(0)
 {
@@ -28,6 +29,7 @@ HttpResponse::HttpResponse(HttpStatus status)
       status_(status),
       reason_phrase_(status.getMessage()),
       headers_(),
+      preformatted_headers_(NULL),
       has_expected_content_length_(false),
       expected_content_length_(0)
 {
@@ -40,6 +42,7 @@ HttpResponse::HttpResponse(const HttpResponse& rhs)
       status_(rhs.status_),
       reason_phrase_(rhs.reason_phrase_),
       headers_(rhs.headers_),
+      preformatted_headers_(rhs.preformatted_headers_),
       has_expected_content_length_(rhs.has_expected_content_length_),
       expected_content_length_(rhs.expected_content_length_)
 {
@@ -55,6 +58,7 @@ HttpResponse& HttpResponse::operator=(const HttpResponse& rhs)
     status_ = rhs.status_;
     reason_phrase_ = rhs.reason_phrase_;
     headers_ = rhs.headers_;
+    preformatted_headers_ = rhs.preformatted_headers_;
     has_expected_content_length_ = rhs.has_expected_content_length_;
     expected_content_length_ = rhs.expected_content_length_;
     return *this;
@@ -69,6 +73,7 @@ void HttpResponse::reset()
     status_ = HttpStatus::OK;
     reason_phrase_ = HttpStatus(HttpStatus::OK).getMessage();
     headers_.clear();
+    preformatted_headers_ = NULL;
     has_expected_content_length_ = false;
     expected_content_length_ = 0;
     setDefault();
@@ -172,6 +177,20 @@ Result<const std::vector<std::string>&> HttpResponse::getHeader(
 
 const HeaderMap& HttpResponse::getHeaders() const { return headers_; }
 
+Result<void> HttpResponse::setPreformattedHeaders(const std::string* block)
+{
+    Result<void> ok = ensureHeaderEditable_();
+    if (!ok.isOk())
+        return ok;
+    preformatted_headers_ = block;
+    return Result<void>();
+}
+
+const std::string* HttpResponse::preformattedHeaders() const
+{
+    return preformatted_headers_;
+}
+
 void HttpResponse::setDefault()
 {
     setHeader(
@@ -60,6 +60,13 @@ class HttpResponse
     const HeaderMap& getHeaders() const;
     void setDefault();
 
+    // 事前整形済みのヘッダー行（"Name: value\r\n" の連結）。
+    // エンコーダが HeaderMap を経由せずそのまま連結する
+    // （送出は 2xx/3xx の一部ステータスのみ。HttpResponseEncoder 参照）。
+    // block の実体は呼び出し側（設定由来の長寿命オブジェクト）が保持すること。
+    Result<void> setPreformattedHeaders(const std::string* block);
+    const std::string* preformattedHeaders() const;
+
     // Content-Length（あれば保持）
     bool hasExpectedContentLength() const;
     unsigned long expectedContentLength() const;
@@ -80,6 +87,7 @@ class HttpResponse
     HttpStatus status_;
     std::string reason_phrase_;
     HeaderMap headers_;
+    const std::string* preformatted_headers_;  // 非所有（NULL なら無し）
 
     bool has_expected_content_length_;
     unsigned long expected_content_length_;
@@ -3,6 +3,7 @@
 #include <sstream>
 
 #include "http/header.hpp"
+#include "http/http_date.hpp"
 #include "http/syntax.hpp"
 
 namespace http
@@ -157,6 +158,10 @@ Result<std::vector<utils::Byte> > HttpResponseEncoder::encodeHeader(
         }
     }
 
+    // Date（CGI 等が自前で付けていればそちらを優先する）
+    if (headers.find(HeaderName(HeaderName::DATE).toString()) == headers.end())
+        appendString_(out, HttpDate::headerLine());
+
     // Headers
     for (HeaderMap::const_iterator it = headers.begin(); it != headers.end();
         ++it)
@@ -172,6 +177,12 @@ Result<std::vector<utils::Byte> > HttpResponseEncoder::encodeHeader(
         }
     }
 
+    // location の add_header 等、事前整形済みのヘッダー行
+    const std::string* preformatted = response.preformattedHeaders();
+    if (preformatted != NULL &&
+        isPreformattedHeaderStatus_(response.getStatus()))
+        appendString_(out, *preformatted);
+
     // End of headers
     appendCrlf_(out);
 
@@ -193,50 +204,62 @@ Result<std::vector<utils::Byte> > HttpResponseEncoder::encodeHeader(
 
 Result<std::vector<utils::Byte> > HttpResponseEncoder::encodeBodyChunk(
     HttpResponse& response, const utils::Byte* data, size_t len)
+{
+    if (data == NULL && len != 0)
+        return Result<std::vector<utils::Byte> >(ERROR, "invalid body pointer");
+
+    std::vector<utils::Byte> out;
+    std::vector<utils::Byte> suffix;
+    Result<bool> framed = encodeBodyFrame(response, len, &out, &suffix);
+    if (framed.isError())
+        return Result<std::vector<utils::Byte> >(
+            ERROR, framed.getErrorMessage());
+    if (!framed.unwrap())
+        return std::vector<utils::Byte>();
+
+    out.insert(out.end(), data, data + len);
+    out.insert(out.end(), suffix.begin(), suffix.end());
+    return out;
+}
+
+Result<bool> HttpResponseEncoder::encodeBodyFrame(HttpResponse& response,
+    size_t len, std::vector<utils::Byte>* out_prefix,
+    std::vector<utils::Byte>* out_suffix)
 {
     decide_(response);
 
+    out_prefix->clear();
+    out_suffix->clear();
+
     if (response.isComplete())
-        return std::vector<utils::Byte>();
+        return false;
 
     if (body_mode_ == kNoBody)
     {
         if (len == 0)
-            return std::vector<utils::Byte>();
-        return Result<std::vector<utils::Byte> >(ERROR, "body is not allowed");
+            return false;
+        return Result<bool>(ERROR, "body is not allowed");
     }
 
-    if (data == NULL && len != 0)
-        return Result<std::vector<utils::Byte> >(ERROR, "invalid body pointer");
-
     if (body_mode_ == kContentLength)
     {
         const unsigned long after =
             body_bytes_sent_ + static_cast<unsigned long>(len);
         if (after > expected_content_length_)
-            return Result<std::vector<utils::Byte> >(
-                ERROR, "body exceeds Content-Length");
+            return Result<bool>(ERROR, "body exceeds Content-Length");
         body_bytes_sent_ = after;
-
-        std::vector<utils::Byte> out;
-        out.insert(out.end(), data, data + len);
-        return out;
+        return true;
     }
 
     if (body_mode_ == kChunked)
     {
-        std::vector<utils::Byte> out;
-        const std::string head = toHex_(len) + HttpSyntax::kCrlf;
-        appendString_(out, head);
-        out.insert(out.end(), data, data + len);
-        appendCrlf_(out);
-        return out;
+        appendString_(*out_prefix, toHex_(len) + HttpSyntax::kCrlf);
+        appendCrlf_(*out_suffix);
+        return true;
     }
 
-    // close-delimited: そのまま
-    std::vector<utils::Byte> out;
-    out.insert(out.end(), data, data + len);
-    return out;
+    // close-delimited: 枠なし
+    return true;
 }
 
 Result<std::vector<utils::Byte> > HttpResponseEncoder::encodeEof(
@@ -277,6 +300,27 @@ bool HttpResponseEncoder::isBodyForbiddenStatus_(HttpStatus status)
     return false;
 }
 
+// add_header と同じく、成功/リダイレクト系のレスポンスにだけ付ける
+bool HttpResponseEncoder::isPreformattedHeaderStatus_(HttpStatus status)
+{
+    switch (status.toInt())
+    {
+        case 200:
+        case 201:
+        case 204:
+        case 206:
+        case 301:
+        case 302:
+        case 303:
+        case 304:
+        case 307:
+        case 308:
+            return true;
+        default:
+            return false;
+    }
+}
+
 std::string HttpResponseEncoder::reasonOrDefault_(const HttpResponse& response)
 {
     const std::string& r = response.getReasonPhrase();
@@ -44,6 +44,12 @@ class HttpResponseEncoder
     Result<std::vector<utils::Byte> > encodeHeader(HttpResponse& response);
     Result<std::vector<utils::Byte> > encodeBodyChunk(
         HttpResponse& response, const utils::Byte* data, size_t len);
+    // encodeBodyChunk と同じ検査・計上を行い、len バイトの body の前後に
+    // 付ける枠（chunked のサイズ行と CRLF）だけを返す。body 本体は呼び出し側が
+    // 直接書き込む。false の場合は body を書き込まない（送信済みなど）。
+    Result<bool> encodeBodyFrame(HttpResponse& response, size_t len,
+        std::vector<utils::Byte>* out_prefix,
+        std::vector<utils::Byte>* out_suffix);
     Result<std::vector<utils::Byte> > encodeEof(HttpResponse& response);
 
     BodyMode bodyMode() const;
@@ -60,6 +66,7 @@ class HttpResponseEncoder
 
     void decide_(HttpResponse& response);
     static bool isBodyForbiddenStatus_(HttpStatus status);
+    static bool isPreformattedHeaderStatus_(HttpStatus status);
     static std::string reasonOrDefault_(const HttpResponse& response);
 
     static void appendString_(
@@ -0,0 +1,100 @@
+#include "http/mime_types.hpp"
+
+#include <cctype>
+
+#include "http/content_types.hpp"
+
+namespace http
+{
+
+MimeTypes::MimeTypes()
+    : entries_(), default_type_(ContentType::getDefault().c_str())
+{
+    size_t count = 0;
+    const ContentType::ExtensionEntry* table =
+        ContentType::extensionTable(&count);
+    entries_.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        Entry e;
+        e.extension = table[i].extension;
+        e.mime_type = ContentType(table[i].type).c_str();
+        entries_.push_back(e);
+    }
+}
+
+MimeTypes::~MimeTypes() {}
+
+// a (長さ a_len, 大文字可) と小文字の b を比較する
+int MimeTypes::compareLower_(const char* a, size_t a_len, const std::string& b)
+{
+    const size_t n = (a_len < b.size()) ? a_len : b.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        const unsigned char ca = static_cast<unsigned char>(
+            std::tolower(static_cast<unsigned char>(a[i])));
+        const unsigned char cb = static_cast<unsigned char>(b[i]);
+        if (ca != cb)
+            return static_cast<int>(ca) - static_cast<int>(cb);
+    }
+    if (a_len == b.size())
+        return 0;
+    return (a_len < b.size()) ? -1 : 1;
+}
+
+const MimeTypes::Entry* MimeTypes::find_(
+    const char* extension, size_t len) const
+{
+    size_t lo = 0;
+    size_t hi = entries_.size();
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        const int cmp = compareLower_(extension, len, entries_[mid].extension);
+        if (cmp == 0)
+            return &entries_[mid];
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return NULL;
+}
+
+// 起動時にしか呼ばれないので、挿入位置を探して並びを保つだけでよい
+void MimeTypes::add(const std::string& extension, const std::string& mime_type)
+{
+    std::string lower = extension;
+    for (size_t i = 0; i < lower.size(); ++i)
+        lower[i] = static_cast<char>(
+            std::tolower(static_cast<unsigned char>(lower[i])));
+
+    std::vector<Entry>::iterator it = entries_.begin();
+    while (it != entries_.end() && it->extension < lower)
+        ++it;
+    if (it != entries_.end() && it->extension == lower)
+    {
+        it->mime_type = mime_type;
+        return;
+    }
+    Entry e;
+    e.extension = lower;
+    e.mime_type = mime_type;
+    entries_.insert(it, e);
+}
+
+const std::string& MimeTypes::lookupPath(const std::string& path) const
+{
+    // 最後の '/' より後ろにある最後の '.' 以降（部分文字列は作らない）
+    const std::string::size_type slash = path.find_last_of('/');
+    const std::string::size_type dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+        return default_type_;
+    if (slash != std::string::npos && dot < slash)
+        return default_type_;
+
+    const Entry* e = find_(path.data() + dot + 1, path.size() - dot - 1);
+    return (e != NULL) ? e->mime_type : default_type_;
+}
+
+}  // namespace http
@@ -0,0 +1,44 @@
+#ifndef HTTP_MIME_TYPES_HPP_
+#define HTTP_MIME_TYPES_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace http
+{
+
+// 拡張子 -> MIME type の対応表。
+// - ContentType の組み込み表で初期化し、設定の types {} で追加/上書きする。
+// - 起動時に組み上げた後は、拡張子の昇順に並んだ配列を二分探索するだけ。
+// - 拡張子は大文字小文字を区別しない。
+class MimeTypes
+{
+   public:
+    MimeTypes();
+    ~MimeTypes();
+
+    // extension は先頭の '.' なし
+    void add(const std::string& extension, const std::string& mime_type);
+
+    // path の拡張子に対応する MIME type。
+    // 拡張子が無い/未知の場合は application/octet-stream。
+    const std::string& lookupPath(const std::string& path) const;
+
+   private:
+    struct Entry
+    {
+        std::string extension;  // 小文字
+        std::string mime_type;
+    };
+
+    std::vector<Entry> entries_;
+    std::string default_type_;
+
+    const Entry* find_(const char* extension, size_t len) const;
+    static int compareLower_(const char* a, size_t a_len, const std::string& b);
+};
+
+}  // namespace http
+
+#endif
@@ -21,6 +21,7 @@ class HttpStatus
         CREATED = 201,
         ACCEPTED = 202,
         NO_CONTENT = 204,
+        PARTIAL_CONTENT = 206,
         MULTIPLE_CHOICES = 300,
         MOVED_PERMANENTLY = 301,
         FOUND = 302,
@@ -38,6 +39,7 @@ class HttpStatus
         REQUEST_TIMEOUT = 408,
         PAYLOAD_TOO_LARGE = 413,
         URI_TOO_LONG = 414,
+        RANGE_NOT_SATISFIABLE = 416,
         SERVER_ERROR = 500,
         NOT_IMPLEMENTED = 501,
         BAD_GATEWAY = 502,
@@ -109,6 +111,8 @@ class HttpStatus
                 return "Accepted";
             case NO_CONTENT:
                 return "No Content";
+            case PARTIAL_CONTENT:
+                return "Partial Content";
             case MULTIPLE_CHOICES:
                 return "Multiple Choices";
             case MOVED_PERMANENTLY:
@@ -143,6 +147,8 @@ class HttpStatus
                 return "Payload Too Large";
             case URI_TOO_LONG:
                 return "URI Too Long";
+            case RANGE_NOT_SATISFIABLE:
+                return "Range Not Satisfiable";
             case SERVER_ERROR:
                 return "Internal Server Error";
             case NOT_IMPLEMENTED:
@@ -241,6 +247,8 @@ class HttpStatus
                 return ACCEPTED;
             case 204:
                 return NO_CONTENT;
+            case 206:
+                return PARTIAL_CONTENT;
             case 300:
                 return MULTIPLE_CHOICES;
             case 301:
@@ -275,6 +283,8 @@ class HttpStatus
                 return PAYLOAD_TOO_LARGE;
             case 414:
                 return URI_TOO_LONG;
+            case 416:
+                return RANGE_NOT_SATISFIABLE;
             case 500:
                 return SERVER_ERROR;
             case 501:
@@ -0,0 +1,52 @@
+#ifndef WEBSERV_BLOCKING_TASK_HPP_
+#define WEBSERV_BLOCKING_TASK_HPP_
+
+#include <string>
+
+namespace server
+{
+
+// BlockingTaskPool のワーカーで実行する、ディスク I/O 等のブロッキング処理。
+// - run() はワーカースレッドで呼ばれる。イベントループ側のオブジェクト
+//   （セッション、キャッシュ、ログ等）には触れず、必要なものは
+//   コンストラクタでコピー/所有しておくこと。
+// - complete() と Waiter への通知はイベントループのスレッドで呼ばれる。
+class BlockingTask
+{
+   public:
+    // 完了通知の受け手
+    class Waiter
+    {
+       public:
+        virtual ~Waiter() {}
+        virtual void onBlockingTaskDone(BlockingTask& task) = 0;
+    };
+
+    BlockingTask() : waiter_(NULL), error_() {}
+    virtual ~BlockingTask() {}
+
+    virtual void run() = 0;
+    // 結果をイベントループ側へ反映する（Waiter への通知の前に呼ぶ）
+    virtual void complete() {}
+
+    // 受け手が先に破棄される場合は NULL に戻す（通知されなくなる）
+    void setWaiter(Waiter* waiter) { waiter_ = waiter; }
+    Waiter* waiter() const { return waiter_; }
+
+    bool hasError() const { return !error_.empty(); }
+    const std::string& errorMessage() const { return error_; }
+
+   protected:
+    void setError_(const std::string& message) { error_ = message; }
+
+   private:
+    Waiter* waiter_;
+    std::string error_;
+
+    BlockingTask(const BlockingTask& rhs);
+    BlockingTask& operator=(const BlockingTask& rhs);
+};
+
+}  // namespace server
+
+#endif
@@ -0,0 +1,251 @@
+#include "server/blocking_task/blocking_task_pool.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace server
+{
+
+using namespace utils::result;
+
+namespace
+{
+
+class CloseFdTask : public BlockingTask
+{
+   public:
+    explicit CloseFdTask(int fd) : fd_(fd) {}
+    virtual ~CloseFdTask()
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    virtual void run()
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+   private:
+    int fd_;
+};
+
+bool setNonBlockingCloexec_(int fd)
+{
+    const int fl = ::fcntl(fd, F_GETFL, 0);
+    if (fl < 0 || ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0)
+        return false;
+    return ::fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+}  // namespace
+
+BlockingTaskPool::BlockingTaskPool()
+    : queue_(),
+      done_(),
+      threads_(),
+      stopping_(false),
+      wake_read_fd_(-1),
+      wake_write_fd_(-1)
+{
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&cond_, NULL);
+}
+
+BlockingTaskPool::~BlockingTaskPool()
+{
+    stop();
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mutex_);
+}
+
+Result<void> BlockingTaskPool::openWakeFds_()
+{
+#ifdef __linux__
+    const int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd >= 0)
+    {
+        wake_read_fd_ = efd;
+        wake_write_fd_ = efd;
+        return Result<void>();
+    }
+#endif
+    int fds[2];
+    if (::pipe(fds) != 0)
+        return Result<void>(ERROR, "pipe() failed");
+    if (!setNonBlockingCloexec_(fds[0]) || !setNonBlockingCloexec_(fds[1]))
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return Result<void>(ERROR, "fcntl() failed");
+    }
+    wake_read_fd_ = fds[0];
+    wake_write_fd_ = fds[1];
+    return Result<void>();
+}
+
+void BlockingTaskPool::closeWakeFds_()
+{
+    if (wake_write_fd_ >= 0 && wake_write_fd_ != wake_read_fd_)
+        ::close(wake_write_fd_);
+    if (wake_read_fd_ >= 0)
+        ::close(wake_read_fd_);
+    wake_read_fd_ = -1;
+    wake_write_fd_ = -1;
+}
+
+Result<void> BlockingTaskPool::start(int worker_count)
+{
+    if (isRunning())
+        return Result<void>();
+    if (worker_count <= 0)
+        return Result<void>(ERROR, "invalid worker count");
+
+    Result<void> w = openWakeFds_();
+    if (w.isError())
+        return w;
+
+    // シグナルはメインスレッド（epoll_wait 中）で受けたいので、
+    // ワーカーは全シグナルをブロックした状態で起動する。
+    sigset_t all;
+    sigset_t saved;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+
+    stopping_ = false;
+    for (int i = 0; i < worker_count; ++i)
+    {
+        pthread_t th;
+        if (pthread_create(&th, NULL, &BlockingTaskPool::workerMain_, this) !=
+            0)
+            break;
+        threads_.push_back(th);
+    }
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+    if (threads_.empty())
+    {
+        closeWakeFds_();
+        return Result<void>(ERROR, "pthread_create() failed");
+    }
+    return Result<void>();
+}
+
+void BlockingTaskPool::stop()
+{
+    pthread_mutex_lock(&mutex_);
+    stopping_ = true;
+    pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&mutex_);
+
+    for (size_t i = 0; i < threads_.size(); ++i)
+        pthread_join(threads_[i], NULL);
+    threads_.clear();
+
+    for (size_t i = 0; i < queue_.size(); ++i)
+        delete queue_[i];
+    queue_.clear();
+    for (size_t i = 0; i < done_.size(); ++i)
+        delete done_[i];
+    done_.clear();
+
+    closeWakeFds_();
+}
+
+Result<void> BlockingTaskPool::submit(BlockingTask* task)
+{
+    if (task == NULL)
+        return Result<void>(ERROR, "null task");
+    if (!isRunning())
+        return Result<void>(ERROR, "blocking task pool is not running");
+
+    pthread_mutex_lock(&mutex_);
+    queue_.push_back(task);
+    pthread_cond_signal(&cond_);
+    pthread_mutex_unlock(&mutex_);
+    return Result<void>();
+}
+
+void BlockingTaskPool::takeCompleted(std::vector<BlockingTask*>* out)
+{
+    drainWake_();
+    pthread_mutex_lock(&mutex_);
+    out->insert(out->end(), done_.begin(), done_.end());
+    done_.clear();
+    pthread_mutex_unlock(&mutex_);
+}
+
+void BlockingTaskPool::closeInBackground(int fd)
+{
+    if (fd < 0)
+        return;
+    CloseFdTask* task = new CloseFdTask(fd);
+    if (submit(task).isError())
+        delete task;  // その場で close する
+}
+
+void BlockingTaskPool::wake_()
+{
+    // 溢れ（EAGAIN）は未読の通知が残っているだけなので無視してよい
+    if (wake_write_fd_ == wake_read_fd_)
+    {
+        const uint64_t one = 1;
+        (void)::write(wake_write_fd_, &one, sizeof(one));
+    }
+    else
+    {
+        const char one = 1;
+        (void)::write(wake_write_fd_, &one, sizeof(one));
+    }
+}
+
+void BlockingTaskPool::drainWake_()
+{
+    if (wake_read_fd_ < 0)
+        return;
+    char buf[64];
+    for (;;)
+    {
+        const ssize_t n = ::read(wake_read_fd_, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+    }
+}
+
+void* BlockingTaskPool::workerMain_(void* arg)
+{
+    static_cast<BlockingTaskPool*>(arg)->workerLoop_();
+    return NULL;
+}
+
+void BlockingTaskPool::workerLoop_()
+{
+    pthread_mutex_lock(&mutex_);
+    for (;;)
+    {
+        while (queue_.empty() && !stopping_)
+            pthread_cond_wait(&cond_, &mutex_);
+        if (stopping_)
+            break;
+
+        BlockingTask* task = queue_.front();
+        queue_.pop_front();
+        pthread_mutex_unlock(&mutex_);
+
+        task->run();
+
+        pthread_mutex_lock(&mutex_);
+        done_.push_back(task);
+        wake_();
+    }
+    pthread_mutex_unlock(&mutex_);
+}
+
+}  // namespace server
@@ -0,0 +1,71 @@
+#ifndef WEBSERV_BLOCKING_TASK_POOL_HPP_
+#define WEBSERV_BLOCKING_TASK_POOL_HPP_
+
+#include <pthread.h>
+
+#include <deque>
+#include <vector>
+
+#include "server/blocking_task/blocking_task.hpp"
+#include "utils/result.hpp"
+
+namespace server
+{
+using utils::result::Result;
+
+// イベントループを止めないためのブロッキング処理用ワーカープール。
+// - submit() したタスクはワーカーで run() され、完了すると completionFd()
+//   が読み込み可能になる（Linux は eventfd、それ以外は pipe）。
+// - イベントループ側は takeCompleted() で完了済みタスクを受け取り、
+//   complete() / Waiter への通知 / delete を行う。
+// - ワーカーが起動していない場合 submit() はエラーを返すので、
+//   呼び出し側はその場で実行する。
+class BlockingTaskPool
+{
+   public:
+    static const int kDefaultWorkerCount = 4;
+
+    BlockingTaskPool();
+    ~BlockingTaskPool();
+
+    Result<void> start(int worker_count);
+    // 実行中のタスクの終了を待ってワーカーを止める（未実行のタスクは破棄）
+    void stop();
+    bool isRunning() const { return !threads_.empty(); }
+
+    int completionFd() const { return wake_read_fd_; }
+
+    // 所有権を引き取る。完了後は takeCompleted() で返す。
+    Result<void> submit(BlockingTask* task);
+    void takeCompleted(std::vector<BlockingTask*>* out);
+
+    // fd の close をワーカーで行う。unlink 済みの巨大ファイルは最後の
+    // close でブロックの解放が走るため、ループでは閉じない。
+    void closeInBackground(int fd);
+
+   private:
+    pthread_mutex_t mutex_;
+    pthread_cond_t cond_;
+    std::deque<BlockingTask*> queue_;
+    std::vector<BlockingTask*> done_;
+    std::vector<pthread_t> threads_;
+    bool stopping_;
+
+    int wake_read_fd_;
+    int wake_write_fd_;  // eventfd の場合は wake_read_fd_ と同じ
+
+    BlockingTaskPool(const BlockingTaskPool& rhs);
+    BlockingTaskPool& operator=(const BlockingTaskPool& rhs);
+
+    Result<void> openWakeFds_();
+    void closeWakeFds_();
+    void wake_();
+    void drainWake_();
+
+    static void* workerMain_(void* arg);
+    void workerLoop_();
+};
+
+}  // namespace server
+
+#endif
@@ -1,5 +1,8 @@
 #include "server/config/location_directive_conf.hpp"
 
+#include <cctype>
+
+#include "http/syntax.hpp"
 #include "utils/path.hpp"
 #include "utils/result.hpp"
 
@@ -28,6 +31,70 @@ static Result<void> validateNonEmptyToken_(
     return Result<void>();
 }
 
+// RFC 9110 Section 5.1: field-name = token
+static bool isValidHeaderName_(const std::string& name)
+{
+    if (name.empty())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(name[i]);
+        if (!std::isalnum(c) &&
+            http::HttpSyntax::kTcharsWithoutAlnum.find(static_cast<char>(c)) ==
+                std::string::npos)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// RFC 9110 Section 5.5: 制御文字（HTAB を除く）は不可
+static bool isValidHeaderValue_(const std::string& value)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if ((c < 0x20 && c != '\t') || c == 0x7f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isReservedHeaderName_(const std::string& name)
+{
+    static const char* const kReserved[] = {
+        "Content-Length", "Transfer-Encoding", "Connection", "Date"};
+    for (size_t i = 0; i < sizeof(kReserved) / sizeof(kReserved[0]); ++i)
+    {
+        const std::string reserved(kReserved[i]);
+        if (reserved.size() != name.size())
+        {
+            continue;
+        }
+        size_t j = 0;
+        while (j < name.size() &&
+               std::tolower(static_cast<unsigned char>(name[j])) ==
+                   std::tolower(static_cast<unsigned char>(reserved[j])))
+        {
+            ++j;
+        }
+        if (j == name.size())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 static bool isValidRedirectTarget_(const std::string& target)
 {
     if (target.empty() || containsNul_(target))
@@ -54,17 +121,35 @@ static bool isValidUriOrUrlTarget_(const std::string& target)
     return isValidRedirectTarget_(target);
 }
 
+CgiWorkerPoolConf::CgiWorkerPoolConf()
+    : min_workers(kDefaultMinWorkers),
+      max_workers(kDefaultMaxWorkers),
+      max_requests(kDefaultMaxRequests),
+      idle_timeout_sec(kDefaultIdleTimeoutSec)
+{
+}
+
 LocationDirectiveConf::LocationDirectiveConf()
     : client_max_body_size(http::HttpRequest::kDefaultMaxBodyBytes),
+      gzip_min_length(kDefaultGzipMinLength),
+      file_cache_max_size(0),
+      client_body_buffer_size(kDefaultClientBodyBufferSize),
+      cgi_max_concurrency(0),
       index_pages(),
       path_pattern(),
       root_dir(),
       redirect_url(),
       upload_store(),
+      client_body_temp_path(),
+      fastcgi_pass(),
+      cgi_worker_pool(),
       allowed_methods(),
       cgi_extensions(),
       error_pages(),
+      gzip_types(),
+      add_headers(),
       redirect_status(http::HttpStatus::UNKNOWN),
+      gzip_comp_level(kDefaultGzipCompLevel),
       is_backward_search(false),
       has_allowed_methods(false),
       has_client_max_body_size(false),
@@ -72,7 +157,19 @@ LocationDirectiveConf::LocationDirectiveConf()
       has_index_pages(false),
       has_error_pages(false),
       auto_index(false),
-      has_auto_index(false)
+      has_auto_index(false),
+      gzip_static(false),
+      has_gzip_static(false),
+      gzip(false),
+      has_gzip(false),
+      cgi_request_buffering(true),
+      has_cgi_request_buffering(false),
+      has_gzip_min_length(false),
+      has_gzip_comp_level(false),
+      has_file_cache_max_size(false),
+      has_client_body_buffer_size(false),
+      has_cgi_worker_pool(false),
+      has_cgi_max_concurrency(false)
 {
 }
 
@@ -224,6 +321,114 @@ Result<void> LocationDirectiveConf::setAutoIndex(bool auto_index)
     return Result<void>();
 }
 
+Result<void> LocationDirectiveConf::setGzipStatic(bool gzip_static)
+{
+    if (has_gzip_static)
+    {
+        return Result<void>(ERROR, "directive is duplicate: gzip_static");
+    }
+    has_gzip_static = true;
+    this->gzip_static = gzip_static;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setGzip(bool gzip)
+{
+    if (has_gzip)
+    {
+        return Result<void>(ERROR, "directive is duplicate: gzip");
+    }
+    has_gzip = true;
+    this->gzip = gzip;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setGzipMinLength(unsigned long length)
+{
+    if (has_gzip_min_length)
+    {
+        return Result<void>(ERROR, "directive is duplicate: gzip_min_length");
+    }
+    has_gzip_min_length = true;
+    gzip_min_length = length;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setFileCacheMaxSize(unsigned long size)
+{
+    if (has_file_cache_max_size)
+    {
+        return Result<void>(
+            ERROR, "directive is duplicate: file_cache_max_size");
+    }
+    has_file_cache_max_size = true;
+    file_cache_max_size = size;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setClientBodyBufferSize(unsigned long size)
+{
+    if (has_client_body_buffer_size)
+    {
+        return Result<void>(
+            ERROR, "directive is duplicate: client_body_buffer_size");
+    }
+    has_client_body_buffer_size = true;
+    client_body_buffer_size = size;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::appendAddHeader(
+    const std::string& name, const std::string& value)
+{
+    if (!isValidHeaderName_(name))
+    {
+        return Result<void>(ERROR, "add_header name is invalid: " + name);
+    }
+    // メッセージの枠組みはエンコーダが決めるので上書きさせない
+    if (isReservedHeaderName_(name))
+    {
+        return Result<void>(ERROR, "add_header cannot set: " + name);
+    }
+    if (!isValidHeaderValue_(value))
+    {
+        return Result<void>(ERROR, "add_header value is invalid: " + value);
+    }
+    add_headers.push_back(std::make_pair(name, value));
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setGzipCompLevel(unsigned long level)
+{
+    if (has_gzip_comp_level)
+    {
+        return Result<void>(ERROR, "directive is duplicate: gzip_comp_level");
+    }
+    if (level < 1 || level > 9)
+    {
+        return Result<void>(ERROR, "gzip_comp_level must be 1-9");
+    }
+    has_gzip_comp_level = true;
+    gzip_comp_level = static_cast<int>(level);
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::appendGzipType(const std::string& mime_type)
+{
+    if (mime_type.empty() || mime_type.find('/') == std::string::npos)
+    {
+        return Result<void>(ERROR, "gzip_types is invalid: " + mime_type);
+    }
+    std::string lower = mime_type;
+    for (size_t i = 0; i < lower.size(); ++i)
+    {
+        lower[i] = static_cast<char>(
+            std::tolower(static_cast<unsigned char>(lower[i])));
+    }
+    gzip_types.insert(lower);
+    return Result<void>();
+}
+
 Result<void> LocationDirectiveConf::setRedirect(
     http::HttpStatus status, const std::string& redirect_url_str)
 {
@@ -275,6 +480,157 @@ Result<void> LocationDirectiveConf::setUploadStore(
     return Result<void>();
 }
 
+Result<void> LocationDirectiveConf::setClientBodyTempPath(
+    const std::string& path_str)
+{
+    if (!this->client_body_temp_path.empty())
+    {
+        return Result<void>(
+            ERROR, "directive is duplicate: client_body_temp_path");
+    }
+    Result<void> v = validateNonEmptyToken_(path_str,
+        "client_body_temp_path is empty", "client_body_temp_path contains NUL");
+    if (v.isError())
+    {
+        return v;
+    }
+    Result<PhysicalPath> resolved = PhysicalPath::resolve(path_str);
+    if (resolved.isError())
+    {
+        return Result<void>(ERROR, "client_body_temp_path is invalid");
+    }
+    this->client_body_temp_path = resolved.unwrap();
+    return Result<void>();
+}
+
+// "unix:/path" か "host:port"（host は IPv4 アドレスか localhost）
+static bool isValidFastCgiAddress_(const std::string& address)
+{
+    if (address.compare(0, 5, "unix:") == 0)
+        return address.size() > 5;
+
+    const std::string::size_type colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0 ||
+        colon + 1 == address.size())
+        return false;
+    const std::string host = address.substr(0, colon);
+    const std::string port = address.substr(colon + 1);
+
+    unsigned long port_num = 0;
+    for (std::string::size_type i = 0; i < port.size(); ++i)
+    {
+        if (port[i] < '0' || port[i] > '9' || port_num > 65535)
+            return false;
+        port_num = port_num * 10 + static_cast<unsigned long>(port[i] - '0');
+    }
+    if (port_num == 0 || port_num > 65535)
+        return false;
+
+    if (host == "localhost")
+        return true;
+    int dots = 0;
+    unsigned long octet = 0;
+    bool has_digit = false;
+    for (std::string::size_type i = 0; i < host.size(); ++i)
+    {
+        if (host[i] == '.')
+        {
+            if (!has_digit)
+                return false;
+            ++dots;
+            octet = 0;
+            has_digit = false;
+            continue;
+        }
+        if (host[i] < '0' || host[i] > '9')
+            return false;
+        octet = octet * 10 + static_cast<unsigned long>(host[i] - '0');
+        if (octet > 255)
+            return false;
+        has_digit = true;
+    }
+    return dots == 3 && has_digit;
+}
+
+Result<void> LocationDirectiveConf::setFastCgiPass(const std::string& address)
+{
+    if (!this->fastcgi_pass.empty())
+    {
+        return Result<void>(ERROR, "directive is duplicate: fastcgi_pass");
+    }
+    if (has_cgi_worker_pool)
+    {
+        return Result<void>(
+            ERROR, "fastcgi_pass cannot be used with cgi_worker_pool");
+    }
+    Result<void> v = validateNonEmptyToken_(
+        address, "fastcgi_pass is empty", "fastcgi_pass contains NUL");
+    if (v.isError())
+    {
+        return v;
+    }
+    if (!isValidFastCgiAddress_(address))
+    {
+        return Result<void>(ERROR, "fastcgi_pass address is invalid");
+    }
+    this->fastcgi_pass = address;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setCgiWorkerPool(
+    const CgiWorkerPoolConf& pool)
+{
+    if (has_cgi_worker_pool)
+    {
+        return Result<void>(ERROR, "directive is duplicate: cgi_worker_pool");
+    }
+    if (!this->fastcgi_pass.empty())
+    {
+        return Result<void>(
+            ERROR, "cgi_worker_pool cannot be used with fastcgi_pass");
+    }
+    if (pool.max_workers == 0 ||
+        pool.max_workers > CgiWorkerPoolConf::kMaxWorkersLimit)
+    {
+        return Result<void>(ERROR, "cgi_worker_pool max is out of range");
+    }
+    if (pool.min_workers > pool.max_workers)
+    {
+        return Result<void>(ERROR, "cgi_worker_pool min is greater than max");
+    }
+    has_cgi_worker_pool = true;
+    cgi_worker_pool = pool;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setCgiMaxConcurrency(unsigned long max)
+{
+    if (has_cgi_max_concurrency)
+    {
+        return Result<void>(
+            ERROR, "directive is duplicate: cgi_max_concurrency");
+    }
+    if (max == 0)
+    {
+        return Result<void>(ERROR, "cgi_max_concurrency must be positive");
+    }
+    has_cgi_max_concurrency = true;
+    cgi_max_concurrency = max;
+    return Result<void>();
+}
+
+Result<void> LocationDirectiveConf::setCgiRequestBuffering(bool buffering)
+{
+    if (has_cgi_request_buffering)
+    {
+        return Result<void>(
+            ERROR, "directive is duplicate: cgi_request_buffering");
+    }
+    has_cgi_request_buffering = true;
+    cgi_request_buffering = buffering;
+    return Result<void>();
+}
+
 bool LocationDirectiveConf::isValid() const
 {
     if (client_max_body_size > INT_MAX)
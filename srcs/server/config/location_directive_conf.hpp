@@ -5,6 +5,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "http/http_method.hpp"
@@ -16,23 +17,69 @@
 namespace server
 {
 using utils::result::Result;
+
+// cgi_worker_pool ディレクティブの設定。
+// cgi_extension の executor を FastCGI ワーカとして常駐させる。
+// executor は fd 0 に渡された listen ソケットで FastCGI を話せること
+// （例: php-cgi）。話せない executor はワーカが起動直後に終了するため、
+// 何度か続くとプールを無効にしてリクエストごとの起動に戻る。
+struct CgiWorkerPoolConf
+{
+    static const unsigned long kDefaultMinWorkers = 1;
+    static const unsigned long kDefaultMaxWorkers = 4;
+    static const unsigned long kDefaultMaxRequests = 500;
+    static const unsigned long kDefaultIdleTimeoutSec = 60;
+    static const unsigned long kMaxWorkersLimit = 256;
+
+    unsigned long min_workers;
+    unsigned long max_workers;
+    // ワーカ1つに処理させるリクエスト数の上限（0 は無制限）
+    unsigned long max_requests;
+    // min_workers を超えるワーカを止めるまでのアイドル秒数
+    unsigned long idle_timeout_sec;
+
+    CgiWorkerPoolConf();
+};
+
 // serverディレクティブ内のlocationディレクティブの情報
 struct LocationDirectiveConf
 {
     typedef std::map<CgiExt, FilePath> CgiExtensionsMap;
 
+    static const unsigned long kDefaultGzipMinLength = 20;
+    static const int kDefaultGzipCompLevel = 1;
+    static const unsigned long kDefaultClientBodyBufferSize = 16 * 1024;
+
     // clang-tidy(performance.Padding) 対応: パディングを減らすため並び順を調整
     unsigned long client_max_body_size;
+    unsigned long gzip_min_length;  // これ未満の Content-Length は圧縮しない
+    // これ以下のサイズの静的ファイルは内容をメモリにキャッシュする（0 は無効）
+    unsigned long file_cache_max_size;
+    // これ以下のリクエストボディは一時ファイルを作らずメモリに保持する
+    unsigned long client_body_buffer_size;
+    // この location の CGI の同時実行数の上限（0 は無制限）
+    unsigned long cgi_max_concurrency;
     std::vector<FileName> index_pages;
     URIPath path_pattern;
     FilePath root_dir;
     TargetURI redirect_url;  // returnディレクティブで指定されたURL
     FilePath upload_store;   // upload_storeディレクティブで指定された保存先
+    // リクエストボディの一時ファイルを作るディレクトリ（空なら /tmp）
+    FilePath client_body_temp_path;
+    // cgi_extension に一致したリクエストの送り先 FastCGI サーバ
+    // （"unix:/path" または "host:port"）。空なら executor を fork/exec する
+    std::string fastcgi_pass;
+    CgiWorkerPoolConf cgi_worker_pool;
     std::set<http::HttpMethod> allowed_methods;
     CgiExtensionsMap cgi_extensions;
     ErrorPagesMap error_pages;
+    // 圧縮対象の MIME type（text/html は常に対象）
+    std::set<std::string> gzip_types;
+    // add_header で指定された (名前, 値)。設定順に送出する
+    std::vector<std::pair<std::string, std::string> > add_headers;
     http::HttpStatus
         redirect_status;  // returnディレクティブで指定されたステータス
+    int gzip_comp_level;
     bool is_backward_search;
     bool has_allowed_methods;
     bool has_client_max_body_size;
@@ -41,6 +88,21 @@ struct LocationDirectiveConf
     bool has_error_pages;
     bool auto_index;  // ディレクトリ内ファイル一覧ページを有効にするかどうか
     bool has_auto_index;
+    // 事前圧縮済みファイル（.gz/.br）を優先して返すかどうか
+    bool gzip_static;
+    bool has_gzip_static;
+    // レスポンスを送出時に gzip 圧縮するかどうか
+    bool gzip;
+    bool has_gzip;
+    // off なら CGI をヘッダ受信時点で起動し、ボディは届いた順に stdin へ流す
+    bool cgi_request_buffering;
+    bool has_cgi_request_buffering;
+    bool has_gzip_min_length;
+    bool has_gzip_comp_level;
+    bool has_file_cache_max_size;
+    bool has_client_body_buffer_size;
+    bool has_cgi_worker_pool;
+    bool has_cgi_max_concurrency;
 
     // デフォルト値での初期化
     LocationDirectiveConf();
@@ -57,9 +119,23 @@ struct LocationDirectiveConf
     Result<void> appendErrorPage(
         http::HttpStatus status, const std::string& page_url_str);
     Result<void> setAutoIndex(bool auto_index);
+    Result<void> setGzipStatic(bool gzip_static);
+    Result<void> setGzip(bool gzip);
+    Result<void> setGzipMinLength(unsigned long length);
+    Result<void> setGzipCompLevel(unsigned long level);
+    Result<void> appendGzipType(const std::string& mime_type);
+    Result<void> setFileCacheMaxSize(unsigned long size);
+    Result<void> setClientBodyBufferSize(unsigned long size);
+    Result<void> appendAddHeader(
+        const std::string& name, const std::string& value);
     Result<void> setRedirect(
         http::HttpStatus status, const std::string& redirect_url_str);
     Result<void> setUploadStore(const std::string& upload_store_str);
+    Result<void> setClientBodyTempPath(const std::string& path_str);
+    Result<void> setFastCgiPass(const std::string& address);
+    Result<void> setCgiWorkerPool(const CgiWorkerPoolConf& pool);
+    Result<void> setCgiMaxConcurrency(unsigned long max);
+    Result<void> setCgiRequestBuffering(bool buffering);
 
     // バリデーション（データの整合性チェック）
     bool isValid() const;
@@ -70,6 +70,69 @@ class LocationDirectiveConfMaker
         return conf_.setAutoIndex(auto_index);
     }
 
+    Result<void> setGzipStatic(bool gzip_static)
+    {
+        return conf_.setGzipStatic(gzip_static);
+    }
+
+    Result<void> setGzip(bool gzip) { return conf_.setGzip(gzip); }
+
+    Result<void> setGzipMinLength(unsigned long length)
+    {
+        return conf_.setGzipMinLength(length);
+    }
+
+    Result<void> setGzipCompLevel(unsigned long level)
+    {
+        return conf_.setGzipCompLevel(level);
+    }
+
+    Result<void> setFileCacheMaxSize(unsigned long size)
+    {
+        return conf_.setFileCacheMaxSize(size);
+    }
+
+    Result<void> setClientBodyTempPath(const std::string& path)
+    {
+        return conf_.setClientBodyTempPath(path);
+    }
+
+    Result<void> setFastCgiPass(const std::string& address)
+    {
+        return conf_.setFastCgiPass(address);
+    }
+
+    Result<void> setCgiWorkerPool(const CgiWorkerPoolConf& pool)
+    {
+        return conf_.setCgiWorkerPool(pool);
+    }
+
+    Result<void> setCgiMaxConcurrency(unsigned long max)
+    {
+        return conf_.setCgiMaxConcurrency(max);
+    }
+
+    Result<void> setCgiRequestBuffering(bool buffering)
+    {
+        return conf_.setCgiRequestBuffering(buffering);
+    }
+
+    Result<void> setClientBodyBufferSize(unsigned long size)
+    {
+        return conf_.setClientBodyBufferSize(size);
+    }
+
+    Result<void> appendAddHeader(
+        const std::string& name, const std::string& value)
+    {
+        return conf_.appendAddHeader(name, value);
+    }
+
+    Result<void> appendGzipType(const std::string& mime_type)
+    {
+        return conf_.appendGzipType(mime_type);
+    }
+
     Result<void> setRedirect(
         http::HttpStatus status, const std::string& redirect_url)
     {
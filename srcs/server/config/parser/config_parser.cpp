@@ -51,41 +51,50 @@ static Result<unsigned long> parseUnsignedLong_(const std::string& token)
     return out;
 }
 
-static Result<unsigned long> parseSizeBytes_(const std::string& token)
+static Result<unsigned long> parseSizeBytes_(
+    const std::string& token, const std::string& directive)
 {
     if (token.empty())
     {
-        return Result<unsigned long>(ERROR, "client_max_body_size is empty");
+        return Result<unsigned long>(ERROR, directive + " is empty");
     }
     std::string num = token;
-    bool is_megabytes = false;
+    unsigned long unit = 1;
     if (token.size() >= 2)
     {
         const char last = token[token.size() - 1];
         if (last == 'M' || last == 'm')
         {
-            is_megabytes = true;
+            unit = 1024ul * 1024ul;
+            num = token.substr(0, token.size() - 1);
+        }
+        else if (last == 'K' || last == 'k')
+        {
+            unit = 1024ul;
             num = token.substr(0, token.size() - 1);
         }
     }
     Result<unsigned long> parsed = parseUnsignedLong_(num);
     if (parsed.isError())
     {
-        return Result<unsigned long>(ERROR, "client_max_body_size is invalid");
+        return Result<unsigned long>(ERROR, directive + " is invalid");
     }
-    unsigned long bytes = parsed.unwrap();
-    if (is_megabytes)
-    {
-        bytes *= (1024ul * 1024ul);
-    }
-    return bytes;
+    return parsed.unwrap() * unit;
 }
 
 static bool shouldCheckDuplicateInLocation_(const std::string& directive)
 {
     return directive == "client_max_body_size" || directive == "root" ||
            directive == "autoindex" || directive == "upload_store" ||
-           directive == "return";
+           directive == "return" || directive == "gzip_static" ||
+           directive == "gzip" || directive == "gzip_min_length" ||
+           directive == "gzip_comp_level" ||
+           directive == "file_cache_max_size" ||
+           directive == "client_body_buffer_size" ||
+           directive == "client_body_temp_path" ||
+           directive == "fastcgi_pass" || directive == "cgi_worker_pool" ||
+           directive == "cgi_max_concurrency" ||
+           directive == "cgi_request_buffering";
 }
 
 static Result<void> checkUniqueServerNamesPerPort_(
@@ -329,6 +338,24 @@ Result<ServerConfig> ConfigParser::parseConfigInternal(const std::string& data)
             }
             continue;
         }
+        if (w.unwrap() == "types")
+        {
+            Result<void> r = parseTypesBlock(ctx, config);
+            if (r.isError())
+            {
+                return Result<ServerConfig>(ERROR, r.getErrorMessage());
+            }
+            continue;
+        }
+        if (w.unwrap() == "cgi_max_concurrency")
+        {
+            Result<void> r = parseCgiMaxConcurrencyDirective(ctx, config);
+            if (r.isError())
+            {
+                return Result<ServerConfig>(ERROR, r.getErrorMessage());
+            }
+            continue;
+        }
         return Result<ServerConfig>(ERROR, "unexpected token: " + w.unwrap());
     }
 
@@ -339,6 +366,69 @@ Result<ServerConfig> ConfigParser::parseConfigInternal(const std::string& data)
     return config;
 }
 
+Result<void> ConfigParser::parseTypesBlock(
+    ParseContext& ctx, ServerConfig& config)
+{
+    Result<std::string> open = ctx.getWord();
+    if (open.isError())
+    {
+        return Result<void>(ERROR, open.getErrorMessage());
+    }
+    if (open.unwrap() != "{")
+    {
+        return Result<void>(
+            ERROR, "expected '{' but got '" + open.unwrap() + "'");
+    }
+
+    while (true)
+    {
+        Result<std::string> mime = ctx.getWord();
+        if (mime.isError())
+        {
+            return Result<void>(ERROR, mime.getErrorMessage());
+        }
+        if (mime.unwrap() == "}")
+        {
+            break;
+        }
+        if (mime.unwrap() == "{" || mime.unwrap() == ";")
+        {
+            return Result<void>(
+                ERROR, "unexpected token in types: " + mime.unwrap());
+        }
+
+        bool has_any = false;
+        while (true)
+        {
+            Result<std::string> ext = ctx.getWord();
+            if (ext.isError())
+            {
+                return Result<void>(ERROR, ext.getErrorMessage());
+            }
+            if (ext.unwrap() == ";")
+            {
+                break;
+            }
+            if (ext.unwrap() == "{" || ext.unwrap() == "}")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            Result<void> r = config.appendType(mime.unwrap(), ext.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            has_any = true;
+        }
+        if (!has_any)
+        {
+            return Result<void>(
+                ERROR, "types entry requires at least one extension");
+        }
+    }
+    return Result<void>();
+}
+
 Result<void> ConfigParser::parseServerBlock(
     ParseContext& ctx, ServerConfig& config)
 {
@@ -442,7 +532,8 @@ Result<void> ConfigParser::parseServerBlock(
             {
                 return Result<void>(ERROR, tok.getErrorMessage());
             }
-            Result<unsigned long> size = parseSizeBytes_(tok.unwrap());
+            Result<unsigned long> size =
+                parseSizeBytes_(tok.unwrap(), "client_max_body_size");
             if (size.isError())
             {
                 return Result<void>(ERROR, size.getErrorMessage());
@@ -758,7 +849,8 @@ Result<void> ConfigParser::parseLocationBlock(ParseContext& ctx,
             {
                 return Result<void>(ERROR, tok.getErrorMessage());
             }
-            Result<unsigned long> size = parseSizeBytes_(tok.unwrap());
+            Result<unsigned long> size =
+                parseSizeBytes_(tok.unwrap(), "client_max_body_size");
             if (size.isError())
             {
                 return Result<void>(ERROR, size.getErrorMessage());
@@ -809,6 +901,34 @@ Result<void> ConfigParser::parseLocationBlock(ParseContext& ctx,
             }
             continue;
         }
+        if (directive.unwrap() == "cgi_request_buffering")
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            Result<bool> on = parseOnOff(tok.unwrap());
+            if (on.isError())
+            {
+                return Result<void>(ERROR, on.getErrorMessage());
+            }
+            Result<void> r = location.setCgiRequestBuffering(on.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            Result<std::string> semi = ctx.getWord();
+            if (semi.isError())
+            {
+                return Result<void>(ERROR, semi.getErrorMessage());
+            }
+            if (semi.unwrap() != ";")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            continue;
+        }
         if (directive.unwrap() == "autoindex")
         {
             Result<std::string> tok = ctx.getWord();
@@ -837,6 +957,114 @@ Result<void> ConfigParser::parseLocationBlock(ParseContext& ctx,
             }
             continue;
         }
+        if (directive.unwrap() == "gzip" ||
+            directive.unwrap() == "gzip_min_length" ||
+            directive.unwrap() == "gzip_comp_level" ||
+            directive.unwrap() == "gzip_types")
+        {
+            Result<void> r =
+                parseGzipDirective(ctx, location, directive.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            continue;
+        }
+        if (directive.unwrap() == "gzip_static")
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            Result<bool> on = parseOnOff(tok.unwrap());
+            if (on.isError())
+            {
+                return Result<void>(ERROR, on.getErrorMessage());
+            }
+            Result<void> r = location.setGzipStatic(on.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            Result<std::string> semi = ctx.getWord();
+            if (semi.isError())
+            {
+                return Result<void>(ERROR, semi.getErrorMessage());
+            }
+            if (semi.unwrap() != ";")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            continue;
+        }
+        if (directive.unwrap() == "file_cache_max_size")
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            Result<unsigned long> size =
+                parseSizeBytes_(tok.unwrap(), "file_cache_max_size");
+            if (size.isError())
+            {
+                return Result<void>(ERROR, size.getErrorMessage());
+            }
+            Result<void> r = location.setFileCacheMaxSize(size.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            Result<std::string> semi = ctx.getWord();
+            if (semi.isError())
+            {
+                return Result<void>(ERROR, semi.getErrorMessage());
+            }
+            if (semi.unwrap() != ";")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            continue;
+        }
+        if (directive.unwrap() == "client_body_buffer_size")
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            Result<unsigned long> size =
+                parseSizeBytes_(tok.unwrap(), "client_body_buffer_size");
+            if (size.isError())
+            {
+                return Result<void>(ERROR, size.getErrorMessage());
+            }
+            Result<void> r = location.setClientBodyBufferSize(size.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            Result<std::string> semi = ctx.getWord();
+            if (semi.isError())
+            {
+                return Result<void>(ERROR, semi.getErrorMessage());
+            }
+            if (semi.unwrap() != ";")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            continue;
+        }
+        if (directive.unwrap() == "add_header")
+        {
+            Result<void> r = parseAddHeaderDirective(ctx, location);
+            if (r.isError())
+            {
+                return r;
+            }
+            continue;
+        }
         if (directive.unwrap() == "upload_store")
         {
             Result<std::string> tok = ctx.getWord();
@@ -860,6 +1088,90 @@ Result<void> ConfigParser::parseLocationBlock(ParseContext& ctx,
             }
             continue;
         }
+        if (directive.unwrap() == "client_body_temp_path")
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            Result<void> r = location.setClientBodyTempPath(tok.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            Result<std::string> semi = ctx.getWord();
+            if (semi.isError())
+            {
+                return Result<void>(ERROR, semi.getErrorMessage());
+            }
+            if (semi.unwrap() != ";")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            continue;
+        }
+        if (directive.unwrap() == "cgi_max_concurrency")
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            Result<unsigned long> n = parseUnsignedLong_(tok.unwrap());
+            if (n.isError())
+            {
+                return Result<void>(ERROR,
+                    "cgi_max_concurrency: " + n.getErrorMessage());
+            }
+            Result<void> r = location.setCgiMaxConcurrency(n.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            Result<std::string> semi = ctx.getWord();
+            if (semi.isError())
+            {
+                return Result<void>(ERROR, semi.getErrorMessage());
+            }
+            if (semi.unwrap() != ";")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            continue;
+        }
+        if (directive.unwrap() == "cgi_worker_pool")
+        {
+            Result<void> r = parseCgiWorkerPoolDirective(ctx, location);
+            if (r.isError())
+            {
+                return r;
+            }
+            continue;
+        }
+        if (directive.unwrap() == "fastcgi_pass")
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            Result<void> r = location.setFastCgiPass(tok.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+            Result<std::string> semi = ctx.getWord();
+            if (semi.isError())
+            {
+                return Result<void>(ERROR, semi.getErrorMessage());
+            }
+            if (semi.unwrap() != ";")
+            {
+                return Result<void>(ERROR, "expected ';'");
+            }
+            continue;
+        }
 
         return Result<void>(
             ERROR, "unknown directive in location: " + directive.unwrap());
@@ -868,6 +1180,122 @@ Result<void> ConfigParser::parseLocationBlock(ParseContext& ctx,
     return Result<void>();
 }
 
+Result<void> ConfigParser::parseGzipDirective(ParseContext& ctx,
+    LocationDirectiveConfMaker& location, const std::string& directive)
+{
+    if (directive == "gzip_types")
+    {
+        bool has_any = false;
+        while (true)
+        {
+            Result<std::string> tok = ctx.getWord();
+            if (tok.isError())
+            {
+                return Result<void>(ERROR, tok.getErrorMessage());
+            }
+            if (tok.unwrap() == ";")
+            {
+                break;
+            }
+            has_any = true;
+            Result<void> r = location.appendGzipType(tok.unwrap());
+            if (r.isError())
+            {
+                return r;
+            }
+        }
+        if (!has_any)
+        {
+            return Result<void>(ERROR, "gzip_types requires mime types");
+        }
+        return Result<void>();
+    }
+
+    Result<std::string> tok = ctx.getWord();
+    if (tok.isError())
+    {
+        return Result<void>(ERROR, tok.getErrorMessage());
+    }
+    Result<void> r;
+    if (directive == "gzip")
+    {
+        Result<bool> on = parseOnOff(tok.unwrap());
+        if (on.isError())
+        {
+            return Result<void>(ERROR, on.getErrorMessage());
+        }
+        r = location.setGzip(on.unwrap());
+    }
+    else
+    {
+        Result<unsigned long> n = parseUnsignedLong_(tok.unwrap());
+        if (n.isError())
+        {
+            return Result<void>(
+                ERROR, directive + " is invalid: " + tok.unwrap());
+        }
+        if (directive == "gzip_min_length")
+        {
+            r = location.setGzipMinLength(n.unwrap());
+        }
+        else
+        {
+            r = location.setGzipCompLevel(n.unwrap());
+        }
+    }
+    if (r.isError())
+    {
+        return r;
+    }
+    Result<std::string> semi = ctx.getWord();
+    if (semi.isError())
+    {
+        return Result<void>(ERROR, semi.getErrorMessage());
+    }
+    if (semi.unwrap() != ";")
+    {
+        return Result<void>(ERROR, "expected ';'");
+    }
+    return Result<void>();
+}
+
+Result<void> ConfigParser::parseAddHeaderDirective(
+    ParseContext& ctx, LocationDirectiveConfMaker& location)
+{
+    Result<std::string> name = ctx.getWord();
+    if (name.isError())
+    {
+        return Result<void>(ERROR, name.getErrorMessage());
+    }
+    if (name.unwrap() == ";")
+    {
+        return Result<void>(ERROR, "add_header requires name and value");
+    }
+    std::string value;
+    while (true)
+    {
+        Result<std::string> tok = ctx.getWord();
+        if (tok.isError())
+        {
+            return Result<void>(ERROR, tok.getErrorMessage());
+        }
+        if (tok.unwrap() == ";")
+        {
+            break;
+        }
+        if (!value.empty())
+        {
+            value += ' ';
+        }
+        value += tok.unwrap();
+    }
+    if (value.empty())
+    {
+        return Result<void>(ERROR, "add_header requires name and value");
+    }
+    return location.appendAddHeader(name.unwrap(), value);
+}
+
 Result<void> ConfigParser::parseAllowMethodDirective(
     ParseContext& ctx, LocationDirectiveConfMaker& location)
 {
@@ -929,6 +1357,103 @@ Result<void> ConfigParser::parseCgiExecutorDirective(
     return Result<void>();
 }
 
+Result<void> ConfigParser::parseCgiWorkerPoolDirective(
+    ParseContext& ctx, LocationDirectiveConfMaker& location)
+{
+    CgiWorkerPoolConf pool;
+    while (true)
+    {
+        Result<std::string> tok = ctx.getWord();
+        if (tok.isError())
+        {
+            return Result<void>(ERROR, tok.getErrorMessage());
+        }
+        const std::string option = tok.unwrap();
+        if (option == ";")
+        {
+            break;
+        }
+        const std::string::size_type eq = option.find('=');
+        if (eq == std::string::npos)
+        {
+            return Result<void>(
+                ERROR, "cgi_worker_pool option must be name=value: " + option);
+        }
+        const std::string name = option.substr(0, eq);
+        Result<unsigned long> value = parseUnsignedLong_(option.substr(eq + 1));
+        if (value.isError())
+        {
+            return Result<void>(ERROR,
+                "cgi_worker_pool " + name + ": " + value.getErrorMessage());
+        }
+        if (name == "min")
+        {
+            pool.min_workers = value.unwrap();
+        }
+        else if (name == "max")
+        {
+            pool.max_workers = value.unwrap();
+        }
+        else if (name == "max_requests")
+        {
+            pool.max_requests = value.unwrap();
+        }
+        else if (name == "idle_timeout")
+        {
+            pool.idle_timeout_sec = value.unwrap();
+        }
+        else
+        {
+            return Result<void>(ERROR, "unknown cgi_worker_pool option: " + name);
+        }
+    }
+    return location.setCgiWorkerPool(pool);
+}
+
+// cgi_max_concurrency N [queue=M];（server ブロックの外）
+Result<void> ConfigParser::parseCgiMaxConcurrencyDirective(
+    ParseContext& ctx, ServerConfig& config)
+{
+    Result<std::string> tok = ctx.getWord();
+    if (tok.isError())
+    {
+        return Result<void>(ERROR, tok.getErrorMessage());
+    }
+    Result<unsigned long> max = parseUnsignedLong_(tok.unwrap());
+    if (max.isError())
+    {
+        return Result<void>(
+            ERROR, "cgi_max_concurrency: " + max.getErrorMessage());
+    }
+    unsigned long queue_size = ServerConfig::kDefaultCgiQueueSize;
+    while (true)
+    {
+        Result<std::string> opt = ctx.getWord();
+        if (opt.isError())
+        {
+            return Result<void>(ERROR, opt.getErrorMessage());
+        }
+        const std::string option = opt.unwrap();
+        if (option == ";")
+        {
+            break;
+        }
+        if (option.compare(0, 6, "queue=") != 0)
+        {
+            return Result<void>(
+                ERROR, "unknown cgi_max_concurrency option: " + option);
+        }
+        Result<unsigned long> q = parseUnsignedLong_(option.substr(6));
+        if (q.isError())
+        {
+            return Result<void>(
+                ERROR, "cgi_max_concurrency queue: " + q.getErrorMessage());
+        }
+        queue_size = q.unwrap();
+    }
+    return config.setCgiMaxConcurrency(max.unwrap(), queue_size);
+}
+
 Result<void> ConfigParser::parseReturnDirective(
     ParseContext& ctx, LocationDirectiveConfMaker& location)
 {
@@ -89,6 +89,11 @@ class ConfigParser
     static Result<void> parseServerBlock(
         ParseContext& ctx, ServerConfig& config);
 
+    // types block
+    // types: 'types' '{' (MIME_TYPE EXTENSION+ END_DIRECTIVE)* '}';
+    static Result<void> parseTypesBlock(
+        ParseContext& ctx, ServerConfig& config);
+
     // listen_directive: 'listen' WHITESPACE NUMBER END_DIRECTIVE;
     static Result<void> parseListenDirective(
         ParseContext& ctx, VirtualServerConfMaker& vserver);
@@ -110,6 +115,30 @@ class ConfigParser
     static Result<void> parseReturnDirective(
         ParseContext& ctx, LocationDirectiveConfMaker& location);
 
+    // gzip_directive: 'gzip' ('on' | 'off') END_DIRECTIVE;
+    // gzip_min_length_directive: 'gzip_min_length' NUMBER END_DIRECTIVE;
+    // gzip_comp_level_directive: 'gzip_comp_level' NUMBER END_DIRECTIVE;
+    // gzip_types_directive: 'gzip_types' MIME_TYPE+ END_DIRECTIVE;
+    static Result<void> parseGzipDirective(ParseContext& ctx,
+        LocationDirectiveConfMaker& location, const std::string& directive);
+
+    // cgi_worker_pool_directive: 'cgi_worker_pool' OPTION* END_DIRECTIVE;
+    // OPTION: ('min' | 'max' | 'max_requests' | 'idle_timeout') '=' NUMBER
+    // executor は fd 0 の listen ソケットで FastCGI を話す必要がある
+    static Result<void> parseCgiWorkerPoolDirective(
+        ParseContext& ctx, LocationDirectiveConfMaker& location);
+
+    // server ブロックの外に置く:
+    // cgi_max_concurrency_directive:
+    //     'cgi_max_concurrency' NUMBER ('queue=' NUMBER)? END_DIRECTIVE;
+    static Result<void> parseCgiMaxConcurrencyDirective(
+        ParseContext& ctx, ServerConfig& config);
+
+    // add_header_directive: 'add_header' HEADER_NAME WORD+ END_DIRECTIVE;
+    // 値の WORD が複数あれば空白1つで連結する
+    static Result<void> parseAddHeaderDirective(
+        ParseContext& ctx, LocationDirectiveConfMaker& location);
+
     // Parser utils
 
     // 符号なし整数かどうか
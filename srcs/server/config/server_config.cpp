@@ -21,6 +21,50 @@ Result<void> ServerConfig::appendServer(const VirtualServerConf& server)
     return Result<void>();
 }
 
+// nginx と同じく、同じ拡張子が複数回現れたら後のものを使う
+Result<void> ServerConfig::appendType(
+    const std::string& mime_type, const std::string& extension)
+{
+    const std::string::size_type slash = mime_type.find('/');
+    if (slash == std::string::npos || slash == 0 ||
+        slash + 1 == mime_type.size())
+    {
+        return Result<void>(ERROR, "invalid mime type: " + mime_type);
+    }
+    if (extension.empty() || extension.find('/') != std::string::npos ||
+        extension.find('.') != std::string::npos)
+    {
+        return Result<void>(ERROR, "invalid extension: " + extension);
+    }
+
+    std::string lower = extension;
+    for (size_t i = 0; i < lower.size(); ++i)
+    {
+        if (lower[i] >= 'A' && lower[i] <= 'Z')
+            lower[i] = static_cast<char>(lower[i] - 'A' + 'a');
+    }
+    types[lower] = mime_type;
+    return Result<void>();
+}
+
+Result<void> ServerConfig::setCgiMaxConcurrency(
+    unsigned long max, unsigned long queue_size)
+{
+    if (has_cgi_max_concurrency)
+    {
+        return Result<void>(
+            ERROR, "directive is duplicate: cgi_max_concurrency");
+    }
+    if (max == 0)
+    {
+        return Result<void>(ERROR, "cgi_max_concurrency must be positive");
+    }
+    has_cgi_max_concurrency = true;
+    cgi_max_concurrency = max;
+    cgi_queue_size = queue_size;
+    return Result<void>();
+}
+
 bool ServerConfig::isValid() const
 {
     if (servers.empty())
@@ -1,6 +1,7 @@
 #ifndef WEBSERV_SERVER_CONFIG_HPP_
 #define WEBSERV_SERVER_CONFIG_HPP_
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -13,10 +14,30 @@ using utils::result::Result;
 
 struct ServerConfig
 {
+    static const unsigned long kDefaultCgiQueueSize = 128;
+
     std::vector<VirtualServerConf> servers;
+    // types {} ブロックで追加する 拡張子(小文字) -> MIME type
+    std::map<std::string, std::string> types;
+    // サーバー全体での CGI の同時実行数の上限（0 は無制限）
+    unsigned long cgi_max_concurrency;
+    // 上限に達したときに実行を待てるリクエスト数。溢れたら 503
+    unsigned long cgi_queue_size;
+    bool has_cgi_max_concurrency;
 
-    ServerConfig() : servers() {}
+    ServerConfig()
+        : servers(),
+          types(),
+          cgi_max_concurrency(0),
+          cgi_queue_size(kDefaultCgiQueueSize),
+          has_cgi_max_concurrency(false)
+    {
+    }
     Result<void> appendServer(const VirtualServerConf& server);
+    Result<void> appendType(
+        const std::string& mime_type, const std::string& extension);
+    Result<void> setCgiMaxConcurrency(
+        unsigned long max, unsigned long queue_size);
     std::vector<Listen> getListens() const;
     bool isValid() const;
 };
@@ -0,0 +1,149 @@
+#include "server/http_processing_module/cgi_limiter.hpp"
+
+#include "server/session/fd_session_controller.hpp"
+#include "utils/log.hpp"
+
+namespace server
+{
+
+const long CgiLimiter::kRetryAfterSec;
+
+CgiLimiter::CgiLimiter(FdSessionController& controller)
+    : controller_(controller),
+      processing_log_(NULL),
+      max_total_(0),
+      queue_size_(ServerConfig::kDefaultCgiQueueSize),
+      active_total_(0),
+      active_(),
+      queue_(),
+      is_granting_(false),
+      needs_rescan_(false)
+{
+}
+
+CgiLimiter::~CgiLimiter() {}
+
+void CgiLimiter::configure(
+    const ServerConfig& config, utils::ProcessingLog* processing_log)
+{
+    max_total_ = config.cgi_max_concurrency;
+    queue_size_ = config.cgi_queue_size;
+    processing_log_ = processing_log;
+}
+
+bool CgiLimiter::hasRoom_(const void* key, unsigned long limit) const
+{
+    if (max_total_ > 0 && active_total_ >= max_total_)
+        return false;
+    if (limit == 0)
+        return true;
+    std::map<const void*, unsigned long>::const_iterator it = active_.find(key);
+    return it == active_.end() || it->second < limit;
+}
+
+void CgiLimiter::take_(const void* key)
+{
+    ++active_total_;
+    ++active_[key];
+}
+
+// 枠が空けば待ち行列の先頭側から順に起動させるので、空きがある時点で
+// 並んでいる人は（location の上限で）その枠を使えない人だけになる。
+// そのため新しいリクエストは空きがあればそのまま起動してよい。
+CgiLimiter::Admission CgiLimiter::admit(
+    Waiter* waiter, const void* key, unsigned long limit)
+{
+    if (hasRoom_(key, limit))
+    {
+        take_(key);
+        return kStart;
+    }
+    if (queue_.size() >= queue_size_)
+    {
+        if (processing_log_ != NULL)
+            processing_log_->onCgiRejected();  // ログ計測
+        return kRejected;
+    }
+    Entry e;
+    e.waiter = waiter;
+    e.key = key;
+    e.limit = limit;
+    queue_.push_back(e);
+    if (processing_log_ != NULL)
+        processing_log_->onCgiQueued();  // ログ計測
+    return kQueued;
+}
+
+bool CgiLimiter::tryAcquire(const void* key, unsigned long limit)
+{
+    if (!hasRoom_(key, limit))
+        return false;
+    take_(key);
+    return true;
+}
+
+void CgiLimiter::release(const void* key)
+{
+    std::map<const void*, unsigned long>::iterator it = active_.find(key);
+    if (it == active_.end())
+        return;
+    if (--it->second == 0)
+        active_.erase(it);
+    if (active_total_ > 0)
+        --active_total_;
+
+    // 終了処理中に新しい CGI を起動しない（残りのセッションも破棄される）
+    if (controller_.isShuttingDown())
+        return;
+    grantWaiters_();
+}
+
+void CgiLimiter::cancel(Waiter* waiter)
+{
+    for (std::deque<Entry>::iterator it = queue_.begin(); it != queue_.end();
+        ++it)
+    {
+        if (it->waiter == waiter)
+        {
+            queue_.erase(it);
+            if (processing_log_ != NULL)
+                processing_log_->onCgiDequeued();  // ログ計測
+            return;
+        }
+    }
+}
+
+void CgiLimiter::grantWaiters_()
+{
+    if (is_granting_)
+    {
+        needs_rescan_ = true;
+        return;
+    }
+    is_granting_ = true;
+    do
+    {
+        needs_rescan_ = false;
+        for (std::deque<Entry>::iterator it = queue_.begin();
+            it != queue_.end(); ++it)
+        {
+            if (max_total_ > 0 && active_total_ >= max_total_)
+                break;
+            if (!hasRoom_(it->key, it->limit))
+                continue;
+
+            // 通知の中で queue_ が変わり得るので、取り出してから呼ぶ
+            const Entry e = *it;
+            queue_.erase(it);
+            if (processing_log_ != NULL)
+                processing_log_->onCgiDequeued();  // ログ計測
+            take_(e.key);
+            e.waiter->onCgiSlotGranted(e.key);
+            needs_rescan_ = true;
+            break;
+        }
+    } while (needs_rescan_);
+    is_granting_ = false;
+}
+
+}  // namespace server
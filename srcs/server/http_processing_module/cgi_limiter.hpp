@@ -0,0 +1,91 @@
+#ifndef WEBSERV_CGI_LIMITER_HPP_
+#define WEBSERV_CGI_LIMITER_HPP_
+
+#include <cstddef>
+#include <deque>
+#include <map>
+
+#include "server/config/server_config.hpp"
+
+namespace utils
+{
+class ProcessingLog;
+}
+
+namespace server
+{
+
+class FdSessionController;
+
+// CGI の同時実行数を制限する。
+// - サーバー全体（cgi_max_concurrency）と location ごとの上限を両方見る。
+// - 上限に達したリクエストは FIFO で待たせ、枠が空いた時点で起動させる。
+//   待ち行列も溢れたら kRejected（呼び出し側で 503 を返す）。
+// - 枠は CgiSession の破棄で返る（CGI のタイムアウトでも必ず返る）。
+class CgiLimiter
+{
+   public:
+    static const long kRetryAfterSec = 1;
+
+    // 順番が回ってきたことの通知先
+    class Waiter
+    {
+       public:
+        virtual ~Waiter() {}
+        // 枠は確保済み。使わない場合は release(key) で返すこと
+        virtual void onCgiSlotGranted(const void* key) = 0;
+    };
+
+    enum Admission
+    {
+        kStart,
+        kQueued,
+        kRejected
+    };
+
+    explicit CgiLimiter(FdSessionController& controller);
+    ~CgiLimiter();
+
+    void configure(
+        const ServerConfig& config, utils::ProcessingLog* processing_log);
+
+    // key は location ごとの識別子、limit はその location の上限（0 は無制限）。
+    // kStart なら枠を確保済み。kQueued なら後で onCgiSlotGranted が呼ばれる。
+    Admission admit(Waiter* waiter, const void* key, unsigned long limit);
+    // 待たずに起動できる場合だけ枠を確保する（待ち行列には並ばない）
+    bool tryAcquire(const void* key, unsigned long limit);
+    void release(const void* key);
+    // 待ち行列から外す（並んでいなければ何もしない）
+    void cancel(Waiter* waiter);
+
+   private:
+    struct Entry
+    {
+        Waiter* waiter;
+        const void* key;
+        unsigned long limit;
+    };
+
+    FdSessionController& controller_;
+    utils::ProcessingLog* processing_log_;
+    unsigned long max_total_;
+    unsigned long queue_size_;
+    unsigned long active_total_;
+    std::map<const void*, unsigned long> active_;
+    std::deque<Entry> queue_;
+    // onCgiSlotGranted の中から release/admit されても安全に回すため
+    bool is_granting_;
+    bool needs_rescan_;
+
+    bool hasRoom_(const void* key, unsigned long limit) const;
+    void take_(const void* key);
+    void grantWaiters_();
+
+    CgiLimiter();
+    CgiLimiter(const CgiLimiter& rhs);
+    CgiLimiter& operator=(const CgiLimiter& rhs);
+};
+
+}  // namespace server
+
+#endif
@@ -0,0 +1,373 @@
+#include "server/http_processing_module/cgi_worker_pool.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <cstring>
+#include <sstream>
+
+#include "server/http_processing_module/fastcgi_upstream_pool.hpp"
+#include "utils/log.hpp"
+
+namespace server
+{
+
+using namespace utils::result;
+
+const int CgiWorkerPool::kListenBacklog;
+const long CgiWorkerPool::kStopGraceSec;
+const long CgiWorkerPool::kEarlyExitSec;
+const unsigned int CgiWorkerPool::kMaxEarlyExits;
+
+namespace
+{
+
+const char* const kSocketDir = "/tmp";
+
+// fork 後の子で、サーバの fd（クライアントのソケット等）を引き継がないよう
+// 0〜2 以外をすべて閉じる。ワーカは長く生きるので、残すと接続が閉じなくなる。
+void closeInheritedFds_()
+{
+#if defined(__linux__) && defined(SYS_close_range)
+    if (::syscall(SYS_close_range, 3U, ~0U, 0U) == 0)
+        return;
+#endif
+    long max_fd = ::sysconf(_SC_OPEN_MAX);
+    if (max_fd < 0 || max_fd > 65536)
+        max_fd = 65536;
+    for (int fd = 3; fd < max_fd; ++fd)
+        (void)::close(fd);
+}
+
+}  // namespace
+
+CgiWorkerPool::CgiWorkerPool(FastCgiUpstreamPool& upstreams)
+    : upstreams_(upstreams), groups_(), next_worker_id_(0)
+{
+}
+
+CgiWorkerPool::~CgiWorkerPool()
+{
+    const time_t now = std::time(NULL);
+    for (GroupMap::iterator g = groups_.begin(); g != groups_.end(); ++g)
+    {
+        for (size_t i = 0; i < g->second.workers.size(); ++i)
+            stop_(g->second.workers[i], now);
+    }
+
+    // 短い猶予の間だけ終了を待つ（CgiSession と同じく select で待機）
+    const int kGraceTotalMs = 300;
+    const int kTickMs = 30;
+    for (int waited_ms = 0; waited_ms < kGraceTotalMs; waited_ms += kTickMs)
+    {
+        bool all_exited = true;
+        for (GroupMap::iterator g = groups_.begin(); g != groups_.end(); ++g)
+        {
+            reap_(g->second);
+            if (!g->second.workers.empty())
+                all_exited = false;
+        }
+        if (all_exited)
+            return;
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = kTickMs * 1000;
+        (void)::select(0, NULL, NULL, NULL, &tv);
+    }
+
+    for (GroupMap::iterator g = groups_.begin(); g != groups_.end(); ++g)
+    {
+        std::vector<Worker>& workers = g->second.workers;
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            int status = 0;
+            (void)::kill(workers[i].pid, SIGKILL);
+            (void)::waitpid(workers[i].pid, &status, 0);
+            (void)::unlink(workers[i].socket_path.c_str());
+        }
+        workers.clear();
+    }
+}
+
+void CgiWorkerPool::configure(const ServerConfig& config)
+{
+    for (size_t s = 0; s < config.servers.size(); ++s)
+    {
+        const std::vector<LocationDirectiveConf>& locations =
+            config.servers[s].locations;
+        for (size_t l = 0; l < locations.size(); ++l)
+        {
+            const LocationDirectiveConf& loc = locations[l];
+            if (!loc.has_cgi_worker_pool)
+                continue;
+            for (LocationDirectiveConf::CgiExtensionsMap::const_iterator it =
+                     loc.cgi_extensions.begin();
+                it != loc.cgi_extensions.end(); ++it)
+            {
+                (void)groupFor_(it->second.str(), loc.cgi_worker_pool);
+            }
+        }
+    }
+    maintain();
+}
+
+// 設定の違う location の要求を1つのワーカ群にまとめないよう、設定値も含める
+std::string CgiWorkerPool::groupKey_(
+    const std::string& executor, const CgiWorkerPoolConf& conf)
+{
+    std::ostringstream oss;
+    oss << executor << " min=" << conf.min_workers
+        << " max=" << conf.max_workers
+        << " max_requests=" << conf.max_requests
+        << " idle_timeout=" << conf.idle_timeout_sec;
+    return oss.str();
+}
+
+CgiWorkerPool::Group& CgiWorkerPool::groupFor_(
+    const std::string& executor, const CgiWorkerPoolConf& conf)
+{
+    const std::string key = groupKey_(executor, conf);
+    GroupMap::iterator it = groups_.find(key);
+    if (it != groups_.end())
+        return it->second;
+    Group& g = groups_[key];
+    g.executor = executor;
+    g.conf = conf;
+    return g;
+}
+
+Result<std::string> CgiWorkerPool::pickWorker(
+    const std::string& executor, const CgiWorkerPoolConf& conf)
+{
+    Group& g = groupFor_(executor, conf);
+    reap_(g);
+    if (g.disabled)
+        return std::string();
+
+    size_t best = g.workers.size();
+    size_t best_load = 0;
+    size_t active = 0;
+    for (size_t i = 0; i < g.workers.size(); ++i)
+    {
+        if (g.workers[i].retiring)
+            continue;
+        ++active;
+        const size_t load = upstreams_.connectionCount(g.workers[i].address);
+        if (best == g.workers.size() || load < best_load)
+        {
+            best = i;
+            best_load = load;
+        }
+    }
+
+    // アイドルなワーカが無ければ、max までは新しく起動する。
+    // 起動直後でも listen 済みなので、接続はそのまま受け付けられる。
+    if ((best == g.workers.size() || best_load > 0) &&
+        active < g.conf.max_workers)
+    {
+        Result<void> sp = spawn_(g);
+        if (sp.isOk())
+            best = g.workers.size() - 1;
+        else if (best == g.workers.size())
+            return Result<std::string>(
+                ERROR, std::string(), sp.getErrorMessage());
+    }
+    if (best == g.workers.size())
+        return Result<std::string>(
+            ERROR, std::string(), "no cgi worker available");
+
+    Worker& w = g.workers[best];
+    ++w.requests;
+    w.idle_since = 0;
+    if (g.conf.max_requests > 0 && w.requests >= g.conf.max_requests)
+        w.retiring = true;
+    return w.address;
+}
+
+void CgiWorkerPool::maintain()
+{
+    const time_t now = std::time(NULL);
+    for (GroupMap::iterator it = groups_.begin(); it != groups_.end(); ++it)
+    {
+        Group& g = it->second;
+        reap_(g);
+        if (g.disabled)
+            continue;
+
+        size_t active = 0;
+        for (size_t i = 0; i < g.workers.size(); ++i)
+        {
+            Worker& w = g.workers[i];
+            const size_t load = upstreams_.connectionCount(w.address);
+            if (w.stop_sent_at != 0)
+            {
+                if (now - w.stop_sent_at >= kStopGraceSec)
+                    (void)::kill(w.pid, SIGKILL);
+                continue;
+            }
+            if (w.retiring)
+            {
+                // 渡したリクエストを処理し終えてから止める
+                if (load == 0)
+                    stop_(w, now);
+                continue;
+            }
+            ++active;
+            if (now - w.started_at >= kEarlyExitSec)
+                g.early_exits = 0;
+            if (load > 0)
+                w.idle_since = 0;
+            else if (w.idle_since == 0)
+                w.idle_since = now;
+        }
+
+        for (size_t i = 0; i < g.workers.size() && active > g.conf.min_workers;
+            ++i)
+        {
+            Worker& w = g.workers[i];
+            if (w.retiring || w.idle_since == 0)
+                continue;
+            if (static_cast<unsigned long>(now - w.idle_since) <
+                g.conf.idle_timeout_sec)
+                continue;
+            w.retiring = true;
+            stop_(w, now);
+            --active;
+        }
+
+        while (active < g.conf.min_workers)
+        {
+            if (spawn_(g).isError())
+                break;
+            ++active;
+        }
+    }
+}
+
+Result<void> CgiWorkerPool::spawn_(Group& group)
+{
+    std::ostringstream oss;
+    oss << kSocketDir << "/webserv-cgi." << ::getpid() << "."
+        << next_worker_id_++ << ".sock";
+    const std::string socket_path = oss.str();
+
+    struct sockaddr_un un;
+    std::memset(&un, 0, sizeof(un));
+    if (socket_path.size() >= sizeof(un.sun_path))
+        return Result<void>(ERROR, "cgi worker socket path too long");
+    un.sun_family = AF_UNIX;
+    std::memcpy(un.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    const int lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0)
+        return Result<void>(ERROR, "socket() failed");
+    (void)::fcntl(lfd, F_SETFD, FD_CLOEXEC);
+    (void)::unlink(socket_path.c_str());
+    if (::bind(lfd, reinterpret_cast<struct sockaddr*>(&un), sizeof(un)) < 0 ||
+        ::listen(lfd, kListenBacklog) < 0)
+    {
+        ::close(lfd);
+        (void)::unlink(socket_path.c_str());
+        return Result<void>(ERROR, "cgi worker socket setup failed");
+    }
+
+    // fork 後の子ではメモリ確保をしないよう、execve の引数は先に作っておく
+    std::ostringstream max_requests;
+    max_requests << "PHP_FCGI_MAX_REQUESTS=" << group.conf.max_requests;
+    const std::string env_max_requests = max_requests.str();
+    char* argv[2];
+    argv[0] = const_cast<char*>(group.executor.c_str());
+    argv[1] = NULL;
+    char* envp[2];
+    envp[0] = const_cast<char*>(env_max_requests.c_str());
+    envp[1] = NULL;
+
+    const pid_t pid = ::fork();
+    if (pid < 0)
+    {
+        ::close(lfd);
+        (void)::unlink(socket_path.c_str());
+        return Result<void>(ERROR, "fork() failed");
+    }
+    if (pid == 0)
+    {
+        // 子プロセス：fd 0 が listen ソケット、stdout は使わない
+        if (::dup2(lfd, STDIN_FILENO) < 0)
+            ::_exit(1);
+        const int devnull = ::open("/dev/null", O_WRONLY);
+        if (devnull >= 0)
+            (void)::dup2(devnull, STDOUT_FILENO);
+        closeInheritedFds_();
+        ::execve(argv[0], argv, envp);
+        ::_exit(127);
+    }
+    ::close(lfd);
+
+    Worker w;
+    w.pid = pid;
+    w.socket_path = socket_path;
+    w.address = "unix:" + socket_path;
+    w.requests = 0;
+    w.started_at = std::time(NULL);
+    w.idle_since = w.started_at;
+    w.stop_sent_at = 0;
+    w.retiring = false;
+    group.workers.push_back(w);
+    return Result<void>();
+}
+
+void CgiWorkerPool::reap_(Group& group)
+{
+    const time_t now = std::time(NULL);
+    std::vector<Worker>& workers = group.workers;
+    for (size_t i = 0; i < workers.size();)
+    {
+        int status = 0;
+        const pid_t r = ::waitpid(workers[i].pid, &status, WNOHANG);
+        if (r == 0)
+        {
+            ++i;
+            continue;
+        }
+        if (!workers[i].retiring &&
+            now - workers[i].started_at < kEarlyExitSec)
+        {
+            // 起動直後の終了は再起動しても繰り返すので、続いたら諦める
+            if (++group.early_exits >= kMaxEarlyExits && !group.disabled)
+            {
+                group.disabled = true;
+                utils::Log::error("CgiWorkerPool", group.executor,
+                    "cgi workers keep exiting right after start (the "
+                    "executor must speak FastCGI on fd 0); falling back to "
+                    "one process per request");
+            }
+        }
+        else if (!workers[i].retiring)
+        {
+            group.early_exits = 0;
+            utils::Log::error(
+                "CgiWorkerPool", group.executor, "cgi worker exited");
+        }
+        (void)::unlink(workers[i].socket_path.c_str());
+        workers.erase(workers.begin() + static_cast<long>(i));
+    }
+}
+
+void CgiWorkerPool::stop_(Worker& worker, time_t now)
+{
+    if (worker.stop_sent_at != 0)
+        return;
+    worker.retiring = true;
+    worker.stop_sent_at = now;
+    (void)::kill(worker.pid, SIGTERM);
+}
+
+}  // namespace server
@@ -0,0 +1,106 @@
+#ifndef WEBSERV_CGI_WORKER_POOL_HPP_
+#define WEBSERV_CGI_WORKER_POOL_HPP_
+
+#include <sys/types.h>
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "server/config/location_directive_conf.hpp"
+#include "server/config/server_config.hpp"
+#include "utils/result.hpp"
+
+namespace server
+{
+
+class FastCgiUpstreamPool;
+
+// cgi_worker_pool: cgi_extension の executor を FastCGI ワーカとして常駐させ、
+// リクエストごとの fork/exec を無くす。
+// - ワーカは fd 0 に listen 済みの UNIX ソケットを渡して起動する
+//   （FastCGI の FCGI_LISTENSOCK_FILENO。php-cgi はこれで FastCGI になる）。
+// - リクエストは FastCgiSession の1回限りの接続で送る。ワーカが処理中なら
+//   接続は listen キューで順番を待つ。
+// - executor と cgi_worker_pool の設定の組ごとに min〜max 個を保ち、
+//   max_requests を処理したワーカと idle_timeout 秒アイドルが続いた
+//   （min を超える分の）ワーカは止める。
+// - executor が FastCGI を話さない（例: 素の python3）と、ワーカは起動直後に
+//   終了する。これが kMaxEarlyExits 回続いた組は無効にし、以後は
+//   リクエストごとに executor を起動する（pickWorker が空の接続先を返す）。
+class CgiWorkerPool
+{
+   public:
+    static const int kListenBacklog = 128;
+    // SIGTERM を送ってから SIGKILL するまでの秒数
+    static const long kStopGraceSec = 2;
+    // 起動からこの秒数以内の終了を「起動直後の終了」とみなす
+    static const long kEarlyExitSec = 3;
+    // 起動直後の終了がこの回数続いたらワーカ群を無効にする
+    static const unsigned int kMaxEarlyExits = 3;
+
+    explicit CgiWorkerPool(FastCgiUpstreamPool& upstreams);
+    ~CgiWorkerPool();  // 全ワーカを止めて回収する
+
+    // 設定にある cgi_worker_pool を executor と設定の組ごとに登録し、
+    // min 個ずつ起動する。同じ executor でも設定が違う location は
+    // 別のワーカ群を持つ（同じ設定なら共有する）。
+    void configure(const ServerConfig& config);
+    bool empty() const { return groups_.empty(); }
+
+    // executor と設定の組のワーカを1つ選び、接続先（"unix:/path"）を返す。
+    // アイドルなワーカが無く max にも達していれば、処理中の接続が
+    // 最も少ないワーカを返す。ワーカ群が無効なら空文字列を返す
+    // （呼び出し側はリクエストごとに executor を起動する）。
+    utils::result::Result<std::string> pickWorker(
+        const std::string& executor, const CgiWorkerPoolConf& conf);
+
+    // 定期処理：終了したワーカの回収、止めるべきワーカの停止、min までの補充
+    void maintain();
+
+   private:
+    struct Worker
+    {
+        pid_t pid;
+        std::string socket_path;
+        std::string address;
+        unsigned long requests;  // 渡したリクエスト数
+        time_t started_at;
+        time_t idle_since;       // 0 なら処理中
+        time_t stop_sent_at;     // SIGTERM を送った時刻。0 なら未送信
+        bool retiring;           // もうリクエストを渡さない
+    };
+    struct Group
+    {
+        std::string executor;
+        CgiWorkerPoolConf conf;
+        std::vector<Worker> workers;
+        unsigned int early_exits;  // 連続した起動直後の終了の回数
+        bool disabled;             // ワーカを起動しない
+
+        Group() : executor(), conf(), workers(), early_exits(0), disabled(false)
+        {
+        }
+    };
+    typedef std::map<std::string, Group> GroupMap;
+
+    FastCgiUpstreamPool& upstreams_;
+    GroupMap groups_;
+    unsigned long next_worker_id_;
+
+    CgiWorkerPool();
+    CgiWorkerPool(const CgiWorkerPool& rhs);
+    CgiWorkerPool& operator=(const CgiWorkerPool& rhs);
+
+    static std::string groupKey_(
+        const std::string& executor, const CgiWorkerPoolConf& conf);
+    Group& groupFor_(const std::string& executor, const CgiWorkerPoolConf& conf);
+    utils::result::Result<void> spawn_(Group& group);
+    void reap_(Group& group);
+    static void stop_(Worker& worker, time_t now);
+};
+
+}  // namespace server
+
+#endif
@@ -0,0 +1,97 @@
+#include "server/http_processing_module/fastcgi_upstream_pool.hpp"
+
+#include "server/session/fd_session/fastcgi_session.hpp"
+#include "server/session/fd_session_controller.hpp"
+
+namespace server
+{
+
+using namespace utils::result;
+
+const size_t FastCgiUpstreamPool::kMaxIdlePerUpstream;
+
+FastCgiUpstreamPool::FastCgiUpstreamPool(FdSessionController& controller)
+    : controller_(controller), idle_(), open_counts_()
+{
+}
+
+// 接続は controller が先に破棄している（破棄時に forget() が呼ばれる）
+FastCgiUpstreamPool::~FastCgiUpstreamPool() {}
+
+Result<FastCgiSession*> FastCgiUpstreamPool::acquire(
+    const std::string& address, bool keep_conn)
+{
+    SessionList& idle = idle_[address];
+    while (keep_conn && !idle.empty())
+    {
+        // 最後に返却されたもの（一番新しい接続）から使う
+        FastCgiSession* s = idle.back();
+        idle.pop_back();
+        if (s->isAlive())
+            return s;
+        controller_.requestDelete(s);
+    }
+
+    bool connecting = false;
+    Result<int> fd = FastCgiSession::connectTo(address, &connecting);
+    if (fd.isError())
+        return Result<FastCgiSession*>(ERROR, fd.getErrorMessage());
+
+    const int sock_fd = fd.unwrap();
+    FastCgiSession* s = new FastCgiSession(
+        controller_, *this, address, sock_fd, connecting, keep_conn);
+    ++open_counts_[address];
+    Result<void> d = controller_.delegateSession(s);
+    if (d.isError())
+    {
+        delete s;
+        return Result<FastCgiSession*>(ERROR, d.getErrorMessage());
+    }
+    return s;
+}
+
+bool FastCgiUpstreamPool::release(FastCgiSession* session)
+{
+    SessionList& idle = idle_[session->address()];
+    if (idle.size() >= kMaxIdlePerUpstream)
+        return false;
+    idle.push_back(session);
+    return true;
+}
+
+void FastCgiUpstreamPool::forget(FastCgiSession* session)
+{
+    std::map<std::string, SessionList>::iterator it =
+        idle_.find(session->address());
+    if (it == idle_.end())
+        return;
+    SessionList& idle = it->second;
+    for (SessionList::iterator sit = idle.begin(); sit != idle.end(); ++sit)
+    {
+        if (*sit == session)
+        {
+            idle.erase(sit);
+            return;
+        }
+    }
+}
+
+void FastCgiUpstreamPool::onClosed(FastCgiSession* session)
+{
+    forget(session);
+    std::map<std::string, size_t>::iterator it =
+        open_counts_.find(session->address());
+    if (it == open_counts_.end())
+        return;
+    if (--it->second == 0)
+        open_counts_.erase(it);
+}
+
+size_t FastCgiUpstreamPool::connectionCount(const std::string& address) const
+{
+    std::map<std::string, size_t>::const_iterator it =
+        open_counts_.find(address);
+    return (it == open_counts_.end()) ? 0 : it->second;
+}
+
+}  // namespace server
@@ -0,0 +1,58 @@
+#ifndef WEBSERV_FASTCGI_UPSTREAM_POOL_HPP_
+#define WEBSERV_FASTCGI_UPSTREAM_POOL_HPP_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "utils/result.hpp"
+
+namespace server
+{
+
+class FastCgiSession;
+class FdSessionController;
+
+// FastCGI アップストリームごとに、アイドルな接続を保持して使い回す。
+// - 接続（FastCgiSession）の所有者は FdSessionController。
+//   ここはアイドルなものへの参照と、開いている接続の数を持つだけ。
+// - 使い回せる接続が無ければ新しく接続する（上限なし）。
+//   返却時にアイドル数が kMaxIdlePerUpstream を超える分は閉じる。
+class FastCgiUpstreamPool
+{
+   public:
+    static const size_t kMaxIdlePerUpstream = 8;
+
+    explicit FastCgiUpstreamPool(FdSessionController& controller);
+    ~FastCgiUpstreamPool();
+
+    // 返した接続はすぐ startRequest() すること。
+    // keep_conn でなければアイドルな接続は使わず、1リクエスト限りで接続する。
+    utils::result::Result<FastCgiSession*> acquire(
+        const std::string& address, bool keep_conn);
+    // リクエストを終えた接続をアイドルに戻す。false なら呼び出し側で閉じる。
+    bool release(FastCgiSession* session);
+    // 閉じる接続をアイドル一覧から外す
+    void forget(FastCgiSession* session);
+    // 接続の破棄時に呼ぶ
+    void onClosed(FastCgiSession* session);
+
+    // address へ開いている接続の数（アイドルなものも含む）
+    size_t connectionCount(const std::string& address) const;
+
+   private:
+    typedef std::vector<FastCgiSession*> SessionList;
+
+    FdSessionController& controller_;
+    std::map<std::string, SessionList> idle_;
+    std::map<std::string, size_t> open_counts_;
+
+    FastCgiUpstreamPool();
+    FastCgiUpstreamPool(const FastCgiUpstreamPool& rhs);
+    FastCgiUpstreamPool& operator=(const FastCgiUpstreamPool& rhs);
+};
+
+}  // namespace server
+
+#endif
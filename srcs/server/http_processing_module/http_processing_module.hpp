@@ -2,11 +2,16 @@
 #define WEBSERV_HTTP_PROCESSING_MODULE_HPP_
 
 #include "http/http_response_encoder.hpp"
+#include "server/blocking_task/blocking_task_pool.hpp"
 #include "server/config/server_config.hpp"
+#include "server/http_processing_module/cgi_limiter.hpp"
+#include "server/http_processing_module/cgi_worker_pool.hpp"
+#include "server/http_processing_module/fastcgi_upstream_pool.hpp"
 #include "server/http_processing_module/request_dispatcher.hpp"
 #include "server/http_processing_module/request_processor.hpp"
 #include "server/http_processing_module/request_router/request_router.hpp"
 #include "server/http_processing_module/session_cgi_handler.hpp"
+#include "server/session/fd_session/http_session/http_response_writer.hpp"
 #include "server/session/fd_session_controller.hpp"
 #include "utils/result.hpp"
 
@@ -17,28 +22,41 @@ struct SessionContext;
 
 struct HttpProcessingModule
 {
+    // 他のメンバー（processor 等）より後に破棄されるよう先頭に置く
+    BlockingTaskPool blocking_tasks;
     RequestRouter router;
+    FastCgiUpstreamPool fastcgi_upstreams;
+    CgiWorkerPool cgi_workers;
+    CgiLimiter cgi_limiter;
     SessionCgiHandler cgi_handler;
     RequestDispatcher dispatcher;
     RequestProcessor processor;
 
     explicit HttpProcessingModule(
         const ServerConfig& config, FdSessionController& controller)
-        : router(config),
-          cgi_handler(controller),
+        : blocking_tasks(),
+          router(config),
+          fastcgi_upstreams(controller),
+          cgi_workers(fastcgi_upstreams),
+          cgi_limiter(controller),
+          cgi_handler(controller, fastcgi_upstreams, cgi_workers),
           dispatcher(router),
-          processor(router)
+          processor(router, blocking_tasks)
     {
     }
 
     http::HttpResponseEncoder::Options makeEncoderOptions(
         const http::HttpRequest& request);
+    HttpResponseWriter::CompressionOptions makeCompressionOptions(
+        const http::HttpRequest& request, const IPAddress& server_ip,
+        const PortType& server_port) const;
     utils::result::Result<void> setSimpleErrorResponse(
         http::HttpResponse& response, http::HttpStatus status);
     utils::result::Result<void> buildErrorOutput(SessionContext& context,
         http::HttpStatus status, RequestProcessor::Output* out);
     utils::result::Result<void> buildProcessorOutputOrServerError(
-        SessionContext& context, RequestProcessor::Output* out);
+        SessionContext& context, RequestProcessor::Output* out,
+        bool may_defer);
 
    private:
     HttpProcessingModule();
@@ -17,6 +17,28 @@ http::HttpResponseEncoder::Options HttpProcessingModule::makeEncoderOptions(
     return opt;
 }
 
+// クライアントが gzip を受理し、location で gzip が有効な場合のみ有効にする
+HttpResponseWriter::CompressionOptions
+HttpProcessingModule::makeCompressionOptions(const http::HttpRequest& request,
+    const IPAddress& server_ip, const PortType& server_port) const
+{
+    HttpResponseWriter::CompressionOptions opt;
+    if (!request.acceptsContentCoding("gzip"))
+        return opt;
+
+    Result<LocationRouting> route =
+        router.route(request, server_ip, server_port);
+    if (route.isError())
+        return opt;
+
+    const GzipContext gz = route.unwrap().getGzipContext();
+    opt.enabled = gz.enabled;
+    opt.level = gz.comp_level;
+    opt.min_length = gz.min_length;
+    opt.types = gz.types;
+    return opt;
+}
+
 Result<void> HttpProcessingModule::setSimpleErrorResponse(
     http::HttpResponse& response, http::HttpStatus status)
 {
@@ -55,7 +77,7 @@ Result<void> HttpProcessingModule::buildErrorOutput(SessionContext& context,
 }
 
 Result<void> HttpProcessingModule::buildProcessorOutputOrServerError(
-    SessionContext& context, RequestProcessor::Output* out)
+    SessionContext& context, RequestProcessor::Output* out, bool may_defer)
 {
     // ボディが大きすぎる場合は、パーサがストリーム同期のために最後まで
     // 読み飛ばして complete にしている。
@@ -72,10 +94,19 @@ Result<void> HttpProcessingModule::buildProcessorOutputOrServerError(
     }
 
     Result<RequestProcessor::Output> pr =
-        processor.process(context.request, context.socket_fd.getServerIp(),
-            context.socket_fd.getServerPort(), context.response);
+        may_defer ? processor.processOrDefer(context.request,
+                        context.socket_fd.getServerIp(),
+                        context.socket_fd.getServerPort(), context.response)
+                  : processor.process(context.request,
+                        context.socket_fd.getServerIp(),
+                        context.socket_fd.getServerPort(), context.response);
     if (pr.isOk())
     {
+        // unwrap() はコピーを返し、OwnedPtr の所有権が移るので一度だけ呼ぶ
+        *out = pr.unwrap();
+        // 応答はまだ無い（blocking_task の完了後にやり直す）
+        if (out->blocking_task.get() != NULL)
+            return Result<void>();
         // 成功時、201(Created) ならばアップロードが成功したとみなして
         // body_store を commit する。
         if (context.request.getMethod() == http::HttpMethod::POST &&
@@ -83,7 +114,6 @@ Result<void> HttpProcessingModule::buildProcessorOutputOrServerError(
         {
             context.request_handler.bodyStore().commit();
         }
-        *out = pr.unwrap();
         return Result<void>();
     }
 
@@ -10,6 +10,7 @@ struct SessionContext;
 class RequestRouter;
 class IRequestAction;
 class IoBuffer;
+class BlockingTask;
 
 class RequestDispatcher
 {
@@ -18,11 +19,15 @@ class RequestDispatcher
 
     utils::result::Result<void> consumeFromRecvBuffer(SessionContext& ctx);
     utils::result::Result<IRequestAction*> dispatch(SessionContext& ctx);
+    // dispatch() 等が返した BlockingTask の完了後、処理を再開する
+    IRequestAction* resumeAfterBlockingTask(
+        SessionContext& ctx, const BlockingTask& task);
 
    private:
     const RequestRouter& router_;
+    // 保存にブロッキングなコピーが必要な場合は *out_task にタスクを返す
     utils::result::Result<void> finalizeUploadStoreIfNeeded_(
-        SessionContext& ctx);
+        SessionContext& ctx, BlockingTask** out_task);
 };
 
 }  // namespace server
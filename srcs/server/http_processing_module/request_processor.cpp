@@ -7,14 +7,15 @@ namespace server
 
 using utils::result::Result;
 
-RequestProcessor::RequestProcessor(const RequestRouter& router)
+RequestProcessor::RequestProcessor(
+    const RequestRouter& router, BlockingTaskPool& blocking_tasks)
     : router_(router),
       autoindex_renderer_(),
       error_renderer_(),
       internal_redirect_(),
-      file_responder_(),
+      file_responder_(router.mimeTypes()),
       handler_factory_(router_, autoindex_renderer_, error_renderer_,
-          internal_redirect_, file_responder_)
+          internal_redirect_, file_responder_, blocking_tasks)
 {
 }
 
@@ -23,9 +24,25 @@ RequestProcessor::~RequestProcessor() {}
 Result<RequestProcessor::Output> RequestProcessor::process(
     const http::HttpRequest& request, const IPAddress& server_ip,
     const PortType& server_port, http::HttpResponse& out_response)
+{
+    return process_(request, server_ip, server_port, out_response, false);
+}
+
+Result<RequestProcessor::Output> RequestProcessor::processOrDefer(
+    const http::HttpRequest& request, const IPAddress& server_ip,
+    const PortType& server_port, http::HttpResponse& out_response)
+{
+    return process_(request, server_ip, server_port, out_response, true);
+}
+
+Result<RequestProcessor::Output> RequestProcessor::process_(
+    const http::HttpRequest& request, const IPAddress& server_ip,
+    const PortType& server_port, http::HttpResponse& out_response,
+    bool may_defer)
 {
     // 内部リダイレクトを最小限サポートする（error_page の内部URI等）
     ProcessingState state(request);
+    state.may_defer = may_defer;
     for (int redirect_guard = 0; redirect_guard < 5; ++redirect_guard)
     {
         Result<LocationRouting> route_result =
@@ -52,6 +69,8 @@ Result<RequestProcessor::Output> RequestProcessor::process(
             return Result<Output>(ERROR, handled.getErrorMessage());
 
         HandlerResult result = handled.unwrap();
+        if (result.output.blocking_task.get() != NULL)
+            return result.output;
         if (result.should_continue)
         {
             // 内部リダイレクト（error_page の内部URI等）で次のリクエストへ
@@ -70,6 +89,8 @@ Result<RequestProcessor::Output> RequestProcessor::process(
             (void)out_response.setHeader(
                 "Allow", state.preserved_allow_header_value);
         }
+        // 最終的に応答した location の add_header
+        (void)out_response.setPreformattedHeaders(route.addHeaderBlock());
         return result.output;
     }
 
@@ -3,6 +3,7 @@
 
 #include "http/http_request.hpp"
 #include "http/http_response.hpp"
+#include "server/blocking_task/blocking_task_pool.hpp"
 #include "server/http_processing_module/request_processor/action_handler_factory.hpp"
 #include "server/http_processing_module/request_processor/autoindex_renderer.hpp"
 #include "server/http_processing_module/request_processor/error_page_renderer.hpp"
@@ -26,13 +27,21 @@ class RequestProcessor
    public:
     typedef RequestProcessorOutput Output;
 
-    explicit RequestProcessor(const RequestRouter& router);
+    RequestProcessor(
+        const RequestRouter& router, BlockingTaskPool& blocking_tasks);
     ~RequestProcessor();
 
     Result<Output> process(const http::HttpRequest& request,
         const IPAddress& server_ip, const PortType& server_port,
         http::HttpResponse& out_response);
 
+    // process() と同じだが、ディレクトリ走査などのブロッキング処理が
+    // 必要な場合は Output::blocking_task を返す（レスポンスは未完成）。
+    // 呼び出し側はタスクの完了後に process() をやり直す。
+    Result<Output> processOrDefer(const http::HttpRequest& request,
+        const IPAddress& server_ip, const PortType& server_port,
+        http::HttpResponse& out_response);
+
     // パースエラー等で「明示的にエラーステータスが決まっている」場合に
     // error_page を適用してレスポンス（body含む）を生成する。
     // - error_page が内部URIの場合は、そのURIの静的コンテンツを返しつつ
@@ -50,6 +59,10 @@ class RequestProcessor
     StaticFileResponder file_responder_;
     ActionHandlerFactory handler_factory_;
 
+    Result<Output> process_(const http::HttpRequest& request,
+        const IPAddress& server_ip, const PortType& server_port,
+        http::HttpResponse& out_response, bool may_defer);
+
     RequestProcessor();
     RequestProcessor(const RequestProcessor& rhs);
     RequestProcessor& operator=(const RequestProcessor& rhs);
@@ -21,12 +21,16 @@ struct ProcessingState
     bool has_preserved_allow_header;
     std::string preserved_allow_header_value;
 
+    // ブロッキング処理を Output::blocking_task として返してよいか
+    bool may_defer;
+
     explicit ProcessingState(const http::HttpRequest& request)
         : current(request),
           has_preserved_error_status(false),
           preserved_error_status(http::HttpStatus::OK),
           has_preserved_allow_header(false),
-          preserved_allow_header_value()
+          preserved_allow_header_value(),
+          may_defer(false)
     {
     }
 };
@@ -12,14 +12,14 @@ namespace server
 ActionHandlerFactory::ActionHandlerFactory(const RequestRouter& router,
     AutoIndexRenderer& autoindex_renderer, ErrorPageRenderer& error_renderer,
     InternalRedirectResolver& internal_redirect,
-    StaticFileResponder& file_responder)
+    StaticFileResponder& file_responder, BlockingTaskPool& blocking_tasks)
     : internal_redirect_handler_(new InternalRedirectHandler()),
       redirect_external_handler_(new RedirectExternalHandler()),
       respond_error_handler_(new RespondErrorHandler(error_renderer)),
       store_body_handler_(new StoreBodyHandler(error_renderer)),
       static_autoindex_handler_(
           new StaticAutoIndexHandler(router, autoindex_renderer, error_renderer,
-              internal_redirect, file_responder))
+              internal_redirect, file_responder, blocking_tasks))
 {
 }
 
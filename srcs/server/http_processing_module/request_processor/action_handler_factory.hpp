@@ -7,6 +7,7 @@ namespace server
 {
 
 class AutoIndexRenderer;
+class BlockingTaskPool;
 class ErrorPageRenderer;
 class InternalRedirectResolver;
 class StaticFileResponder;
@@ -19,7 +20,7 @@ class ActionHandlerFactory
         AutoIndexRenderer& autoindex_renderer,
         ErrorPageRenderer& error_renderer,
         InternalRedirectResolver& internal_redirect,
-        StaticFileResponder& file_responder);
+        StaticFileResponder& file_responder, BlockingTaskPool& blocking_tasks);
 
     ActionHandler* getHandler(ActionType action);
 
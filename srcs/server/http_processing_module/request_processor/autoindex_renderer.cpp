@@ -4,6 +4,7 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <ctime>
 
 #include "server/http_processing_module/request_processor/config_text_loader.hpp"
 
@@ -12,6 +13,76 @@ namespace server
 
 using utils::result::Result;
 
+namespace
+{
+
+// テンプレートのスロット（names の並びが render 時の values の並び）
+enum PageSlot
+{
+    kPageCss,
+    kPageTitle,
+    kPagePath,
+    kPageEntries,
+    kPageSlotCount
+};
+const char* const kPageSlotNames[kPageSlotCount] = {
+    "CSS", "TITLE", "PATH", "ENTRIES"};
+
+enum EntrySlot
+{
+    kEntryHref,
+    kEntryLabel,
+    kEntrySlotCount
+};
+const char* const kEntrySlotNames[kEntrySlotCount] = {"HREF", "LABEL"};
+
+}  // namespace
+
+const unsigned long AutoIndexRenderer::kListingCacheCapacityBytes;
+
+AutoIndexRenderer::AutoIndexRenderer()
+    : listings_(kListingCacheCapacityBytes),
+      has_prefetched_(false),
+      prefetched_dir_(),
+      prefetched_st_(),
+      prefetched_entries_(),
+      css_(),
+      page_tmpl_(),
+      entry_tmpl_(),
+      parent_entry_tmpl_(),
+      templates_loaded_(false)
+{
+}
+
+AutoIndexRenderer::~AutoIndexRenderer() {}
+
+AutoIndexRenderer::ScanTask::ScanTask(
+    AutoIndexRenderer& owner, const std::string& dir)
+    : owner_(owner), dir_(dir), st_(), entries_(), scanned_(false)
+{
+}
+
+AutoIndexRenderer::ScanTask::~ScanTask() {}
+
+// ワーカースレッドで実行される。owner_ には触れない。
+void AutoIndexRenderer::ScanTask::run()
+{
+    scanned_ =
+        ::stat(dir_.c_str(), &st_) == 0 && scanDirectory_(dir_, &entries_);
+}
+
+void AutoIndexRenderer::ScanTask::complete()
+{
+    // 失敗時は何も渡さず、buildBody() が改めて同期的に走査して
+    // エラーを判定する（タスク自体はエラーにしない）
+    if (!scanned_)
+        return;
+    owner_.has_prefetched_ = true;
+    owner_.prefetched_dir_ = dir_;
+    owner_.prefetched_st_ = st_;
+    owner_.prefetched_entries_.swap(entries_);
+}
+
 std::string AutoIndexRenderer::htmlEscape_(const std::string& s)
 {
     std::string out;
@@ -85,76 +156,73 @@ std::string AutoIndexRenderer::parentUriPath_(const std::string& uri_dir_path)
     return p.substr(0, last + 1);
 }
 
-void AutoIndexRenderer::replaceAll_(
-    std::string* inout, const std::string& from, const std::string& to)
-{
-    if (inout == NULL)
-        return;
-    if (from.empty())
-        return;
-
-    std::string& s = *inout;
-    std::string::size_type pos = 0;
-    while ((pos = s.find(from, pos)) != std::string::npos)
-    {
-        s.replace(pos, from.size(), to);
-        pos += to.size();
-    }
-}
-
-std::string AutoIndexRenderer::renderTemplate_(const std::string& tmpl,
-    const std::vector<std::pair<std::string, std::string> >& replacements)
-{
-    std::string out = tmpl;
-    for (size_t i = 0; i < replacements.size(); ++i)
-    {
-        replaceAll_(&out, replacements[i].first, replacements[i].second);
-    }
-    return out;
-}
-
-std::string AutoIndexRenderer::loadAutoIndexCss_()
+std::string AutoIndexRenderer::loadText_(const std::string& file_name)
 {
-    Result<std::string> r = ConfigTextLoader::load("autoindex.css");
+    Result<std::string> r = ConfigTextLoader::load(file_name);
     if (r.isOk())
         return r.unwrap();
     return std::string();
 }
 
-std::string AutoIndexRenderer::loadAutoIndexTemplate_()
+bool AutoIndexRenderer::loadTemplates_()
 {
-    Result<std::string> r = ConfigTextLoader::load("autoindex.html");
-    if (r.isOk())
-        return r.unwrap();
-    return std::string();
+    if (templates_loaded_)
+        return true;
+
+    css_ = loadText_("autoindex.css");
+    page_tmpl_.compile(
+        loadText_("autoindex.html"), kPageSlotNames, kPageSlotCount);
+    entry_tmpl_.compile(
+        loadText_("autoindex_entry.html"), kEntrySlotNames, kEntrySlotCount);
+    parent_entry_tmpl_.compile(loadText_("autoindex_parent_entry.html"),
+        kEntrySlotNames, kEntrySlotCount);
+    // 欠けていれば次回また読み直す
+    templates_loaded_ = !css_.empty() && !page_tmpl_.empty() &&
+                        !entry_tmpl_.empty() && !parent_entry_tmpl_.empty();
+    return templates_loaded_;
 }
 
-std::string AutoIndexRenderer::loadAutoIndexEntryTemplate_()
+BlockingTask* AutoIndexRenderer::newScanTaskIfNeeded(
+    const AutoIndexContext& ctx)
 {
-    Result<std::string> r = ConfigTextLoader::load("autoindex_entry.html");
-    if (r.isOk())
-        return r.unwrap();
-    return std::string();
+    if (!loadTemplates_())
+        return NULL;
+
+    const std::string dir = ctx.directory_path.str();
+    struct stat st;
+    if (::stat(dir.c_str(), &st) != 0)
+        return NULL;
+    SharedBytes cached;
+    if (listings_.lookup(dir + '\n' + ctx.uri_dir_path, st, &cached))
+        return NULL;
+    return new ScanTask(*this, dir);
 }
 
-std::string AutoIndexRenderer::loadAutoIndexParentEntryTemplate_()
+// 走査後にディレクトリが変わっていなければ、先読みした結果を使う
+bool AutoIndexRenderer::takePrefetched_(const std::string& dir,
+    const struct stat& st, std::vector<ScanEntry>* out)
 {
-    Result<std::string> r =
-        ConfigTextLoader::load("autoindex_parent_entry.html");
-    if (r.isOk())
-        return r.unwrap();
-    return std::string();
+    if (!has_prefetched_ || prefetched_dir_ != dir)
+        return false;
+    has_prefetched_ = false;
+    if (prefetched_st_.st_mtime != st.st_mtime ||
+        prefetched_st_.st_ino != st.st_ino || prefetched_st_.st_dev != st.st_dev)
+    {
+        prefetched_entries_.clear();
+        return false;
+    }
+    out->swap(prefetched_entries_);
+    prefetched_entries_.clear();
+    return true;
 }
 
-Result<std::string> AutoIndexRenderer::buildBody(
-    const AutoIndexContext& ctx) const
+bool AutoIndexRenderer::scanDirectory_(
+    const std::string& dir, std::vector<ScanEntry>* out)
 {
-    const std::string dir = ctx.directory_path.str();
     DIR* dp = ::opendir(dir.c_str());
     if (dp == NULL)
-        return Result<std::string>(ERROR, std::string(), "opendir failed");
+        return false;
 
-    std::vector<std::string> entries;
     for (;;)
     {
         struct dirent* de = ::readdir(dp);
@@ -165,72 +233,98 @@ Result<std::string> AutoIndexRenderer::buildBody(
             continue;
         if (name == "." || name == "..")
             continue;
-        entries.push_back(name);
+        ScanEntry e;
+        e.name = name;
+        e.is_dir = false;
+        out->push_back(e);
     }
     ::closedir(dp);
 
-    std::sort(entries.begin(), entries.end());
+    std::sort(out->begin(), out->end());
+
+    for (size_t i = 0; i < out->size(); ++i)
+    {
+        const std::string entry_physical = dir + "/" + (*out)[i].name;
+        struct stat st;
+        if (::stat(entry_physical.c_str(), &st) == 0)
+            (*out)[i].is_dir = S_ISDIR(st.st_mode);
+    }
+    return true;
+}
+
+Result<SharedBytes> AutoIndexRenderer::buildBody(const AutoIndexContext& ctx)
+{
+    if (!loadTemplates_())
+    {
+        return Result<SharedBytes>(
+            ERROR, SharedBytes(), "autoindex template/css missing");
+    }
+
+    const std::string dir = ctx.directory_path.str();
+    struct stat st;
+    if (::stat(dir.c_str(), &st) != 0)
+        return Result<SharedBytes>(ERROR, SharedBytes(), "opendir failed");
 
+    // 同じディレクトリでも URI が違えばリンク先が変わる
+    const std::string key = dir + '\n' + ctx.uri_dir_path;
+    SharedBytes cached;
+    if (listings_.lookup(key, st, &cached))
+        return cached;
+
+    std::vector<ScanEntry> entries;
+    if (!takePrefetched_(dir, st, &entries) && !scanDirectory_(dir, &entries))
+        return Result<SharedBytes>(ERROR, SharedBytes(), "opendir failed");
+
+    const std::string body = renderListing_(ctx, entries);
+    SharedBytes bytes(new std::vector<utils::Byte>(body.begin(), body.end()));
+    // mtime は秒単位なので、同じ秒のうちに変更され得るものは保存しない
+    if (st.st_mtime < std::time(NULL) - 1)
+        listings_.store(key, st, bytes);
+    return bytes;
+}
+
+std::string AutoIndexRenderer::renderListing_(const AutoIndexContext& ctx,
+    const std::vector<ScanEntry>& entries) const
+{
     std::string uri = ctx.uri_dir_path;
     if (uri.empty() || uri[0] != '/')
         uri = "/";
     if (uri[uri.size() - 1] != '/')
         uri += "/";
 
-    const std::string css = loadAutoIndexCss_();
-    const std::string tmpl = loadAutoIndexTemplate_();
-    const std::string entry_tmpl = loadAutoIndexEntryTemplate_();
-    const std::string parent_entry_tmpl = loadAutoIndexParentEntryTemplate_();
-
-    if (css.empty() || tmpl.empty() || entry_tmpl.empty() ||
-        parent_entry_tmpl.empty())
-    {
-        return Result<std::string>(
-            ERROR, std::string(), "autoindex template/css missing");
-    }
-
     std::string entries_html;
     if (uri != "/")
     {
-        const std::string parent = parentUriPath_(uri);
-        std::string row = parent_entry_tmpl;
-        std::vector<std::pair<std::string, std::string> > repl;
-        repl.push_back(std::make_pair("{{HREF}}", htmlEscape_(parent)));
-        entries_html += renderTemplate_(row, repl);
+        const std::string href = htmlEscape_(parentUriPath_(uri));
+        const std::string empty;
+        const std::string* values[kEntrySlotCount] = {&href, &empty};
+        parent_entry_tmpl_.render(values, &entries_html);
     }
 
     for (size_t i = 0; i < entries.size(); ++i)
     {
-        const std::string& name = entries[i];
-        const std::string entry_physical = dir + "/" + name;
-        struct stat st;
-        bool is_dir = false;
-        if (::stat(entry_physical.c_str(), &st) == 0)
-            is_dir = S_ISDIR(st.st_mode);
-
+        const std::string& name = entries[i].name;
         std::string href = uri + percentEncodeUriComponent_(name);
         std::string label = name;
-        if (is_dir)
+        if (entries[i].is_dir)
         {
             href += "/";
             label += "/";
         }
 
-        std::string row = entry_tmpl;
-        std::vector<std::pair<std::string, std::string> > repl;
-        repl.push_back(std::make_pair("{{HREF}}", htmlEscape_(href)));
-        repl.push_back(std::make_pair("{{LABEL}}", htmlEscape_(label)));
-        entries_html += renderTemplate_(row, repl);
+        const std::string href_html = htmlEscape_(href);
+        const std::string label_html = htmlEscape_(label);
+        const std::string* values[kEntrySlotCount] = {&href_html, &label_html};
+        entry_tmpl_.render(values, &entries_html);
     }
 
-    const std::string title = std::string("Index of ") + uri;
-
-    std::vector<std::pair<std::string, std::string> > replacements;
-    replacements.push_back(std::make_pair("{{CSS}}", css));
-    replacements.push_back(std::make_pair("{{TITLE}}", htmlEscape_(title)));
-    replacements.push_back(std::make_pair("{{PATH}}", htmlEscape_(uri)));
-    replacements.push_back(std::make_pair("{{ENTRIES}}", entries_html));
-    return renderTemplate_(tmpl, replacements);
+    const std::string title_html = htmlEscape_(std::string("Index of ") + uri);
+    const std::string path_html = htmlEscape_(uri);
+    const std::string* values[kPageSlotCount] = {
+        &css_, &title_html, &path_html, &entries_html};
+    std::string out;
+    page_tmpl_.render(values, &out);
+    return out;
 }
 
 }  // namespace server
@@ -2,34 +2,102 @@
 #define WEBSERV_AUTOINDEX_RENDERER_HPP_
 
 #include <string>
-#include <utility>
 #include <vector>
 
+#include <sys/stat.h>
+
+#include "server/blocking_task/blocking_task.hpp"
+#include "server/http_processing_module/request_processor/static_file_cache.hpp"
+#include "server/http_processing_module/request_processor/text_template.hpp"
 #include "server/http_processing_module/request_router/location_routing.hpp"
+#include "server/session/fd_session/http_session/body_source.hpp"
 #include "utils/result.hpp"
 
 namespace server
 {
 
+// ディレクトリ一覧ページを生成する。
+// 生成結果は (ディレクトリ, URI) ごとにキャッシュし、ディレクトリの
+// mtime/inode が変わらない限り readdir/stat をせずに返す。
+// キャッシュに無い場合の readdir/stat は newScanTaskIfNeeded() の
+// タスクとしてワーカーで先に済ませておける。
 class AutoIndexRenderer
 {
    public:
-    utils::result::Result<std::string> buildBody(
-        const AutoIndexContext& ctx) const;
+    // キャッシュする一覧ページの合計サイズの上限
+    static const unsigned long kListingCacheCapacityBytes =
+        8ul * 1024ul * 1024ul;
+
+    AutoIndexRenderer();
+    ~AutoIndexRenderer();
+
+    utils::result::Result<SharedBytes> buildBody(const AutoIndexContext& ctx);
+
+    // buildBody() がディレクトリを走査することになる場合、その走査を行う
+    // タスクを返す（不要なら NULL）。タスクの完了後に buildBody() を呼ぶと
+    // 走査結果が使われる。
+    BlockingTask* newScanTaskIfNeeded(const AutoIndexContext& ctx);
 
    private:
+    struct ScanEntry
+    {
+        std::string name;
+        bool is_dir;
+
+        bool operator<(const ScanEntry& rhs) const { return name < rhs.name; }
+    };
+
+    // run() はワーカーで走査だけを行い、complete() で結果を渡す
+    class ScanTask : public BlockingTask
+    {
+       public:
+        ScanTask(AutoIndexRenderer& owner, const std::string& dir);
+        virtual ~ScanTask();
+
+        virtual void run();
+        virtual void complete();
+
+       private:
+        AutoIndexRenderer& owner_;
+        std::string dir_;
+        struct stat st_;
+        std::vector<ScanEntry> entries_;
+        bool scanned_;
+
+        ScanTask(const ScanTask& rhs);
+        ScanTask& operator=(const ScanTask& rhs);
+    };
+
+    StaticFileCache listings_;
+    // 直近に完了した ScanTask の結果（1件だけ）
+    bool has_prefetched_;
+    std::string prefetched_dir_;
+    struct stat prefetched_st_;
+    std::vector<ScanEntry> prefetched_entries_;
+    // テンプレートは初回に一度だけ読み込んでコンパイルする
+    std::string css_;
+    TextTemplate page_tmpl_;
+    TextTemplate entry_tmpl_;
+    TextTemplate parent_entry_tmpl_;
+    bool templates_loaded_;
+
+    bool loadTemplates_();
+    bool takePrefetched_(const std::string& dir, const struct stat& st,
+        std::vector<ScanEntry>* out);
+    std::string renderListing_(const AutoIndexContext& ctx,
+        const std::vector<ScanEntry>& entries) const;
+
+    static bool scanDirectory_(
+        const std::string& dir, std::vector<ScanEntry>* out);
+
     static std::string htmlEscape_(const std::string& s);
     static bool isUnreservedUriChar_(unsigned char c);
     static std::string percentEncodeUriComponent_(const std::string& s);
     static std::string parentUriPath_(const std::string& uri_dir_path);
-    static void replaceAll_(
-        std::string* inout, const std::string& from, const std::string& to);
-    static std::string renderTemplate_(const std::string& tmpl,
-        const std::vector<std::pair<std::string, std::string> >& replacements);
-    static std::string loadAutoIndexCss_();
-    static std::string loadAutoIndexTemplate_();
-    static std::string loadAutoIndexEntryTemplate_();
-    static std::string loadAutoIndexParentEntryTemplate_();
+    static std::string loadText_(const std::string& file_name);
+
+    AutoIndexRenderer(const AutoIndexRenderer& rhs);
+    AutoIndexRenderer& operator=(const AutoIndexRenderer& rhs);
 };
 
 }  // namespace server
@@ -12,6 +12,30 @@ namespace server
 
 using utils::result::Result;
 
+namespace
+{
+
+// テンプレートのスロット（names の並びが render 時の values の並び）
+enum PageSlot
+{
+    kPageCss,
+    kPageCode,
+    kPageStatusLine,
+    kPageMessage,
+    kPageSlotCount
+};
+const char* const kPageSlotNames[kPageSlotCount] = {
+    "CSS", "CODE", "STATUS_LINE", "MESSAGE"};
+
+}  // namespace
+
+ErrorPageRenderer::ErrorPageRenderer()
+    : rendered_(), css_(), page_tmpl_(), template_loaded_(false)
+{
+}
+
+ErrorPageRenderer::~ErrorPageRenderer() {}
+
 std::string ErrorPageRenderer::htmlEscape_(const std::string& s)
 {
     std::string out;
@@ -33,62 +57,62 @@ std::string ErrorPageRenderer::htmlEscape_(const std::string& s)
     return out;
 }
 
-std::string ErrorPageRenderer::buildDefaultErrorPageBody_(
-    const http::HttpStatus& status) const
+bool ErrorPageRenderer::loadTemplate_()
 {
-    std::string css;
-    {
-        Result<std::string> r = ConfigTextLoader::load("error_page.css");
-        if (r.isOk())
-            css = r.unwrap();
-    }
-    std::string tmpl;
-    {
-        Result<std::string> r = ConfigTextLoader::load("error_page.html");
-        if (r.isOk())
-            tmpl = r.unwrap();
-    }
+    if (template_loaded_)
+        return true;
+
+    Result<std::string> css = ConfigTextLoader::load("error_page.css");
+    css_ = css.isOk() ? css.unwrap() : std::string();
+    Result<std::string> tmpl = ConfigTextLoader::load("error_page.html");
+    if (tmpl.isError())
+        return false;
+    page_tmpl_.compile(tmpl.unwrap(), kPageSlotNames, kPageSlotCount);
+    template_loaded_ = true;
+    return true;
+}
 
+std::string ErrorPageRenderer::buildDefaultErrorPageBody_(
+    const http::HttpStatus& status)
+{
     std::ostringstream oss;
     oss << status.getCode() << " " << status.getMessage();
     const std::string status_line = oss.str();
 
-    std::ostringstream code_oss;
-    code_oss << status.getCode();
-    const std::string code_str = code_oss.str();
-
-    if (tmpl.empty())
+    if (!loadTemplate_())
     {
         // 最終フォールバック（HTMLテンプレが無い場合でも何か返す）
         return status_line + "\n";
     }
 
-    std::vector<std::pair<std::string, std::string> > replacements;
-    replacements.push_back(std::make_pair("{{CSS}}", css));
-    replacements.push_back(std::make_pair("{{CODE}}", htmlEscape_(code_str)));
-    replacements.push_back(
-        std::make_pair("{{STATUS_LINE}}", htmlEscape_(status_line)));
-    replacements.push_back(
-        std::make_pair("{{MESSAGE}}", htmlEscape_(status.getMessage())));
-
-    // 簡易テンプレート置換
-    std::string out = tmpl;
-    for (size_t i = 0; i < replacements.size(); ++i)
-    {
-        const std::string& from = replacements[i].first;
-        const std::string& to = replacements[i].second;
-        std::string::size_type pos = 0;
-        while ((pos = out.find(from, pos)) != std::string::npos)
-        {
-            out.replace(pos, from.size(), to);
-            pos += to.size();
-        }
-    }
+    std::ostringstream code_oss;
+    code_oss << status.getCode();
+    const std::string code_html = htmlEscape_(code_oss.str());
+    const std::string status_line_html = htmlEscape_(status_line);
+    const std::string message_html = htmlEscape_(status.getMessage());
+
+    const std::string* values[kPageSlotCount] = {
+        &css_, &code_html, &status_line_html, &message_html};
+    std::string out;
+    page_tmpl_.render(values, &out);
     return out;
 }
 
+const SharedBytes& ErrorPageRenderer::defaultErrorPageBody_(
+    const http::HttpStatus& status)
+{
+    const unsigned long code = status.toInt();
+    std::map<unsigned long, SharedBytes>::iterator it = rendered_.find(code);
+    if (it != rendered_.end())
+        return it->second;
+
+    const std::string body = buildDefaultErrorPageBody_(status);
+    SharedBytes bytes(new std::vector<utils::Byte>(body.begin(), body.end()));
+    return rendered_.insert(std::make_pair(code, bytes)).first->second;
+}
+
 Result<RequestProcessorOutput> ErrorPageRenderer::respond(
-    const http::HttpStatus& status, http::HttpResponse& out_response) const
+    const http::HttpStatus& status, http::HttpResponse& out_response)
 {
     RequestProcessorOutput out;
 
@@ -96,12 +120,12 @@ Result<RequestProcessorOutput> ErrorPageRenderer::respond(
     if (s.isError())
         return Result<RequestProcessorOutput>(ERROR, s.getErrorMessage());
 
-    const std::string body = buildDefaultErrorPageBody_(status);
+    const SharedBytes& body = defaultErrorPageBody_(status);
     (void)out_response.setHeader("Content-Type", "text/html");
     (void)out_response.setExpectedContentLength(
-        static_cast<unsigned long>(body.size()));
+        static_cast<unsigned long>(body->size()));
 
-    out.body_source.reset(new StringBodySource(body));
+    out.body_source.reset(new SharedBytesBodySource(body, 0, body->size()));
     out.should_close_connection = false;
     return out;
 }
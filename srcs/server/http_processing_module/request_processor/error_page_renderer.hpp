@@ -1,25 +1,43 @@
 #ifndef WEBSERV_ERROR_PAGE_RENDERER_HPP_
 #define WEBSERV_ERROR_PAGE_RENDERER_HPP_
 
+#include <map>
 #include <string>
 
 #include "http/http_response.hpp"
 #include "server/http_processing_module/request_processor/request_processor_output.hpp"
+#include "server/http_processing_module/request_processor/text_template.hpp"
+#include "server/session/fd_session/http_session/body_source.hpp"
 #include "utils/result.hpp"
 
 namespace server
 {
 
+// デフォルトのエラーページを返す。
+// ページはステータスごとに初回だけ組み立て、以後はメモリ上の本文を共有する。
 class ErrorPageRenderer
 {
    public:
+    ErrorPageRenderer();
+    ~ErrorPageRenderer();
+
     utils::result::Result<RequestProcessorOutput> respond(
-        const http::HttpStatus& status, http::HttpResponse& out_response) const;
+        const http::HttpStatus& status, http::HttpResponse& out_response);
 
    private:
-    std::string buildDefaultErrorPageBody_(
-        const http::HttpStatus& status) const;
+    // status code -> 組み立て済みの本文
+    std::map<unsigned long, SharedBytes> rendered_;
+    std::string css_;
+    TextTemplate page_tmpl_;
+    bool template_loaded_;
+
+    const SharedBytes& defaultErrorPageBody_(const http::HttpStatus& status);
+    bool loadTemplate_();
+    std::string buildDefaultErrorPageBody_(const http::HttpStatus& status);
     static std::string htmlEscape_(const std::string& s);
+
+    ErrorPageRenderer(const ErrorPageRenderer& rhs);
+    ErrorPageRenderer& operator=(const ErrorPageRenderer& rhs);
 };
 
 }  // namespace server
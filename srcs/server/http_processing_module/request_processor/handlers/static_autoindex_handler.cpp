@@ -1,10 +1,13 @@
 #include "server/http_processing_module/request_processor/handlers/static_autoindex_handler.hpp"
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <cerrno>
 #include <cstdio>
 
+#include "server/blocking_task/blocking_task_pool.hpp"
 #include "server/http_processing_module/request_processor/autoindex_renderer.hpp"
 #include "server/http_processing_module/request_processor/error_page_renderer.hpp"
 #include "server/http_processing_module/request_processor/internal_redirect_resolver.hpp"
@@ -16,6 +19,35 @@ namespace server
 
 using utils::result::Result;
 
+const long StaticAutoIndexHandler::kBackgroundReleaseMinBytes;
+
+// 大きなファイルは unlink の時点ではなく、最後の参照が閉じられたときに
+// ブロックの解放（ext4 等では数百ms かかり得る）が行われる。
+// そこで unlink 前に O_PATH で参照を1つ持っておき、その close を
+// ワーカーに任せてイベントループが解放を待たないようにする。
+void StaticAutoIndexHandler::removeFile_(
+    const std::string& path, const struct stat& st, int* rc, int* err) const
+{
+    int pin = -1;
+#ifdef __linux__
+    if (st.st_size >= kBackgroundReleaseMinBytes && blocking_tasks_.isRunning())
+        pin = ::open(path.c_str(), O_PATH | O_CLOEXEC | O_NOFOLLOW);
+#else
+    (void)st;
+#endif
+
+    errno = 0;
+    *rc = std::remove(path.c_str());
+    *err = errno;
+
+    if (pin < 0)
+        return;
+    if (*rc == 0)
+        blocking_tasks_.closeInBackground(pin);
+    else
+        ::close(pin);
+}
+
 static bool tryInternalRedirect_(const InternalRedirectResolver& resolver,
     const RequestRouter& router, const IPAddress& server_ip,
     const PortType& server_port, const http::HttpRequest& current,
@@ -146,8 +178,9 @@ Result<HandlerResult> StaticAutoIndexHandler::handle(
             return res;
         }
 
-        errno = 0;
-        const int rc = std::remove(target_path.c_str());
+        int rc = 0;
+        int remove_errno = 0;
+        removeFile_(target_path, st, &rc, &remove_errno);
         if (rc == 0)
         {
             // success
@@ -163,7 +196,7 @@ Result<HandlerResult> StaticAutoIndexHandler::handle(
             return res;
         }
 
-        const http::HttpStatus err = (errno == ENOENT)
+        const http::HttpStatus err = (remove_errno == ENOENT)
                                          ? http::HttpStatus::NOT_FOUND
                                          : http::HttpStatus::FORBIDDEN;
         http::HttpRequest next;
@@ -211,7 +244,8 @@ Result<HandlerResult> StaticAutoIndexHandler::handle(
                         state->has_preserved_error_status
                             ? state->preserved_error_status
                             : http::HttpStatus(http::HttpStatus::OK),
-                        out_response);
+                        state->current, route.isGzipStaticEnabled(),
+                        route.fileCacheMaxSize(), out_response);
                 if (rf.isOk())
                 {
                     HandlerResult res;
@@ -246,7 +280,19 @@ Result<HandlerResult> StaticAutoIndexHandler::handle(
 
             if (ctx.autoindex_enabled)
             {
-                Result<std::string> body = autoindex_renderer_.buildBody(ctx);
+                if (state->may_defer)
+                {
+                    BlockingTask* scan =
+                        autoindex_renderer_.newScanTaskIfNeeded(ctx);
+                    if (scan != NULL)
+                    {
+                        HandlerResult res;
+                        res.output.blocking_task.reset(scan);
+                        return res;
+                    }
+                }
+
+                Result<SharedBytes> body = autoindex_renderer_.buildBody(ctx);
                 if (body.isError())
                 {
                     http::HttpStatus error_status = http::HttpStatus::FORBIDDEN;
@@ -284,11 +330,11 @@ Result<HandlerResult> StaticAutoIndexHandler::handle(
 
                 (void)out_response.setHeader("Content-Type", "text/html");
                 (void)out_response.setExpectedContentLength(
-                    static_cast<unsigned long>(body.unwrap().size()));
+                    static_cast<unsigned long>(body.unwrap()->size()));
 
                 HandlerResult res;
-                res.output.body_source.reset(
-                    new StringBodySource(body.unwrap()));
+                res.output.body_source.reset(new SharedBytesBodySource(
+                    body.unwrap(), 0, body.unwrap()->size()));
                 res.output.should_close_connection = false;
                 return res;
             }
@@ -346,7 +392,8 @@ Result<HandlerResult> StaticAutoIndexHandler::handle(
             state->has_preserved_error_status
                 ? state->preserved_error_status
                 : http::HttpStatus(http::HttpStatus::OK),
-            out_response);
+            state->current, route.isGzipStaticEnabled(),
+            route.fileCacheMaxSize(), out_response);
     if (rf.isError())
     {
         http::HttpStatus err = http::HttpStatus::NOT_FOUND;
@@ -1,12 +1,15 @@
 #ifndef WEBSERV_STATIC_AUTOINDEX_HANDLER_HPP_
 #define WEBSERV_STATIC_AUTOINDEX_HANDLER_HPP_
 
+#include <sys/stat.h>
+
 #include "server/http_processing_module/request_processor/action_handler.hpp"
 
 namespace server
 {
 
 class AutoIndexRenderer;
+class BlockingTaskPool;
 class ErrorPageRenderer;
 class InternalRedirectResolver;
 class StaticFileResponder;
@@ -19,15 +22,19 @@ class StaticAutoIndexHandler : public ActionHandler
         AutoIndexRenderer& autoindex_renderer,
         ErrorPageRenderer& error_renderer,
         InternalRedirectResolver& internal_redirect,
-        StaticFileResponder& file_responder)
+        StaticFileResponder& file_responder, BlockingTaskPool& blocking_tasks)
         : router_(router),
           autoindex_renderer_(autoindex_renderer),
           error_renderer_(error_renderer),
           internal_redirect_(internal_redirect),
-          file_responder_(file_responder)
+          file_responder_(file_responder),
+          blocking_tasks_(blocking_tasks)
     {
     }
 
+    // これ以上のサイズのファイルは、DELETE 後の領域解放をワーカーで行う
+    static const long kBackgroundReleaseMinBytes = 16L * 1024L * 1024L;
+
     virtual utils::result::Result<HandlerResult> handle(
         const LocationRouting& route, const IPAddress& server_ip,
         const PortType& server_port, http::HttpResponse& out_response,
@@ -39,6 +46,10 @@ class StaticAutoIndexHandler : public ActionHandler
     ErrorPageRenderer& error_renderer_;
     InternalRedirectResolver& internal_redirect_;
     StaticFileResponder& file_responder_;
+    BlockingTaskPool& blocking_tasks_;
+
+    void removeFile_(const std::string& path, const struct stat& st, int* rc,
+        int* err) const;
 };
 
 }  // namespace server
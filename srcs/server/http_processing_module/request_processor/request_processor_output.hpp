@@ -1,6 +1,7 @@
 #ifndef WEBSERV_REQUEST_PROCESSOR_OUTPUT_HPP_
 #define WEBSERV_REQUEST_PROCESSOR_OUTPUT_HPP_
 
+#include "server/blocking_task/blocking_task.hpp"
 #include "server/session/fd_session/http_session/body_source.hpp"
 #include "utils/owned_ptr.hpp"
 
@@ -14,8 +15,12 @@ struct RequestProcessorOutput
     utils::OwnedPtr<BodySource> body_source;
     bool should_close_connection;  // HTTP/1.0 等で close-delimited
                                    // が必要な場合
+    // NULL 以外なら応答はまだ無い。このタスク（ディレクトリ走査等）を
+    // ワーカーで実行してから、同じリクエストを処理し直す。
+    utils::OwnedPtr<BlockingTask> blocking_task;
 
-    RequestProcessorOutput() : body_source(NULL), should_close_connection(false)
+    RequestProcessorOutput()
+        : body_source(NULL), should_close_connection(false), blocking_task(NULL)
     {
     }
 };
@@ -0,0 +1,102 @@
+#include "server/http_processing_module/request_processor/static_file_cache.hpp"
+
+#include <unistd.h>
+
+#include <vector>
+
+namespace server
+{
+
+const unsigned long StaticFileCache::kDefaultCapacityBytes;
+
+StaticFileCache::StaticFileCache(unsigned long capacity_bytes)
+    : capacity_bytes_(capacity_bytes), used_bytes_(0), entries_(), index_()
+{
+}
+
+StaticFileCache::~StaticFileCache() {}
+
+bool StaticFileCache::lookup(
+    const std::string& path, const struct stat& st, SharedBytes* out_contents)
+{
+    std::map<std::string, EntryList::iterator>::iterator found =
+        index_.find(path);
+    if (found == index_.end())
+        return false;
+
+    EntryList::iterator it = found->second;
+    if (it->mtime != st.st_mtime || it->size != st.st_size ||
+        it->ino != st.st_ino || it->dev != st.st_dev)
+    {
+        // ファイルが更新されている
+        erase_(it);
+        return false;
+    }
+
+    entries_.splice(entries_.begin(), entries_, it);
+    *out_contents = it->contents;
+    return true;
+}
+
+void StaticFileCache::store(const std::string& path, const struct stat& st,
+    const SharedBytes& contents)
+{
+    if (contents.get() == NULL)
+        return;
+    const unsigned long bytes = static_cast<unsigned long>(contents->size());
+    if (bytes > capacity_bytes_)
+        return;
+
+    std::map<std::string, EntryList::iterator>::iterator found =
+        index_.find(path);
+    if (found != index_.end())
+        erase_(found->second);
+
+    while (!entries_.empty() && used_bytes_ + bytes > capacity_bytes_)
+    {
+        EntryList::iterator last = entries_.end();
+        --last;
+        erase_(last);
+    }
+
+    Entry e;
+    e.path = path;
+    e.mtime = st.st_mtime;
+    e.size = st.st_size;
+    e.ino = st.st_ino;
+    e.dev = st.st_dev;
+    e.contents = contents;
+    entries_.push_front(e);
+    index_[path] = entries_.begin();
+    used_bytes_ += bytes;
+}
+
+bool StaticFileCache::loadFromFd(
+    int fd, const struct stat& st, SharedBytes* out_contents)
+{
+    if (st.st_size < 0)
+        return false;
+    std::vector<utils::Byte>* buf =
+        new std::vector<utils::Byte>(static_cast<size_t>(st.st_size));
+    SharedBytes holder(buf);
+
+    size_t got = 0;
+    while (got < buf->size())
+    {
+        const ssize_t n = ::read(fd, &(*buf)[got], buf->size() - got);
+        if (n <= 0)
+            return false;
+        got += static_cast<size_t>(n);
+    }
+    *out_contents = holder;
+    return true;
+}
+
+void StaticFileCache::erase_(EntryList::iterator it)
+{
+    used_bytes_ -= static_cast<unsigned long>(it->contents->size());
+    index_.erase(it->path);
+    entries_.erase(it);
+}
+
+}  // namespace server
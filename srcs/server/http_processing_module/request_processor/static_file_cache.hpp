@@ -0,0 +1,65 @@
+#ifndef WEBSERV_STATIC_FILE_CACHE_HPP_
+#define WEBSERV_STATIC_FILE_CACHE_HPP_
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "server/session/fd_session/http_session/body_source.hpp"
+
+namespace server
+{
+
+// 小さな静的ファイルの内容を保持する LRU キャッシュ。
+// - キーは解決済みのファイルパス。
+// - 呼び出し側が取った stat（mtime/size/inode）と一致する場合だけヒットする。
+//   mtime は秒単位なので、同じ秒・同じサイズでの書き換えは検出できない。
+// - 内容は SharedBytes で共有するので、追い出し後も送信中の body は有効。
+class StaticFileCache
+{
+   public:
+    // キャッシュ全体で保持する内容の上限
+    static const unsigned long kDefaultCapacityBytes = 32ul * 1024ul * 1024ul;
+
+    explicit StaticFileCache(unsigned long capacity_bytes);
+    ~StaticFileCache();
+
+    bool lookup(const std::string& path, const struct stat& st,
+        SharedBytes* out_contents);
+    void store(const std::string& path, const struct stat& st,
+        const SharedBytes& contents);
+
+    // fd から st.st_size バイトを読み切れたら out_contents に格納する
+    static bool loadFromFd(
+        int fd, const struct stat& st, SharedBytes* out_contents);
+
+   private:
+    struct Entry
+    {
+        std::string path;
+        time_t mtime;
+        off_t size;
+        ino_t ino;
+        dev_t dev;
+        SharedBytes contents;
+    };
+    typedef std::list<Entry> EntryList;  // 先頭が最近使ったもの
+
+    unsigned long capacity_bytes_;
+    unsigned long used_bytes_;
+    EntryList entries_;
+    std::map<std::string, EntryList::iterator> index_;
+
+    void erase_(EntryList::iterator it);
+
+    StaticFileCache();
+    StaticFileCache(const StaticFileCache& rhs);
+    StaticFileCache& operator=(const StaticFileCache& rhs);
+};
+
+}  // namespace server
+
+#endif
@@ -5,57 +5,486 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <climits>
+#include <iomanip>
+#include <sstream>
+#include <vector>
 
-#include "http/content_types.hpp"
 #include "server/session/fd_session/http_session/body_source.hpp"
+#include "utils/timestamp.hpp"
 
 namespace server
 {
 
 using utils::result::Result;
 
-std::string StaticFileResponder::extractExtension_(const std::string& path)
+StaticFileResponder::StaticFileResponder(const http::MimeTypes& mime_types)
+    : mime_types_(mime_types), cache_(StaticFileCache::kDefaultCapacityBytes)
 {
-    const std::string::size_type slash = path.find_last_of('/');
-    const std::string::size_type dot = path.find_last_of('.');
-    if (dot == std::string::npos)
-        return std::string();
-    if (slash != std::string::npos && dot < slash)
-        return std::string();
-    return path.substr(dot);
 }
 
-Result<RequestProcessorOutput> StaticFileResponder::respondFile(
-    const std::string& path, const struct stat& st,
-    const http::HttpStatus& status, http::HttpResponse& out_response) const
+StaticFileResponder::~StaticFileResponder() {}
+
+namespace
+{
+
+struct PrecompressedVariant
+{
+    const char* coding;
+    const char* suffix;
+};
+
+// 圧縮率の高い br を優先する
+const PrecompressedVariant kPrecompressedVariants[] = {
+    {"br", ".br"},
+    {"gzip", ".gz"},
+};
+
+std::string trimOws_(const std::string& s)
+{
+    std::string::size_type b = 0;
+    std::string::size_type e = s.size();
+    while (b < e && (s[b] == ' ' || s[b] == '\t'))
+        ++b;
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t'))
+        --e;
+    return s.substr(b, e - b);
+}
+
+// 1文字以上の10進数字列のみ受け付ける（オーバーフローは不正扱い）
+bool parseDecimal_(const std::string& s, unsigned long* out)
+{
+    if (s.empty())
+        return false;
+    unsigned long v = 0;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+        const unsigned long d = static_cast<unsigned long>(s[i] - '0');
+        if (v > (ULONG_MAX - d) / 10)
+            return false;
+        v = v * 10 + d;
+    }
+    *out = v;
+    return true;
+}
+
+}  // namespace
+
+// 受理可能な事前圧縮ファイルがあれば、そのパスと stat を返す。
+// 元ファイルより古いものは更新漏れとみなして使わない。
+bool StaticFileResponder::selectPrecompressed_(const std::string& path,
+    const struct stat& st, const http::HttpRequest& request,
+    std::string* out_path, struct stat* out_st, std::string* out_encoding)
+{
+    const size_t n =
+        sizeof(kPrecompressedVariants) / sizeof(kPrecompressedVariants[0]);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const PrecompressedVariant& variant = kPrecompressedVariants[i];
+        if (!request.acceptsContentCoding(variant.coding))
+            continue;
+
+        const std::string sibling = path + variant.suffix;
+        struct stat sst;
+        if (::stat(sibling.c_str(), &sst) != 0 || !S_ISREG(sst.st_mode))
+            continue;
+        if (sst.st_mtime < st.st_mtime)
+            continue;
+
+        *out_path = sibling;
+        *out_st = sst;
+        *out_encoding = variant.coding;
+        return true;
+    }
+    return false;
+}
+
+// nginx と同じ "<mtime(16進)>-<size(16進)>" 形式の strong ETag
+std::string StaticFileResponder::makeETag_(const struct stat& st)
 {
+    std::ostringstream oss;
+    oss << '"' << std::hex << static_cast<unsigned long>(st.st_mtime) << '-'
+        << static_cast<unsigned long>(st.st_size) << '"';
+    return oss.str();
+}
+
+// 弱い比較用に W/ を外した opaque-tag 部分
+std::string StaticFileResponder::opaqueTag_(const std::string& tag)
+{
+    if (tag.compare(0, 2, "W/") == 0)
+        return tag.substr(2);
+    return tag;
+}
+
+// RFC 9110 Section 13.1.2 / 13.1.3, 13.2.2（評価順）
+// If-None-Match があれば If-Modified-Since は見ない。
+bool StaticFileResponder::isNotModified_(const http::HttpRequest& request,
+    const std::string& etag, long last_modified)
+{
+    Result<const std::vector<std::string>&> inm =
+        request.getHeader("If-None-Match");
+    if (inm.isOk())
+    {
+        const std::vector<std::string>& values = inm.unwrap();
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            std::string::size_type pos = 0;
+            while (pos <= values[i].size())
+            {
+                std::string::size_type comma = values[i].find(',', pos);
+                if (comma == std::string::npos)
+                    comma = values[i].size();
+                const std::string tag =
+                    trimOws_(values[i].substr(pos, comma - pos));
+                pos = comma + 1;
+                // GET/HEAD では弱い比較（gzip で送った W/ 付きも一致させる）
+                if (tag == "*" || opaqueTag_(tag) == opaqueTag_(etag))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    Result<const std::vector<std::string>&> ims =
+        request.getHeader("If-Modified-Since");
+    if (ims.isError() || ims.unwrap().empty())
+        return false;
+    long since = 0;
+    if (!utils::Timestamp::parseHttpDate(ims.unwrap()[0], &since))
+        return false;
+    return last_modified <= since;
+}
+
+// RFC 9110 Section 13.1.5: If-Range が無いか、検証子が一致すれば Range を使う。
+// Range の結合に弱い検証子は使えないので、W/ 付きは常に不一致。
+// （gzip で送ったレスポンスの ETag は W/ 付きなので、ここで弾かれる）
+bool StaticFileResponder::ifRangeMatches_(const http::HttpRequest& request,
+    const std::string& etag, long last_modified)
+{
+    Result<const std::vector<std::string>&> ir = request.getHeader("If-Range");
+    if (ir.isError() || ir.unwrap().empty())
+        return true;
+
+    const std::string value = trimOws_(ir.unwrap()[0]);
+    if (value.compare(0, 2, "W/") == 0)
+        return false;
+    if (!value.empty() && value[0] == '"')
+        return etag.compare(0, 2, "W/") != 0 && value == etag;
+
+    long date = 0;
+    if (!utils::Timestamp::parseHttpDate(value, &date))
+        return false;
+    return date == last_modified;
+}
+
+// RFC 9110 Section 14.1.2: bytes=first-last / first- / -suffix のリスト。
+// 構文不正なら Range ごと無視し、満たせる範囲が1つも無ければ 416。
+StaticFileResponder::RangeEvaluation StaticFileResponder::parseRanges_(
+    const std::string& value, unsigned long size,
+    std::vector<ByteRange>* out_ranges)
+{
+    const std::string unit = "bytes=";
+    if (value.size() < unit.size())
+        return RANGE_IGNORE;
+    for (size_t i = 0; i < unit.size(); ++i)
+    {
+        const char c = value[i];
+        const char lower = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32)
+                                                  : c;
+        if (lower != unit[i])
+            return RANGE_IGNORE;
+    }
+
+    size_t specs = 0;
+    std::string::size_type pos = unit.size();
+    while (pos <= value.size())
+    {
+        std::string::size_type comma = value.find(',', pos);
+        if (comma == std::string::npos)
+            comma = value.size();
+        const std::string spec = trimOws_(value.substr(pos, comma - pos));
+        pos = comma + 1;
+        if (spec.empty())
+            continue;
+        if (++specs > kMaxRanges)
+            return RANGE_IGNORE;
+
+        const std::string::size_type dash = spec.find('-');
+        if (dash == std::string::npos)
+            return RANGE_IGNORE;
+        const std::string first_str = spec.substr(0, dash);
+        const std::string last_str = spec.substr(dash + 1);
+
+        ByteRange r;
+        if (first_str.empty())
+        {
+            // 末尾から suffix バイト
+            unsigned long suffix = 0;
+            if (!parseDecimal_(last_str, &suffix))
+                return RANGE_IGNORE;
+            if (suffix == 0 || size == 0)
+                continue;
+            r.first = (suffix >= size) ? 0 : size - suffix;
+            r.last = size - 1;
+        }
+        else
+        {
+            unsigned long last = ULONG_MAX;
+            if (!parseDecimal_(first_str, &r.first))
+                return RANGE_IGNORE;
+            if (!last_str.empty() && !parseDecimal_(last_str, &last))
+                return RANGE_IGNORE;
+            if (last < r.first)
+                return RANGE_IGNORE;
+            if (r.first >= size)
+                continue;
+            r.last = (last >= size) ? size - 1 : last;
+        }
+        out_ranges->push_back(r);
+    }
+
+    if (specs == 0)
+        return RANGE_IGNORE;
+    if (out_ranges->empty())
+        return RANGE_UNSATISFIABLE;
+    return RANGE_PARTIAL;
+}
+
+std::string StaticFileResponder::makeContentRange_(
+    const ByteRange& range, unsigned long size)
+{
+    std::ostringstream oss;
+    oss << "bytes " << range.first << '-' << range.last << '/' << size;
+    return oss.str();
+}
+
+// 本文中に現れない前提の区切り文字列（応答ごとに変える）
+std::string StaticFileResponder::makeBoundary_()
+{
+    static unsigned long counter = 0;
+    std::ostringstream oss;
+    oss << std::setw(20) << std::setfill('0') << ++counter;
+    return oss.str();
+}
+
+// キャッシュ対象のサイズならキャッシュから（無ければ読み込んで登録し）
+// 内容を返す。それ以外は open した fd を返す。
+// 失敗時は open の errno を残して false を返す。
+bool StaticFileResponder::acquireContents_(const std::string& path,
+    const struct stat& st, unsigned long file_cache_max_size, int* out_fd,
+    SharedBytes* out_contents)
+{
+    const bool cacheable =
+        file_cache_max_size > 0 &&
+        static_cast<unsigned long>(st.st_size) <= file_cache_max_size;
+    if (cacheable && cache_.lookup(path, st, out_contents))
+        return true;
+
     errno = 0;
     const int fd = ::open(path.c_str(), O_RDONLY);
     if (fd < 0)
+        return false;
+
+    if (cacheable)
     {
-        if (errno == EACCES || errno == EPERM)
-            return Result<RequestProcessorOutput>(ERROR, "forbidden");
-        if (errno == ENOENT || errno == ENOTDIR)
-            return Result<RequestProcessorOutput>(ERROR, "not_found");
-        return Result<RequestProcessorOutput>(ERROR, "open failed");
+        if (StaticFileCache::loadFromFd(fd, st, out_contents))
+        {
+            (void)::close(fd);
+            cache_.store(path, st, *out_contents);
+            return true;
+        }
+        // 読み切れなければ通常どおり fd から送る
+        out_contents->reset();
+        if (::lseek(fd, 0, SEEK_SET) < 0)
+        {
+            (void)::close(fd);
+            return false;
+        }
+    }
+    *out_fd = fd;
+    return true;
+}
+
+Result<RequestProcessorOutput> StaticFileResponder::respondFile(
+    const std::string& path, const struct stat& st,
+    const http::HttpStatus& status, const http::HttpRequest& request,
+    bool gzip_static, unsigned long file_cache_max_size,
+    http::HttpResponse& out_response)
+{
+    std::string serve_path = path;
+    struct stat serve_st = st;
+    std::string content_encoding;
+    if (gzip_static)
+        (void)selectPrecompressed_(
+            path, st, request, &serve_path, &serve_st, &content_encoding);
+
+    const bool conditional =
+        (status == http::HttpStatus::OK &&
+            (request.getMethod() == http::HttpMethod::GET ||
+                request.getMethod() == http::HttpMethod::HEAD));
+
+    // 検証子が一致すればファイルを open せずに 304 を返す
+    if (conditional && isNotModified_(request, makeETag_(serve_st),
+                           static_cast<long>(serve_st.st_mtime)))
+    {
+        Result<void> s = out_response.setStatus(http::HttpStatus::NOT_MODIFIED);
+        if (s.isError())
+            return Result<RequestProcessorOutput>(ERROR, s.getErrorMessage());
+        (void)out_response.setHeader("ETag", makeETag_(serve_st));
+        (void)out_response.setHeader("Last-Modified",
+            utils::Timestamp::formatHttpDate(
+                static_cast<long>(serve_st.st_mtime)));
+        // 200 と同じ表現メタデータを載せ、writer が gzip 応答と同じく
+        // ETag を弱めるかを判定できるようにする（本体は送らない）
+        (void)out_response.setHeader(
+            "Content-Type", mime_types_.lookupPath(path));
+        if (!content_encoding.empty())
+            (void)out_response.setHeader("Content-Encoding", content_encoding);
+        (void)out_response.setExpectedContentLength(
+            static_cast<unsigned long>(serve_st.st_size));
+        if (gzip_static)
+            (void)out_response.setHeader("Vary", "Accept-Encoding");
+
+        RequestProcessorOutput out;
+        out.body_source.reset(NULL);
+        out.should_close_connection = false;
+        return out;
+    }
+
+    int fd = -1;
+    SharedBytes cached;
+    if (!content_encoding.empty() &&
+        !acquireContents_(
+            serve_path, serve_st, file_cache_max_size, &fd, &cached))
+    {
+        // 事前圧縮ファイルが読めなければ元ファイルを返す
+        serve_st = st;
+        content_encoding.clear();
+    }
+    if (content_encoding.empty())
+    {
+        if (!acquireContents_(path, st, file_cache_max_size, &fd, &cached))
+        {
+            if (errno == EACCES || errno == EPERM)
+                return Result<RequestProcessorOutput>(ERROR, "forbidden");
+            if (errno == ENOENT || errno == ENOTDIR)
+                return Result<RequestProcessorOutput>(ERROR, "not_found");
+            return Result<RequestProcessorOutput>(ERROR, "open failed");
+        }
     }
 
     RequestProcessorOutput out;
-    const unsigned long size = static_cast<unsigned long>(st.st_size);
-    Result<void> s = out_response.setStatus(status);
+    const unsigned long size = static_cast<unsigned long>(serve_st.st_size);
+    const std::string etag = makeETag_(serve_st);
+    const long last_modified = static_cast<long>(serve_st.st_mtime);
+
+    // Range は GET のみ（RFC 9110 Section 14.2）
+    std::vector<ByteRange> ranges;
+    RangeEvaluation range_eval = RANGE_IGNORE;
+    if (conditional && request.getMethod() == http::HttpMethod::GET)
+    {
+        Result<const std::vector<std::string>&> rh = request.getHeader("Range");
+        if (rh.isOk() && rh.unwrap().size() == 1 &&
+            ifRangeMatches_(request, etag, last_modified))
+            range_eval = parseRanges_(rh.unwrap()[0], size, &ranges);
+    }
+
+    http::HttpStatus out_status = status;
+    if (range_eval == RANGE_PARTIAL)
+        out_status = http::HttpStatus::PARTIAL_CONTENT;
+    else if (range_eval == RANGE_UNSATISFIABLE)
+        out_status = http::HttpStatus::RANGE_NOT_SATISFIABLE;
+
+    Result<void> s = out_response.setStatus(out_status);
     if (s.isError())
     {
-        (void)::close(fd);
+        if (fd >= 0)
+            (void)::close(fd);
         return Result<RequestProcessorOutput>(ERROR, s.getErrorMessage());
     }
 
-    (void)out_response.setExpectedContentLength(size);
+    // Content-Type は圧縮前のファイルのもの
+    const std::string& content_type = mime_types_.lookupPath(path);
+    (void)out_response.setHeader("Content-Type", content_type);
 
-    const std::string ext = extractExtension_(path);
-    http::ContentType ct = http::ContentType::fromExtension(ext);
-    (void)out_response.setHeader("Content-Type", ct.c_str());
+    if (!content_encoding.empty())
+        (void)out_response.setHeader("Content-Encoding", content_encoding);
+    // 返す表現が Accept-Encoding で変わるので、キャッシュに伝える
+    if (gzip_static)
+        (void)out_response.setHeader("Vary", "Accept-Encoding");
+
+    // エラーページとして返す場合は再検証の対象にしない
+    if (conditional)
+    {
+        (void)out_response.setHeader("Accept-Ranges", "bytes");
+        (void)out_response.setHeader("ETag", etag);
+        (void)out_response.setHeader("Last-Modified",
+            utils::Timestamp::formatHttpDate(last_modified));
+    }
 
-    out.body_source.reset(new FileBodySource(fd, size));
+    if (range_eval == RANGE_UNSATISFIABLE)
+    {
+        if (fd >= 0)
+            (void)::close(fd);
+        std::ostringstream cr;
+        cr << "bytes */" << size;
+        (void)out_response.setHeader("Content-Range", cr.str());
+        (void)out_response.setExpectedContentLength(0);
+        out.body_source.reset(NULL);
+        out.should_close_connection = false;
+        return out;
+    }
+
+    if (range_eval == RANGE_PARTIAL && ranges.size() == 1)
+    {
+        const unsigned long len = ranges[0].last - ranges[0].first + 1;
+        (void)out_response.setHeader(
+            "Content-Range", makeContentRange_(ranges[0], size));
+        (void)out_response.setExpectedContentLength(len);
+        if (cached.get() != NULL)
+            out.body_source.reset(new SharedBytesBodySource(cached,
+                static_cast<size_t>(ranges[0].first), static_cast<size_t>(len)));
+        else
+            out.body_source.reset(
+                new FileBodySource(fd, ranges[0].first, len));
+        out.should_close_connection = false;
+        return out;
+    }
+
+    if (range_eval == RANGE_PARTIAL)
+    {
+        // RFC 9110 Section 14.6: multipart/byteranges
+        const std::string boundary = makeBoundary_();
+        FileRangesBodySource* body = (cached.get() != NULL)
+                                         ? new FileRangesBodySource(cached)
+                                         : new FileRangesBodySource(fd);
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            body->appendText("\r\n--" + boundary +
+                             "\r\nContent-Type: " + content_type +
+                             "\r\nContent-Range: " +
+                             makeContentRange_(ranges[i], size) + "\r\n\r\n");
+            body->appendFileRange(
+                ranges[i].first, ranges[i].last - ranges[i].first + 1);
+        }
+        body->appendText("\r\n--" + boundary + "--\r\n");
+
+        (void)out_response.setHeader(
+            "Content-Type", "multipart/byteranges; boundary=" + boundary);
+        (void)out_response.setExpectedContentLength(body->totalLength());
+        out.body_source.reset(body);
+        out.should_close_connection = false;
+        return out;
+    }
+
+    (void)out_response.setExpectedContentLength(size);
+    if (cached.get() != NULL)
+        out.body_source.reset(new SharedBytesBodySource(
+            cached, 0, static_cast<size_t>(size)));
+    else
+        out.body_source.reset(new FileBodySource(fd, size));
     out.should_close_connection = false;
     return out;
 }
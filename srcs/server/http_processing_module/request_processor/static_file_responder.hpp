@@ -4,9 +4,13 @@
 #include <sys/stat.h>
 
 #include <string>
+#include <vector>
 
+#include "http/http_request.hpp"
+#include "http/mime_types.hpp"
 #include "http/http_response.hpp"
 #include "server/http_processing_module/request_processor/request_processor_output.hpp"
+#include "server/http_processing_module/request_processor/static_file_cache.hpp"
 #include "utils/result.hpp"
 
 namespace server
@@ -15,12 +19,63 @@ namespace server
 class StaticFileResponder
 {
    public:
+    // gzip_static が有効な場合、Accept-Encoding が許せば path.br / path.gz
+    // （元ファイルより古くないもの）を Content-Encoding 付きで返す。
+    // status が 200 の GET/HEAD では ETag / Last-Modified を付け、
+    // 条件付きリクエストが一致すればファイルを開かずに 304 を返す。
+    // GET の Range（If-Range 付きも含む）には 206 / 416 で応じる。
+    // file_cache_max_size 以下のファイルは内容をキャッシュから返す。
     utils::result::Result<RequestProcessorOutput> respondFile(
         const std::string& path, const struct stat& st,
-        const http::HttpStatus& status, http::HttpResponse& out_response) const;
+        const http::HttpStatus& status, const http::HttpRequest& request,
+        bool gzip_static, unsigned long file_cache_max_size,
+        http::HttpResponse& out_response);
+
+    explicit StaticFileResponder(const http::MimeTypes& mime_types);
+    ~StaticFileResponder();
 
    private:
-    static std::string extractExtension_(const std::string& path);
+    const http::MimeTypes& mime_types_;
+    StaticFileCache cache_;
+
+    // 1つのリクエストで受け付ける範囲の数（超えたら Range を無視）
+    static const size_t kMaxRanges = 16;
+
+    struct ByteRange
+    {
+        unsigned long first;
+        unsigned long last;  // 末尾を含む
+    };
+
+    enum RangeEvaluation
+    {
+        RANGE_IGNORE,  // Range なし/構文不正/If-Range 不一致 -> 200
+        RANGE_PARTIAL,
+        RANGE_UNSATISFIABLE
+    };
+
+    static bool selectPrecompressed_(const std::string& path,
+        const struct stat& st, const http::HttpRequest& request,
+        std::string* out_path, struct stat* out_st, std::string* out_encoding);
+    static std::string makeETag_(const struct stat& st);
+    static std::string opaqueTag_(const std::string& tag);
+    static bool isNotModified_(const http::HttpRequest& request,
+        const std::string& etag, long last_modified);
+    static bool ifRangeMatches_(const http::HttpRequest& request,
+        const std::string& etag, long last_modified);
+    static RangeEvaluation parseRanges_(const std::string& value,
+        unsigned long size, std::vector<ByteRange>* out_ranges);
+    static std::string makeContentRange_(
+        const ByteRange& range, unsigned long size);
+    static std::string makeBoundary_();
+
+    bool acquireContents_(const std::string& path, const struct stat& st,
+        unsigned long file_cache_max_size, int* out_fd,
+        SharedBytes* out_contents);
+
+    StaticFileResponder();
+    StaticFileResponder(const StaticFileResponder& rhs);
+    StaticFileResponder& operator=(const StaticFileResponder& rhs);
 };
 
 }  // namespace server
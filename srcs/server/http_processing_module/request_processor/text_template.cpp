@@ -0,0 +1,100 @@
+#include "server/http_processing_module/request_processor/text_template.hpp"
+
+#include <cstring>
+
+namespace server
+{
+
+const size_t TextTemplate::kLiteral;
+
+TextTemplate::TextTemplate() : segments_(), literal_bytes_(0) {}
+
+TextTemplate::~TextTemplate() {}
+
+bool TextTemplate::empty() const { return segments_.empty(); }
+
+// 直前もリテラルならまとめて、render 時の append 回数を減らす
+void TextTemplate::appendLiteral_(const std::string& source,
+    std::string::size_type pos, std::string::size_type len)
+{
+    if (len == 0)
+        return;
+    if (segments_.empty() || segments_.back().slot != kLiteral)
+    {
+        Segment seg;
+        seg.slot = kLiteral;
+        segments_.push_back(seg);
+    }
+    segments_.back().literal.append(source, pos, len);
+    literal_bytes_ += len;
+}
+
+void TextTemplate::compile(
+    const std::string& source, const char* const* names, size_t name_count)
+{
+    segments_.clear();
+    literal_bytes_ = 0;
+
+    std::string::size_type pos = 0;
+    while (pos < source.size())
+    {
+        const std::string::size_type open = source.find("{{", pos);
+        if (open == std::string::npos)
+            break;
+        const std::string::size_type close = source.find("}}", open + 2);
+        if (close == std::string::npos)
+            break;
+
+        const std::string name = source.substr(open + 2, close - open - 2);
+        size_t slot = kLiteral;
+        for (size_t i = 0; i < name_count; ++i)
+        {
+            if (std::strcmp(names[i], name.c_str()) == 0)
+            {
+                slot = i;
+                break;
+            }
+        }
+
+        if (slot == kLiteral)
+        {
+            // 未知の名前は "{{NAME}}" ごとリテラルとして残す
+            appendLiteral_(source, pos, close + 2 - pos);
+        }
+        else
+        {
+            appendLiteral_(source, pos, open - pos);
+            Segment seg;
+            seg.slot = slot;
+            segments_.push_back(seg);
+        }
+        pos = close + 2;
+    }
+    appendLiteral_(source, pos, source.size() - pos);
+}
+
+void TextTemplate::render(
+    const std::string* const* values, std::string* out) const
+{
+    size_t total = literal_bytes_;
+    for (size_t i = 0; i < segments_.size(); ++i)
+    {
+        if (segments_[i].slot != kLiteral)
+            total += values[segments_[i].slot]->size();
+    }
+    // 繰り返し追記されても再確保が償却 O(1) になるよう倍々で広げる
+    const size_t need = out->size() + total;
+    if (out->capacity() < need)
+        out->reserve(need > out->capacity() * 2 ? need : out->capacity() * 2);
+
+    for (size_t i = 0; i < segments_.size(); ++i)
+    {
+        const Segment& seg = segments_[i];
+        if (seg.slot == kLiteral)
+            out->append(seg.literal);
+        else
+            out->append(*values[seg.slot]);
+    }
+}
+
+}  // namespace server
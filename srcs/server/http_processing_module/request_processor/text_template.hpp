@@ -0,0 +1,47 @@
+#ifndef WEBSERV_TEXT_TEMPLATE_HPP_
+#define WEBSERV_TEXT_TEMPLATE_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace server
+{
+
+// {{NAME}} 形式のプレースホルダを持つテキストテンプレート。
+// - compile() で一度だけ「リテラル / スロット」の列に分解しておき、
+//   render() は値を順に連結するだけの1パスで出力する。
+// - プレースホルダ名は compile() 時にスロット番号へ対応づける。
+//   names に無い名前は置換せず、そのままリテラルとして残す。
+class TextTemplate
+{
+   public:
+    TextTemplate();
+    ~TextTemplate();
+
+    void compile(const std::string& source, const char* const* names,
+        size_t name_count);
+    bool empty() const;
+
+    // values[slot] の内容でプレースホルダを埋めて out の末尾に追記する。
+    // values は compile() に渡した names と同じ並び・個数であること。
+    void render(const std::string* const* values, std::string* out) const;
+
+   private:
+    struct Segment
+    {
+        std::string literal;
+        size_t slot;  // kLiteral ならリテラル
+    };
+    static const size_t kLiteral = static_cast<size_t>(-1);
+
+    std::vector<Segment> segments_;
+    size_t literal_bytes_;
+
+    void appendLiteral_(const std::string& source, std::string::size_type pos,
+        std::string::size_type len);
+};
+
+}  // namespace server
+
+#endif
@@ -1,11 +1,31 @@
 #include "server/http_processing_module/request_router/location_directive.hpp"
 
+#include "http/syntax.hpp"
+
 namespace server
 {
 
 LocationDirective::LocationDirective(const LocationDirectiveConf& conf)
-    : conf_(conf)
+    : conf_(conf), allow_header_value_(), add_header_block_()
 {
+    for (std::set<http::HttpMethod>::const_iterator it =
+             conf_.allowed_methods.begin();
+        it != conf_.allowed_methods.end(); ++it)
+    {
+        if (!allow_header_value_.empty())
+        {
+            allow_header_value_ += ", ";
+        }
+        allow_header_value_ += it->toString();
+    }
+
+    for (size_t i = 0; i < conf_.add_headers.size(); ++i)
+    {
+        add_header_block_ += conf_.add_headers[i].first;
+        add_header_block_ += ": ";
+        add_header_block_ += conf_.add_headers[i].second;
+        add_header_block_ += http::HttpSyntax::kCrlf;
+    }
 }
 
 unsigned long LocationDirective::clientMaxBodySize() const
@@ -26,6 +46,53 @@ bool LocationDirective::isCgiEnabled() const
 }
 
 bool LocationDirective::isAutoIndexEnabled() const { return conf_.auto_index; }
+bool LocationDirective::isGzipStaticEnabled() const
+{
+    return conf_.gzip_static;
+}
+bool LocationDirective::isGzipEnabled() const { return conf_.gzip; }
+unsigned long LocationDirective::gzipMinLength() const
+{
+    return conf_.gzip_min_length;
+}
+int LocationDirective::gzipCompLevel() const { return conf_.gzip_comp_level; }
+unsigned long LocationDirective::fileCacheMaxSize() const
+{
+    return conf_.file_cache_max_size;
+}
+unsigned long LocationDirective::clientBodyBufferSize() const
+{
+    return conf_.client_body_buffer_size;
+}
+const FilePath& LocationDirective::clientBodyTempPath() const
+{
+    return conf_.client_body_temp_path;
+}
+
+const std::string& LocationDirective::fastCgiPass() const
+{
+    return conf_.fastcgi_pass;
+}
+bool LocationDirective::hasCgiWorkerPool() const
+{
+    return conf_.has_cgi_worker_pool;
+}
+const CgiWorkerPoolConf& LocationDirective::cgiWorkerPool() const
+{
+    return conf_.cgi_worker_pool;
+}
+unsigned long LocationDirective::cgiMaxConcurrency() const
+{
+    return conf_.cgi_max_concurrency;
+}
+bool LocationDirective::cgiRequestBuffering() const
+{
+    return conf_.cgi_request_buffering;
+}
+const std::set<std::string>& LocationDirective::gzipTypes() const
+{
+    return conf_.gzip_types;
+}
 
 bool LocationDirective::hasRedirect() const
 {
@@ -165,20 +232,14 @@ bool LocationDirective::isMethodAllowed(const http::HttpMethod& method) const
     return conf_.allowed_methods.find(method) != conf_.allowed_methods.end();
 }
 
-std::string LocationDirective::buildAllowHeaderValue() const
+const std::string& LocationDirective::allowHeaderValue() const
 {
-    std::string out;
-    for (std::set<http::HttpMethod>::const_iterator it =
-             conf_.allowed_methods.begin();
-        it != conf_.allowed_methods.end(); ++it)
-    {
-        if (!out.empty())
-        {
-            out += ", ";
-        }
-        out += it->toString();
-    }
-    return out;
+    return allow_header_value_;
+}
+
+const std::string& LocationDirective::addHeaderBlock() const
+{
+    return add_header_block_;
 }
 
 size_t LocationDirective::pathPatternLength() const
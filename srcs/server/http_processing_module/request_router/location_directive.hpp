@@ -16,6 +16,9 @@ class LocationDirective
 {
    private:
     LocationDirectiveConf conf_;
+    // 設定から決まる定数ヘッダーは構築時に一度だけ整形しておく
+    std::string allow_header_value_;
+    std::string add_header_block_;
 
     static bool forwardMatch_(
         const std::string& path, const std::string& pattern);
@@ -34,6 +37,19 @@ class LocationDirective
     bool isBackwardSearch() const;
     bool isCgiEnabled() const;
     bool isAutoIndexEnabled() const;
+    bool isGzipStaticEnabled() const;
+    bool isGzipEnabled() const;
+    unsigned long gzipMinLength() const;
+    int gzipCompLevel() const;
+    unsigned long fileCacheMaxSize() const;
+    unsigned long clientBodyBufferSize() const;
+    const FilePath& clientBodyTempPath() const;
+    const std::string& fastCgiPass() const;
+    bool hasCgiWorkerPool() const;
+    const CgiWorkerPoolConf& cgiWorkerPool() const;
+    unsigned long cgiMaxConcurrency() const;
+    bool cgiRequestBuffering() const;
+    const std::set<std::string>& gzipTypes() const;
     bool hasRedirect() const;
     const std::string& redirectTarget() const;
     http::HttpStatus redirectStatus() const;
@@ -63,9 +79,11 @@ class LocationDirective
 
     // ビジネスロジック
     bool isMethodAllowed(const http::HttpMethod& method) const;
-    // RFC 9110 Section 10.2.6 (405) の Allow ヘッダー値を生成する。
-    // allow_methods で設定されたメソッドを ", " で連結する。
-    std::string buildAllowHeaderValue() const;
+    // RFC 9110 Section 10.2.6 (405) の Allow ヘッダー値。
+    // allow_methods で設定されたメソッドを ", " で連結したもの。
+    const std::string& allowHeaderValue() const;
+    // add_header を "Name: value\r\n" で連結したもの（無ければ空）。
+    const std::string& addHeaderBlock() const;
     size_t pathPatternLength() const;
     bool isMatchPattern(const std::string& path) const;
 
@@ -23,7 +23,18 @@ CgiContext::CgiContext()
       script_name(),
       path_info(),
       query_string(),
-      http_minor_version(0)
+      http_minor_version(0),
+      fastcgi_pass(),
+      use_worker_pool(false),
+      worker_pool()
+{
+}
+
+GzipContext::GzipContext()
+    : types(),
+      min_length(LocationDirectiveConf::kDefaultGzipMinLength),
+      comp_level(LocationDirectiveConf::kDefaultGzipCompLevel),
+      enabled(false)
 {
 }
 
@@ -85,7 +96,7 @@ Result<std::string> LocationRouting::getAllowHeaderValue() const
         return Result<std::string>(
             utils::result::ERROR, std::string(), "location is null");
     }
-    return Result<std::string>(location_->buildAllowHeaderValue());
+    return Result<std::string>(location_->allowHeaderValue());
 }
 
 Result<std::string> LocationRouting::getRedirectLocation() const
@@ -228,6 +239,9 @@ Result<CgiContext> LocationRouting::getCgiContext() const
         ctx.path_info = std::string();
         ctx.query_string = query_string_;
         ctx.http_minor_version = request_ctx_.getMinorVersion();
+        ctx.fastcgi_pass = location_->fastCgiPass();
+        ctx.use_worker_pool = location_->hasCgiWorkerPool();
+        ctx.worker_pool = location_->cgiWorkerPool();
         return ctx;
     }
 
@@ -251,6 +265,9 @@ Result<CgiContext> LocationRouting::getCgiContext() const
                                                  : std::string();
     ctx.query_string = query_string_;
     ctx.http_minor_version = request_ctx_.getMinorVersion();
+    ctx.fastcgi_pass = location_->fastCgiPass();
+    ctx.use_worker_pool = location_->hasCgiWorkerPool();
+    ctx.worker_pool = location_->cgiWorkerPool();
 
     std::string script_under_location =
         location_->removePathPatternFromPath(ctx.script_name);
@@ -364,6 +381,61 @@ Result<unsigned long> LocationRouting::clientMaxBodySize() const
     return location_->clientMaxBodySize();
 }
 
+GzipContext LocationRouting::getGzipContext() const
+{
+    GzipContext ctx;
+    if (location_ == NULL)
+        return ctx;
+    ctx.enabled = location_->isGzipEnabled();
+    ctx.min_length = location_->gzipMinLength();
+    ctx.comp_level = location_->gzipCompLevel();
+    ctx.types = location_->gzipTypes();
+    return ctx;
+}
+
+unsigned long LocationRouting::fileCacheMaxSize() const
+{
+    return location_ != NULL ? location_->fileCacheMaxSize() : 0;
+}
+
+unsigned long LocationRouting::cgiMaxConcurrency() const
+{
+    return location_ != NULL ? location_->cgiMaxConcurrency() : 0;
+}
+
+const void* LocationRouting::cgiConcurrencyKey() const { return location_; }
+
+bool LocationRouting::cgiRequestBuffering() const
+{
+    return location_ != NULL ? location_->cgiRequestBuffering() : true;
+}
+
+unsigned long LocationRouting::clientBodyBufferSize() const
+{
+    if (location_ == NULL)
+        return LocationDirectiveConf::kDefaultClientBodyBufferSize;
+    return location_->clientBodyBufferSize();
+}
+
+std::string LocationRouting::clientBodyTempPath() const
+{
+    if (location_ == NULL)
+        return std::string();
+    return location_->clientBodyTempPath().str();
+}
+
+const std::string* LocationRouting::addHeaderBlock() const
+{
+    if (location_ == NULL || location_->addHeaderBlock().empty())
+        return NULL;
+    return &location_->addHeaderBlock();
+}
+
+bool LocationRouting::isGzipStaticEnabled() const
+{
+    return location_ != NULL && location_->isGzipStaticEnabled();
+}
+
 bool LocationRouting::tryGetErrorPagePath(
     const http::HttpStatus& status, std::string* out_path) const
 {
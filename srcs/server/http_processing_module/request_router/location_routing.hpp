@@ -2,6 +2,7 @@
 #define WEBSERV_SERVER_LOCATION_ROUTING_HPP_
 
 #include <cstddef>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -47,6 +48,11 @@ struct CgiContext
     std::string path_info;
     std::string query_string;
     int http_minor_version;
+    // 空でなければ executor ではなくこの FastCGI サーバへ送る
+    std::string fastcgi_pass;
+    // true なら executor を常駐ワーカ（cgi_worker_pool）として使う
+    bool use_worker_pool;
+    CgiWorkerPoolConf worker_pool;
 
     CgiContext();
 };
@@ -67,6 +73,17 @@ struct UploadContext
     UploadContext();
 };
 
+// 送出時圧縮（gzip ディレクティブ群）の設定
+struct GzipContext
+{
+    std::set<std::string> types;
+    unsigned long min_length;
+    int comp_level;
+    bool enabled;
+
+    GzipContext();
+};
+
 class LocationRouting
 {
    public:
@@ -104,6 +121,37 @@ class LocationRouting
 
     Result<unsigned long> clientMaxBodySize() const;
 
+    // gzip_static が有効か（location が無い場合は false）。
+    bool isGzipStaticEnabled() const;
+
+    // gzip の設定（location が無い場合は無効）。
+    GzipContext getGzipContext() const;
+
+    // 内容をキャッシュしてよい静的ファイルの最大サイズ（0 は無効）。
+    unsigned long fileCacheMaxSize() const;
+
+    // この location の CGI 同時実行数の上限（0 は無制限）。
+    unsigned long cgiMaxConcurrency() const;
+
+    // CGI 同時実行数を数える単位。同じ location なら同じ値を返す
+    // （location が無い場合は NULL）。
+    const void* cgiConcurrencyKey() const;
+
+    // false なら CGI のリクエストボディを溜めずに流す
+    // （cgi_request_buffering off）。
+    bool cgiRequestBuffering() const;
+
+    // メモリに保持してよいリクエストボディの最大サイズ。
+    // location が無い場合は既定値。
+    unsigned long clientBodyBufferSize() const;
+
+    // リクエストボディの一時ファイルを作るディレクトリ（未設定なら空）。
+    std::string clientBodyTempPath() const;
+
+    // add_header の事前整形済みブロック（無ければ NULL）。
+    // 実体は LocationDirective が持つので、サーバー稼働中は有効。
+    const std::string* addHeaderBlock() const;
+
     // error_page の設定を問い合わせる（設定がなければ false）。
     // out_path はそのまま location 設定の値（URIパス or URL）を返す。
     bool tryGetErrorPagePath(
@@ -5,17 +5,26 @@ namespace server
 using http::HttpStatus;
 using utils::result::Result;
 
-RequestRouter::RequestRouter(const ServerConfig& config) : servers_()
+RequestRouter::RequestRouter(const ServerConfig& config)
+    : servers_(), mime_types_()
 {
     servers_.reserve(config.servers.size());
     for (size_t i = 0; i < config.servers.size(); ++i)
     {
         servers_.push_back(VirtualServer(config.servers[i]));
     }
+    for (std::map<std::string, std::string>::const_iterator it =
+             config.types.begin();
+         it != config.types.end(); ++it)
+    {
+        mime_types_.add(it->first, it->second);
+    }
 }
 
 RequestRouter::~RequestRouter() {}
 
+const http::MimeTypes& RequestRouter::mimeTypes() const { return mime_types_; }
+
 Result<LocationRouting> RequestRouter::route(const http::HttpRequest& request,
     const IPAddress& server_ip, const PortType& server_port) const
 {
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "http/http_request.hpp"
+#include "http/mime_types.hpp"
 #include "network/ip_address.hpp"
 #include "network/port_type.hpp"
 #include "server/config/server_config.hpp"
@@ -37,8 +38,12 @@ class RequestRouter
     Result<LocationRouting> route(const http::HttpRequest& request,
         const IPAddress& server_ip, const PortType& server_port) const;
 
+    // 組み込みの対応表に types {} を反映した 拡張子 -> MIME type
+    const http::MimeTypes& mimeTypes() const;
+
    private:
     std::vector<VirtualServer> servers_;
+    http::MimeTypes mime_types_;
 
     // Virtual Server選択
     // listen_port と server_name を元に適切なバーチャルサーバを返す｡
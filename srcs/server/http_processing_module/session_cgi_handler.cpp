@@ -1,5 +1,6 @@
 #include "server/http_processing_module/session_cgi_handler.hpp"
 
+#include <fcntl.h>
 #include <unistd.h>
 
 #include <ctime>
@@ -9,8 +10,11 @@
 
 #include "http/cgi_meta_variables.hpp"
 #include "http/cgi_response.hpp"
+#include "server/http_processing_module/cgi_worker_pool.hpp"
+#include "server/http_processing_module/fastcgi_upstream_pool.hpp"
 #include "server/session/fd/cgi_pipe/cgi_pipe_fd.hpp"
 #include "server/session/fd_session/cgi_session.hpp"
+#include "server/session/fd_session/fastcgi_session.hpp"
 #include "server/session/fd_session/http_session.hpp"
 #include "server/session/fd_session/http_session/session_context.hpp"
 #include "server/session/fd_session/http_session/states/http_session_states.hpp"
@@ -50,13 +54,49 @@ static bool is42CgiTesterExecutor_(const std::string& executor_path)
     return base.find("cgi_tester42") != std::string::npos;
 }
 
-SessionCgiHandler::SessionCgiHandler(FdSessionController& controller)
-    : controller_(controller)
+static bool setNonBlockingCloexec_(int fd)
+{
+    const int fl = ::fcntl(fd, F_GETFL, 0);
+    if (fl < 0 || ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0)
+        return false;
+    return ::fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+// ボディを受信し切る前に応答する（cgi_request_buffering off）。
+// 残りのボディの後に来る次のリクエストを待たずに応答を終え得るので、
+// この接続は閉じる。
+static void closeIfRequestBodyPending_(SessionContext& ctx)
+{
+    if (!ctx.request_handler.isStreamingBody() || ctx.request.isParseComplete())
+        return;
+    (void)ctx.response.setHeader("Connection", "close");
+    ctx.should_close_connection = true;
+}
+
+SessionCgiHandler::SessionCgiHandler(FdSessionController& controller,
+    FastCgiUpstreamPool& fastcgi_upstreams, CgiWorkerPool& cgi_workers)
+    : controller_(controller),
+      fastcgi_upstreams_(fastcgi_upstreams),
+      cgi_workers_(cgi_workers)
 {
 }
 
 SessionCgiHandler::~SessionCgiHandler() {}
 
+// ボディが確定してからレコードを組むので、FastCGI には流さない
+bool SessionCgiHandler::canStreamRequestBody(const HttpSession& session) const
+{
+    const SessionContext& ctx = session.getContext();
+    if (!ctx.request_handler.hasLocationRouting())
+        return false;
+    Result<server::CgiContext> ctxr =
+        ctx.request_handler.getLocationRouting().getCgiContext();
+    if (ctxr.isError())
+        return false;
+    const server::CgiContext cgi_ctx = ctxr.unwrap();
+    return cgi_ctx.fastcgi_pass.empty() && !cgi_ctx.use_worker_pool;
+}
+
 Result<void> SessionCgiHandler::startCgi(HttpSession& session)
 {
     SessionContext& ctx = session.getContext();
@@ -69,11 +109,18 @@ Result<void> SessionCgiHandler::startCgi(HttpSession& session)
         return Result<void>(ERROR, ctxr.getErrorMessage());
     const server::CgiContext cgi_ctx = ctxr.unwrap();
 
+    // メモリに収まったボディはファイルを経由せず stdin へ直接送る
+    // （受信しながら流す場合は、まだ BodyStore には何も無い）
+    BodyStore& body_store = ctx.request_handler.bodyStore();
+    const bool streams_body = ctx.request_handler.isStreamingBody();
+    const bool body_in_memory = !streams_body && ctx.request.hasBody() &&
+                                body_store.isInMemory() &&
+                                body_store.size() > 0;
     int request_body_fd = -1;
-    if (ctx.request.hasBody())
+    if (ctx.request.hasBody() && !body_in_memory && !streams_body)
     {
-        (void)ctx.request_handler.bodyStore().finish();
-        Result<int> fd = ctx.request_handler.bodyStore().openForRead();
+        (void)body_store.finish();
+        Result<int> fd = body_store.openForRead();
         if (fd.isOk())
             request_body_fd = fd.unwrap();
     }
@@ -108,17 +155,48 @@ Result<void> SessionCgiHandler::startCgi(HttpSession& session)
     std::map<std::string, std::string> env = meta.getAll();
     env["SCRIPT_FILENAME"] = cgi_ctx.script_filename.str();
     env["QUERY_STRING"] = cgi_ctx.query_string;
-    if (isPhpCgiExecutor_(cgi_ctx.executor_path.str()))
+    // cgi_worker_pool のワーカも FastCGI で話す（接続はリクエストごと）。
+    // ワーカ群が無効になっていれば空が返り、executor を直接起動する
+    std::string fastcgi_address = cgi_ctx.fastcgi_pass;
+    if (cgi_ctx.use_worker_pool)
+    {
+        Result<std::string> worker = cgi_workers_.pickWorker(
+            cgi_ctx.executor_path.str(), cgi_ctx.worker_pool);
+        if (worker.isError())
+        {
+            if (request_body_fd >= 0)
+                ::close(request_body_fd);
+            return Result<void>(ERROR, worker.getErrorMessage());
+        }
+        fastcgi_address = worker.unwrap();
+    }
+    const bool use_fastcgi = !fastcgi_address.empty();
+    if (use_fastcgi || isPhpCgiExecutor_(cgi_ctx.executor_path.str()))
         env["REDIRECT_STATUS"] = "200";
 
     // PATH_INFO / SCRIPT_NAME は CgiMetaVariables 側で設定済み。
 
+    // FastCGI ではボディもレコードとして送るので、CgiSession の
+    // stdin は使わない
+    std::string fastcgi_body;
+    if (use_fastcgi && body_in_memory)
+    {
+        const std::vector<utils::Byte>& data = body_store.memoryData();
+        fastcgi_body.assign(
+            reinterpret_cast<const char*>(&data[0]), data.size());
+    }
+
     std::vector<std::string> args;
     args.push_back(cgi_ctx.script_filename.str());
 
     const std::string working_dir = dirnameOf_(cgi_ctx.script_filename.str());
-    Result<CgiSpawnResult> spawned = server::CgiPipeFd::Execute(
-        cgi_ctx.executor_path.str(), args, env, working_dir);
+    Result<CgiSpawnResult> spawned =
+        use_fastcgi ? startFastCgi_(fastcgi_address, !cgi_ctx.use_worker_pool,
+                          env, fastcgi_body, request_body_fd)
+                    : server::CgiPipeFd::Execute(
+                          cgi_ctx.executor_path.str(), args, env, working_dir);
+    if (use_fastcgi)
+        request_body_fd = -1;  // startFastCgi_ に渡した
     if (spawned.isError())
         return Result<void>(ERROR, spawned.getErrorMessage());
 
@@ -126,6 +204,13 @@ Result<void> SessionCgiHandler::startCgi(HttpSession& session)
     ctx.active_cgi_session =
         new CgiSession(s.pid, s.stdin_fd, s.stdout_fd, s.stderr_fd,
             request_body_fd, &session, controller_, session.processingLog());
+    if (body_in_memory && !use_fastcgi)
+    {
+        const std::vector<utils::Byte>& body = body_store.memoryData();
+        ctx.active_cgi_session->preloadRequestBody(&body[0], body.size());
+    }
+    if (streams_body)
+        ctx.active_cgi_session->streamRequestBody();
 
     Result<void> d = controller_.delegateSession(ctx.active_cgi_session);
     if (d.isError())
@@ -143,6 +228,54 @@ Result<void> SessionCgiHandler::startCgi(HttpSession& session)
     return Result<void>();
 }
 
+Result<CgiSpawnResult> SessionCgiHandler::startFastCgi_(
+    const std::string& address, bool keep_conn,
+    const std::map<std::string, std::string>& params, const std::string& body,
+    int request_body_fd)
+{
+    int pipefd[2] = {-1, -1};
+    if (::pipe(pipefd) < 0)
+    {
+        if (request_body_fd >= 0)
+            ::close(request_body_fd);
+        return Result<CgiSpawnResult>(ERROR, "pipe() failed");
+    }
+    if (!setNonBlockingCloexec_(pipefd[0]) ||
+        !setNonBlockingCloexec_(pipefd[1]))
+    {
+        ::close(pipefd[0]);
+        ::close(pipefd[1]);
+        if (request_body_fd >= 0)
+            ::close(request_body_fd);
+        return Result<CgiSpawnResult>(ERROR, "fcntl() failed");
+    }
+
+    CgiSpawnResult s;
+    s.pid = -1;
+    s.stdin_fd = -1;
+    s.stdout_fd = pipefd[0];
+    s.stderr_fd = -1;
+
+    // 接続できない場合も、非同期に失敗した場合と同じく書き込み側を閉じて
+    // CgiSession に EOF を読ませる（ヘッダ前の EOF なので 502）
+    Result<FastCgiSession*> conn = fastcgi_upstreams_.acquire(address, keep_conn);
+    if (conn.isError())
+    {
+        utils::Log::error("SessionCgiHandler", address, conn.getErrorMessage());
+        ::close(pipefd[1]);
+        if (request_body_fd >= 0)
+            ::close(request_body_fd);
+        return s;
+    }
+
+    // 書き込み側と body fd は接続側が持つ
+    Result<void> r = conn.unwrap()->startRequest(
+        params, body, request_body_fd, pipefd[1]);
+    if (r.isError())
+        utils::Log::error("SessionCgiHandler", address, r.getErrorMessage());
+    return s;
+}
+
 Result<void> SessionCgiHandler::onCgiHeadersReady(
     HttpSession& session, CgiSession& cgi)
 {
@@ -170,17 +303,20 @@ Result<void> SessionCgiHandler::handleCgiError_(
     HttpSession& session, CgiSession& cgi, const std::string& message)
 {
     SessionContext& ctx = session.getContext();
-    if (dynamic_cast<CloseWaitState*>(ctx.current_state))
+    // CGI 側のイベント処理中に遷移した場合、HttpSession の状態はまだ
+    // pending_state にある（反映は HttpSession の次のイベント時）。
+    IHttpSessionState* state =
+        ctx.pending_state ? ctx.pending_state : ctx.current_state;
+    if (dynamic_cast<CloseWaitState*>(state))
         return Result<void>();
 
-    bool can_handle =
-        (dynamic_cast<ExecuteCgiState*>(ctx.current_state) != NULL);
+    bool can_handle = (dynamic_cast<ExecuteCgiState*>(state) != NULL);
     if (!can_handle)
     {
         // headers 完了後に body が来ないまま timeout したケースを拾う。
         // この場合は response_writer が未作成（ヘッダ未送出）なので 504
         // にできる。
-        if (dynamic_cast<SendResponseState*>(ctx.current_state) != NULL &&
+        if (dynamic_cast<SendResponseState*>(state) != NULL &&
             ctx.response_writer == NULL && ctx.cgi_stdout_fd_for_response >= 0)
         {
             can_handle = true;
@@ -238,6 +374,7 @@ Result<void> SessionCgiHandler::handleCgiError_(
         out.should_close_connection = false;
     }
     ctx.response.setHttpVersion(ctx.request.getHttpVersion());
+    closeIfRequestBodyPending_(ctx);
 
     session.installBodySourceAndWriter_(out.body_source);
 
@@ -281,6 +418,7 @@ Result<void> SessionCgiHandler::handleCgiHeadersReadyNormal_(
             out.should_close_connection = false;
         }
         ctx.response.setHttpVersion(ctx.request.getHttpVersion());
+        closeIfRequestBodyPending_(ctx);
 
         session.installBodySourceAndWriter_(out.body_source);
 
@@ -293,6 +431,9 @@ Result<void> SessionCgiHandler::handleCgiHeadersReadyNormal_(
         return Result<void>();
     }
 
+    // 残りのボディは引き続き CGI の stdin へ流す
+    closeIfRequestBodyPending_(ctx);
+
     const std::vector<utils::Byte> prefetched = cgi.takePrefetchedBody();
     const int stdout_fd = cgi.releaseStdoutFd();
     if (stdout_fd < 0)
@@ -354,6 +495,7 @@ Result<void> SessionCgiHandler::handleCgiHeadersReadyLocalRedirect_(
         if (bo.isError())
             return bo;
         ctx.response.setHttpVersion(ctx.request.getHttpVersion());
+        closeIfRequestBodyPending_(ctx);
 
         session.installBodySourceAndWriter_(out.body_source);
 
@@ -382,6 +524,10 @@ Result<void> SessionCgiHandler::handleCgiHeadersReadyLocalRedirect_(
 
     ctx.redirect_count++;
 
+    // 差し替え後のリクエストは完結しているので、元のボディの残りは読まない
+    if (ctx.request_handler.isStreamingBody() && !ctx.request.isParseComplete())
+        ctx.should_close_connection = true;
+
     Result<http::HttpRequest> rr =
         session.buildInternalRedirectRequest_(loc.unwrap());
     if (rr.isError())
@@ -1,6 +1,7 @@
 #ifndef WEBSERV_SESSION_CGI_HANDLER_HPP_
 #define WEBSERV_SESSION_CGI_HANDLER_HPP_
 
+#include <map>
 #include <string>
 
 #include "utils/result.hpp"
@@ -16,14 +17,20 @@ namespace server
 class HttpSession;
 class CgiSession;
 class FdSessionController;
+class FastCgiUpstreamPool;
+class CgiWorkerPool;
+struct CgiSpawnResult;
 
 class SessionCgiHandler
 {
    public:
-    explicit SessionCgiHandler(FdSessionController& controller);
+    SessionCgiHandler(FdSessionController& controller,
+        FastCgiUpstreamPool& fastcgi_upstreams, CgiWorkerPool& cgi_workers);
     ~SessionCgiHandler();
 
     utils::result::Result<void> startCgi(HttpSession& session);
+    // ボディを受信しながら stdin へ流せる CGI か（FastCGI は不可）
+    bool canStreamRequestBody(const HttpSession& session) const;
     utils::result::Result<void> onCgiHeadersReady(
         HttpSession& session, CgiSession& cgi);
     utils::result::Result<void> onCgiError(
@@ -31,6 +38,16 @@ class SessionCgiHandler
 
    private:
     FdSessionController& controller_;
+    FastCgiUpstreamPool& fastcgi_upstreams_;
+    CgiWorkerPool& cgi_workers_;
+
+    // FastCGI アップストリームへリクエストを送り始め、
+    // デコードした stdout を読むパイプを返す。
+    // request_body_fd の所有権を引き取る。
+    utils::result::Result<CgiSpawnResult> startFastCgi_(
+        const std::string& address, bool keep_conn,
+        const std::map<std::string, std::string>& params,
+        const std::string& body, int request_body_fd);
 
     utils::result::Result<void> handleCgiHeadersReadyLocalRedirect_(
         HttpSession& session, CgiSession& cgi, const http::CgiResponse& cr);
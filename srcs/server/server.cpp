@@ -10,7 +10,10 @@
 #include <cstring>
 #include <sstream>
 
+#include "http/http_date.hpp"
 #include "server/reactor/fd_event_reactor_factory.hpp"
+#include "server/session/fd_session/blocking_task_session.hpp"
+#include "server/session/fd_session/cgi_worker_pool_session.hpp"
 #include "server/session/fd_session/listener_session.hpp"
 #include "utils/log.hpp"
 
@@ -112,6 +115,9 @@ void Server::start()
         // ログ計測
         const long loop_start_seconds = utils::Timestamp::nowEpochSeconds();
 
+        // Date ヘッダーは秒が変わったときだけ整形し直す
+        http::HttpDate::update(loop_start_seconds);
+
         // 3. イベント処理
         session_controller_->dispatchEvents(occurred_events);
 
@@ -162,6 +168,40 @@ Result<void> Server::initialize()
         http_processing_module_ == NULL)
         return Result<void>(ERROR, "server components are not initialized");
 
+    // ブロッキング I/O 用ワーカー。起動できなくても、タスクはその場で
+    // 実行されるだけなので致命ではない。
+    Result<void> pool = http_processing_module_->blocking_tasks.start(
+        BlockingTaskPool::kDefaultWorkerCount);
+    if (pool.isOk())
+    {
+        BlockingTaskSession* completion = new BlockingTaskSession(
+            *session_controller_, http_processing_module_->blocking_tasks);
+        Result<void> d = session_controller_->delegateSession(completion);
+        if (d.isError())
+        {
+            delete completion;
+            http_processing_module_->blocking_tasks.stop();
+        }
+    }
+    if (pool.isError() || !http_processing_module_->blocking_tasks.isRunning())
+        Log::warning("blocking task pool is disabled");
+
+    http_processing_module_->cgi_limiter.configure(config_, &processing_log_);
+
+    // cgi_worker_pool のワーカは listen ソケットを開く前に起動しておく
+    http_processing_module_->cgi_workers.configure(config_);
+    if (!http_processing_module_->cgi_workers.empty())
+    {
+        CgiWorkerPoolSession* maintenance = new CgiWorkerPoolSession(
+            *session_controller_, http_processing_module_->cgi_workers);
+        Result<void> d = session_controller_->delegateSession(maintenance);
+        if (d.isError())
+        {
+            delete maintenance;
+            return Result<void>(ERROR, d.getErrorMessage());
+        }
+    }
+
     std::vector<Listen> listens = config_.getListens();
     if (listens.empty())
         return Result<void>(ERROR, "no listen endpoints");
@@ -2,11 +2,16 @@
 
 #include <fcntl.h>
 #include <signal.h>
+#include <spawn.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
 #include <string>
 
+#include "utils/log.hpp"
+
 namespace server
 {
 
@@ -46,8 +51,72 @@ void closePipeIfValid_(int pipefd[2])
     closeIfValid_(pipefd[1]);
 }
 
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define WEBSERV_HAVE_SPAWN_ADDCHDIR 1
+#endif
+
+#ifndef WEBSERV_HAVE_SPAWN_ADDCHDIR
+// posix_spawn で chdir できない環境向け。子側は async-signal-safe な
+// 呼び出しだけで exec まで進む。
+int forkExec_(const std::string& path, char* const* argv, char* const* envp,
+    const int child_fds[3], const int pipe_fds[6],
+    const std::string& working_dir, pid_t* out_pid)
+{
+    const pid_t pid = ::fork();
+    if (pid < 0)
+        return errno;
+    if (pid == 0)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (::dup2(child_fds[i], i) < 0)
+                ::_exit(1);
+        }
+        for (int i = 0; i < 6; ++i)
+            ::close(pipe_fds[i]);
+        if (!working_dir.empty() && ::chdir(working_dir.c_str()) < 0)
+            ::_exit(1);
+        ::execve(path.c_str(), argv, envp);
+        ::_exit(127);
+    }
+    *out_pid = pid;
+    return 0;
+}
+#endif
+
 }  // namespace
 
+// fork() はサーバーのページテーブルを丸ごと複製するため、キャッシュ等で
+// プロセスが大きくなるほど起動が遅くなる。posix_spawn (glibc では
+// CLONE_VM|CLONE_VFORK) を使い、dup2/close/chdir は file actions で行う。
+int CgiPipeFd::spawnChild_(const std::string& path, char* const* argv,
+    char* const* envp, const int child_fds[3], const int pipe_fds[6],
+    const std::string& working_dir, pid_t* out_pid)
+{
+#ifdef WEBSERV_HAVE_SPAWN_ADDCHDIR
+    posix_spawn_file_actions_t actions;
+    int err = ::posix_spawn_file_actions_init(&actions);
+    if (err != 0)
+        return err;
+
+    for (int i = 0; i < 3 && err == 0; ++i)
+        err = ::posix_spawn_file_actions_adddup2(&actions, child_fds[i], i);
+    for (int i = 0; i < 6 && err == 0; ++i)
+        err = ::posix_spawn_file_actions_addclose(&actions, pipe_fds[i]);
+    if (err == 0 && !working_dir.empty())
+        err = ::posix_spawn_file_actions_addchdir_np(
+            &actions, working_dir.c_str());
+    if (err == 0)
+        err = ::posix_spawn(out_pid, path.c_str(), &actions, NULL, argv, envp);
+    ::posix_spawn_file_actions_destroy(&actions);
+    return err;
+#else
+    return forkExec_(path, argv, envp, child_fds, pipe_fds, working_dir,
+        out_pid);
+#endif
+}
+
 std::vector<std::string> CgiPipeFd::buildEnvEntries(
     const std::map<std::string, std::string>& env_vars)
 {
@@ -78,56 +147,58 @@ Result<CgiSpawnResult> CgiPipeFd::Execute(const std::string& script_path,
         return Result<CgiSpawnResult>(ERROR, "pipe() failed");
     }
 
-    pid_t pid = fork();
-    if (pid < 0)
+    // 引数・環境変数は親で組み立てておく（子側ではメモリ確保をしない）
+    std::vector<char*> argv_ptrs;
+    argv_ptrs.push_back(const_cast<char*>(script_path.c_str()));
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        argv_ptrs.push_back(const_cast<char*>(args[i].c_str()));
+    }
+    argv_ptrs.push_back(NULL);
+
+    std::vector<std::string> env_entries = buildEnvEntries(env_vars);
+    std::vector<char*> envp_ptrs;
+    for (size_t i = 0; i < env_entries.size(); ++i)
+    {
+        envp_ptrs.push_back(const_cast<char*>(env_entries[i].c_str()));
+    }
+    envp_ptrs.push_back(NULL);
+
+    const int child_fds[3] = {stdin_pipe[0], stdout_pipe[1], stderr_pipe[1]};
+    const int pipe_fds[6] = {stdin_pipe[0], stdin_pipe[1], stdout_pipe[0],
+        stdout_pipe[1], stderr_pipe[0], stderr_pipe[1]};
+    pid_t pid = -1;
+    const int err = spawnChild_(script_path, &argv_ptrs[0], &envp_ptrs[0],
+        child_fds, pipe_fds, working_dir, &pid);
+    if (err == EAGAIN || err == ENOMEM)
     {
         closePipeIfValid_(stdin_pipe);
         closePipeIfValid_(stdout_pipe);
         closePipeIfValid_(stderr_pipe);
-        return Result<CgiSpawnResult>(ERROR, "fork() failed");
+        return Result<CgiSpawnResult>(
+            ERROR, std::string("posix_spawn() failed: ") + ::strerror(err));
     }
-
-    if (pid == 0)
+    if (err != 0)
     {
-        // 子プロセス
-        if (::dup2(stdin_pipe[0], STDIN_FILENO) < 0 ||
-            ::dup2(stdout_pipe[1], STDOUT_FILENO) < 0 ||
-            ::dup2(stderr_pipe[1], STDERR_FILENO) < 0)
-        {
-            ::_exit(1);
-        }
-
+        // exec/chdir の失敗は、fork 時代に子が出力なしで終了していたのと
+        // 同じく「CGI が何も返さなかった」扱い (502) にする
+        utils::Log::error("CgiPipeFd", "cannot execute " + script_path + ":",
+            ::strerror(err));
         closePipeIfValid_(stdin_pipe);
-        closePipeIfValid_(stdout_pipe);
+        closeIfValid_(stdout_pipe[1]);
         closePipeIfValid_(stderr_pipe);
-
-        if (!working_dir.empty())
+        Result<void> nb = setNonBlocking_(stdout_pipe[0]);
+        if (nb.isError())
         {
-            if (::chdir(working_dir.c_str()) < 0)
-            {
-                ::_exit(1);
-            }
+            closeIfValid_(stdout_pipe[0]);
+            return Result<CgiSpawnResult>(ERROR, nb.getErrorMessage());
         }
-
-        // 引数の準備
-        std::vector<char*> argv_ptrs;
-        argv_ptrs.push_back(const_cast<char*>(script_path.c_str()));
-        for (size_t i = 0; i < args.size(); ++i)
-        {
-            argv_ptrs.push_back(const_cast<char*>(args[i].c_str()));
-        }
-        argv_ptrs.push_back(NULL);
-
-        std::vector<std::string> env_entries = buildEnvEntries(env_vars);
-        std::vector<char*> envp_ptrs;
-        for (size_t i = 0; i < env_entries.size(); ++i)
-        {
-            envp_ptrs.push_back(const_cast<char*>(env_entries[i].c_str()));
-        }
-        envp_ptrs.push_back(NULL);
-
-        ::execve(script_path.c_str(), &argv_ptrs[0], &envp_ptrs[0]);
-        ::_exit(127);
+        CgiSpawnResult failed;
+        failed.pid = -1;
+        failed.stdin_fd = -1;
+        failed.stdout_fd = stdout_pipe[0];
+        failed.stderr_fd = -1;
+        return failed;
     }
 
     // 親プロセス
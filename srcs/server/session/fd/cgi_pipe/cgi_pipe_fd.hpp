@@ -22,7 +22,7 @@ struct CgiSpawnResult
     int stderr_fd;  // parent reads  <- child stderr
 };
 
-// CGIプロセスとのパイプ通信を管理（fork + pipe 実装）
+// CGIプロセスとのパイプ通信を管理（posix_spawn + pipe 実装）
 class CgiPipeFd : public FdBase
 {
    public:
@@ -46,6 +46,12 @@ class CgiPipeFd : public FdBase
 
     static std::vector<std::string> buildEnvEntries(
         const std::map<std::string, std::string>& env_vars);
+
+    // child_fds を子の stdin/stdout/stderr に dup2 し、pipe_fds は子側で
+    // すべて閉じてから path を exec する。posix_spawn と同じく errno 値を返す
+    static int spawnChild_(const std::string& path,
+        char* const* argv, char* const* envp, const int child_fds[3],
+        const int pipe_fds[6], const std::string& working_dir, pid_t* out_pid);
 };
 
 }  // namespace server
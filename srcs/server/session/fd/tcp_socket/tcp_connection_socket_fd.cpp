@@ -1,5 +1,8 @@
 #include "server/session/fd/tcp_socket/tcp_connection_socket_fd.hpp"
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 namespace server
@@ -10,7 +13,8 @@ TcpConnectionSocketFd::TcpConnectionSocketFd(
     : FdBase(fd),
       server_addr_(server_addr),
       client_addr_(client_addr),
-      is_shutdown_(false)
+      is_shutdown_(false),
+      is_corked_(false)
 {
 }
 
@@ -72,6 +76,22 @@ void TcpConnectionSocketFd::shutdown()
 
 bool TcpConnectionSocketFd::isShutdown() const { return is_shutdown_; }
 
+void TcpConnectionSocketFd::setCork(bool on)
+{
+    if (fd_ < 0 || is_corked_ == on)
+        return;
+    int v = on ? 1 : 0;
+#if defined(TCP_CORK)
+    if (::setsockopt(fd_, IPPROTO_TCP, TCP_CORK, &v, sizeof(v)) == 0)
+        is_corked_ = on;
+#elif defined(TCP_NOPUSH)
+    if (::setsockopt(fd_, IPPROTO_TCP, TCP_NOPUSH, &v, sizeof(v)) == 0)
+        is_corked_ = on;
+#else
+    (void)v;
+#endif
+}
+
 std::string TcpConnectionSocketFd::getResourceType() const
 {
     return "TcpConnectionSocketFd";
@@ -16,6 +16,7 @@ class TcpConnectionSocketFd : public FdBase
     const SocketAddress server_addr_;
     const SocketAddress client_addr_;
     bool is_shutdown_;
+    bool is_corked_;
 
    public:
     TcpConnectionSocketFd(int fd, const SocketAddress& server_addr,
@@ -33,6 +34,13 @@ class TcpConnectionSocketFd : public FdBase
 
     void shutdown();
     bool isShutdown() const;
+
+    // TCP_CORK (BSD 系は TCP_NOPUSH) の ON/OFF。
+    // ON の間、カーネルは満杯でないセグメントを最大 200ms 程度保留し、
+    // 後続の write と結合して送る。OFF にすると保留分を即座に送出する。
+    // 未対応の環境では何もしない。
+    void setCork(bool on);
+    bool isCorked() const { return is_corked_; }
     virtual std::string getResourceType() const;
 
    private:
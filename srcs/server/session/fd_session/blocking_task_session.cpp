@@ -0,0 +1,47 @@
+#include "server/session/fd_session/blocking_task_session.hpp"
+
+#include <vector>
+
+namespace server
+{
+
+BlockingTaskSession::BlockingTaskSession(
+    FdSessionController& controller, BlockingTaskPool& pool)
+    : FdSession(controller, 0),  // タイムアウトしない
+      pool_(pool)
+{
+}
+
+BlockingTaskSession::~BlockingTaskSession() {}
+
+bool BlockingTaskSession::isTimedOut() const { return false; }
+
+bool BlockingTaskSession::isComplete() const { return false; }
+
+void BlockingTaskSession::getInitialWatchSpecs(
+    std::vector<FdSession::FdWatchSpec>* out) const
+{
+    if (out == NULL || pool_.completionFd() < 0)
+        return;
+    out->push_back(FdSession::FdWatchSpec(pool_.completionFd(), true, false));
+}
+
+Result<void> BlockingTaskSession::handleEvent(const FdEvent& event)
+{
+    if (event.type != kReadEvent)
+        return Result<void>();
+
+    std::vector<BlockingTask*> done;
+    pool_.takeCompleted(&done);
+    for (size_t i = 0; i < done.size(); ++i)
+    {
+        BlockingTask* task = done[i];
+        task->complete();
+        if (task->waiter() != NULL)
+            task->waiter()->onBlockingTaskDone(*task);
+        delete task;
+    }
+    return Result<void>();
+}
+
+}  // namespace server
@@ -0,0 +1,36 @@
+#ifndef WEBSERV_BLOCKING_TASK_SESSION_HPP_
+#define WEBSERV_BLOCKING_TASK_SESSION_HPP_
+
+#include "server/blocking_task/blocking_task_pool.hpp"
+#include "server/reactor/fd_event.hpp"
+#include "server/session/fd_session.hpp"
+#include "utils/result.hpp"
+
+namespace server
+{
+using namespace utils::result;
+
+// BlockingTaskPool の完了通知 fd を監視し、完了したタスクを
+// イベントループのスレッドで受け手（HttpSession 等）へ渡す。
+class BlockingTaskSession : public FdSession
+{
+   public:
+    BlockingTaskSession(FdSessionController& controller, BlockingTaskPool& pool);
+    virtual ~BlockingTaskSession();
+
+    virtual bool isTimedOut() const;
+    virtual Result<void> handleEvent(const FdEvent& event);
+    virtual bool isComplete() const;
+    virtual void getInitialWatchSpecs(std::vector<FdWatchSpec>* out) const;
+
+   private:
+    BlockingTaskPool& pool_;  // fd の所有者は pool
+
+    BlockingTaskSession();
+    BlockingTaskSession(const BlockingTaskSession& rhs);
+    BlockingTaskSession& operator=(const BlockingTaskSession& rhs);
+};
+
+}  // namespace server
+
+#endif
@@ -1,17 +1,23 @@
 #include "server/session/fd_session/cgi_session.hpp"
 
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/select.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "server/http_processing_module/cgi_limiter.hpp"
 #include "server/session/fd_session/http_session.hpp"
+#include "server/session/fd_session/http_session/session_context.hpp"
 #include "utils/data_type.hpp"
 #include "utils/log.hpp"
 
 namespace server
 {
 
+const size_t CgiSession::kSpliceChunkBytes;
+
 CgiSession::CgiSession(pid_t pid, int in_fd, int out_fd, int err_fd,
     int request_body_fd, HttpSession* parent, FdSessionController& controller,
     utils::ProcessingLog* processing_log)
@@ -27,10 +33,16 @@ CgiSession::CgiSession(pid_t pid, int in_fd, int out_fd, int err_fd,
       parent_session_(parent),
       processing_log_(processing_log),
       is_counted_as_active_cgi_(false),
+      cgi_limiter_(NULL),
+      cgi_slot_key_(NULL),
       request_body_fd_(request_body_fd),
+      splices_request_body_(canSpliceFrom_(request_body_fd)),
+      has_spliced_request_body_(false),
+      streams_request_body_(false),
+      stdin_watch_write_(in_fd >= 0),
       is_stdout_eof_(false),
-      is_stderr_eof_(false),
-      input_complete_(false),
+      is_stderr_eof_(err_fd < 0),
+      input_complete_(in_fd < 0),
       headers_complete_(false),
       error_notified_to_parent_(false),
       prefetched_body_()
@@ -38,6 +50,37 @@ CgiSession::CgiSession(pid_t pid, int in_fd, int out_fd, int err_fd,
     updateLastActiveTime();
 }
 
+void CgiSession::preloadRequestBody(const utils::Byte* data, size_t len)
+{
+    if (data == NULL || len == 0)
+        return;
+    stdin_buffer_.append(reinterpret_cast<const char*>(data), len);
+}
+
+void CgiSession::streamRequestBody() { streams_request_body_ = true; }
+
+void CgiSession::onRequestBodyAvailable()
+{
+    if (!streams_request_body_ || input_complete_)
+        return;
+    // 親がボディを受信している間は、CGI が待っていても動いている扱い
+    updateLastActiveTime();
+
+    if (parent_session_ == NULL)
+    {
+        closeStdin_();
+        return;
+    }
+    const SessionContext& pctx = parent_session_->getContext();
+    const bool has_data = pctx.request_handler.bodyStream().size() > 0;
+    if (!has_data && pctx.request.isParseComplete())
+    {
+        closeStdin_();
+        return;
+    }
+    setStdinWriteWatch_(has_data);
+}
+
 std::vector<utils::Byte> CgiSession::takePrefetchedBody()
 {
     std::vector<utils::Byte> out;
@@ -104,6 +147,10 @@ CgiSession::~CgiSession()
         }
         pid_ = -1;
     }
+
+    // プロセスを回収してから枠を返す（待っているリクエストがここで起動する）
+    if (cgi_limiter_ != NULL)
+        cgi_limiter_->release(cgi_slot_key_);
 }
 
 // ログ計測
@@ -117,6 +164,12 @@ void CgiSession::markCountedAsActiveCgi()
     processing_log_->onCgiStarted();
 }
 
+void CgiSession::holdCgiSlot(CgiLimiter& limiter, const void* key)
+{
+    cgi_limiter_ = &limiter;
+    cgi_slot_key_ = key;
+}
+
 bool CgiSession::isComplete() const
 {
     // 親(HttpSession)が CGI の stdout をストリーミングしている間は、
@@ -169,6 +222,7 @@ Result<void> CgiSession::handleEvent(const FdEvent& event)
             error_notified_to_parent_ = true;
             (void)parent_session_->onCgiError(*this, msg);
         }
+        detachFromParent_();
         controller_.requestDelete(this);
         return Result<void>(ERROR, msg);
     }
@@ -190,6 +244,7 @@ Result<void> CgiSession::handleEvent(const FdEvent& event)
             error_notified_to_parent_ = true;
             (void)parent_session_->onCgiError(*this, r.getErrorMessage());
         }
+        detachFromParent_();
         controller_.requestDelete(this);
         return r;
     }
@@ -200,6 +255,18 @@ Result<void> CgiSession::handleEvent(const FdEvent& event)
     return r;
 }
 
+// 親がエラーを引き取らなかった場合（例: body 送信中）でも自分は削除されるので、
+// 親に残っている参照を外しておく。残したままだと、親のレスポンス完了時に
+// 削除済みの CgiSession を requestDelete して二重解放になる。
+void CgiSession::detachFromParent_()
+{
+    if (parent_session_ == NULL)
+        return;
+    if (parent_session_->getContext().active_cgi_session == this)
+        parent_session_->getContext().active_cgi_session = NULL;
+    parent_session_ = NULL;
+}
+
 Result<void> CgiSession::fillStdinBufferIfNeeded_()
 {
     if (request_body_fd_ < 0)
@@ -225,6 +292,77 @@ Result<void> CgiSession::fillStdinBufferIfNeeded_()
     return Result<void>();
 }
 
+// splice() の読み元にできるのは Linux の通常ファイル（BodyStore の一時ファイル）
+bool CgiSession::canSpliceFrom_(int fd)
+{
+#ifdef __linux__
+    struct stat st;
+    return fd >= 0 && ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+// BodyStore に退避したボディをユーザー空間を経由せずに stdin パイプへ移す。
+// 一度に移すのはパイプが受け取れる分だけで、残りは次の書き込みイベントで送る。
+// 書き込みイベントで呼ぶので、失敗は flushToFd() と同じくエラーとして扱う。
+// ただし最初の1回だけは、splice() に対応しないファイルシステムの可能性が
+// あるので、失敗したら read/write に切り替える。
+Result<void> CgiSession::spliceRequestBody_()
+{
+#ifdef __linux__
+    const ssize_t n = ::splice(request_body_fd_, NULL, pipe_in_.getFd(), NULL,
+        kSpliceChunkBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n > 0)
+    {
+        has_spliced_request_body_ = true;
+        return Result<void>();
+    }
+    if (n == 0)
+    {
+        ::close(request_body_fd_);
+        request_body_fd_ = -1;
+        return Result<void>();
+    }
+    if (has_spliced_request_body_)
+        return Result<void>(ERROR, "internal fd splice failed");
+#endif
+    splices_request_body_ = false;
+    return Result<void>();
+}
+
+// 親の受信したボディを stdin へ書き、空いた分を親に受信させる。
+// watch の付け外しと stdin を閉じる判断は、親から呼ばれる
+// onRequestBodyAvailable() で行う。
+Result<void> CgiSession::flushRequestBodyStream_()
+{
+    if (parent_session_ == NULL)
+    {
+        closeStdin_();
+        return Result<void>();
+    }
+    IoBuffer& stream =
+        parent_session_->getContext().request_handler.bodyStream();
+    if (stream.size() > 0)
+    {
+        const ssize_t w = stream.flushToFd(pipe_in_.getFd());
+        if (w < 0)
+            return Result<void>(ERROR, "internal fd write failed");
+    }
+    return parent_session_->onCgiRequestBodyDrained(*this);
+}
+
+void CgiSession::setStdinWriteWatch_(bool on)
+{
+    if (pipe_in_.getFd() < 0 || on == stdin_watch_write_)
+        return;
+    // read/write とも外すと fd ごと登録解除されるので、再開は setWatch で行う
+    Result<void> r = controller_.setWatch(pipe_in_.getFd(), this, false, on);
+    if (r.isOk())
+        stdin_watch_write_ = on;
+}
+
 void CgiSession::closeStdin_()
 {
     if (pipe_in_.getFd() >= 0)
@@ -245,9 +383,22 @@ Result<void> CgiSession::handleStdin_(FdEventType type)
     if (input_complete_)
         return Result<void>();
 
-    Result<void> f = fillStdinBufferIfNeeded_();
-    if (f.isError())
-        return f;
+    if (streams_request_body_)
+        return flushRequestBodyStream_();
+
+    if (splices_request_body_ && stdin_buffer_.size() == 0)
+    {
+        Result<void> s = spliceRequestBody_();
+        if (s.isError())
+            return s;
+    }
+
+    if (!splices_request_body_)
+    {
+        Result<void> f = fillStdinBufferIfNeeded_();
+        if (f.isError())
+            return f;
+    }
 
     if (stdin_buffer_.size() > 0)
     {
@@ -24,12 +24,15 @@ using namespace utils::result;
 using namespace http;
 
 class HttpSession;
+class CgiLimiter;
 
 // CGIセッション：CGIプロセスとの通信状態を管理
 class CgiSession : public FdSession
 {
    public:
     static const long kDefaultTimeoutSec = 10;
+    // splice() 1回で stdin パイプへ移す上限（パイプの既定容量）
+    static const size_t kSpliceChunkBytes = 64 * 1024;
 
     CgiSession(pid_t pid, int in_fd, int out_fd, int err_fd,
         int request_body_fd, HttpSession* parent,
@@ -45,6 +48,20 @@ class CgiSession : public FdSession
     // ログ計測
     void markCountedAsActiveCgi();
 
+    // CgiLimiter の枠を引き取り、破棄時に返す
+    void holdCgiSlot(CgiLimiter& limiter, const void* key);
+
+    // メモリ上のリクエストボディを stdin へ送るよう積んでおく
+    // （request_body_fd を使わない場合。delegateSession 前に呼ぶ）。
+    void preloadRequestBody(const utils::Byte* data, size_t len);
+
+    // ボディを親 HttpSession の受信に合わせて stdin へ流す
+    // （cgi_request_buffering off。delegateSession 前に呼ぶ）。
+    // 親の bodyStream() から書き、受信し終えて空になったら stdin を閉じる。
+    void streamRequestBody();
+    // 親がボディを bodyStream() に積んだ / 受信し終えたときに呼ぶ
+    void onRequestBodyAvailable();
+
     HttpSession* getParentSession() const { return parent_session_; }
 
     bool isHeadersComplete() const { return headers_complete_; }
@@ -88,9 +105,21 @@ class CgiSession : public FdSession
     utils::ProcessingLog* processing_log_;
     bool is_counted_as_active_cgi_;
 
+    // cgi_max_concurrency の枠（持っていなければ NULL）
+    CgiLimiter* cgi_limiter_;
+    const void* cgi_slot_key_;
+
     // HTTP Request Body を送る元（BodyStore の openForRead() のFD）。
-    // -1 の場合はボディなし。
+    // -1 の場合はボディなし、または preloadRequestBody() で積み済み。
     int request_body_fd_;
+    // request_body_fd_ から stdin へ splice() で直接移すか。
+    // 最初の splice() が失敗したら false にして read/write に戻す。
+    bool splices_request_body_;
+    bool has_spliced_request_body_;
+    // true なら親の bodyStream() を stdin へ書く
+    bool streams_request_body_;
+    // 書くものが無い間は stdin の write watch を外している
+    bool stdin_watch_write_;
 
     // --- 状態管理 ---
     bool is_stdout_eof_;
@@ -113,7 +142,12 @@ class CgiSession : public FdSession
 
     Result<void> tryParseStdoutHeaders_();
     Result<void> fillStdinBufferIfNeeded_();
+    static bool canSpliceFrom_(int fd);
+    Result<void> spliceRequestBody_();
+    Result<void> flushRequestBodyStream_();
+    void setStdinWriteWatch_(bool on);
     void closeStdin_();
+    void detachFromParent_();
 };
 
 }  // namespace server
@@ -0,0 +1,34 @@
+#include "server/session/fd_session/cgi_worker_pool_session.hpp"
+
+#include "server/session/fd_session_controller.hpp"
+
+namespace server
+{
+
+CgiWorkerPoolSession::CgiWorkerPoolSession(
+    FdSessionController& controller, CgiWorkerPool& pool)
+    : FdSession(controller, kTickSec), pool_(pool)
+{
+}
+
+CgiWorkerPoolSession::~CgiWorkerPoolSession() {}
+
+bool CgiWorkerPoolSession::isComplete() const { return false; }
+
+Result<void> CgiWorkerPoolSession::handleEvent(const FdEvent& event)
+{
+    if (event.type != kTimeoutEvent)
+        return Result<void>();
+
+    pool_.maintain();
+    CgiWorkerPoolSession* next = new CgiWorkerPoolSession(controller_, pool_);
+    Result<void> d = controller_.delegateSession(next);
+    if (d.isError())
+    {
+        delete next;
+        return d;
+    }
+    return Result<void>();
+}
+
+}  // namespace server
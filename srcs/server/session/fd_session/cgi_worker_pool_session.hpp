@@ -0,0 +1,38 @@
+#ifndef WEBSERV_CGI_WORKER_POOL_SESSION_HPP_
+#define WEBSERV_CGI_WORKER_POOL_SESSION_HPP_
+
+#include "server/http_processing_module/cgi_worker_pool.hpp"
+#include "server/reactor/fd_event.hpp"
+#include "server/session/fd_session.hpp"
+#include "utils/result.hpp"
+
+namespace server
+{
+using namespace utils::result;
+
+// fd を持たず、タイムアウトを使って CgiWorkerPool::maintain() を
+// 定期的に呼ぶだけのセッション。
+// タイムアウトしたセッションは controller に回収されるため、
+// 発火のたびに後継を登録して次の周期につなぐ。
+class CgiWorkerPoolSession : public FdSession
+{
+   public:
+    static const int kTickSec = 1;
+
+    CgiWorkerPoolSession(FdSessionController& controller, CgiWorkerPool& pool);
+    virtual ~CgiWorkerPoolSession();
+
+    virtual Result<void> handleEvent(const FdEvent& event);
+    virtual bool isComplete() const;
+
+   private:
+    CgiWorkerPool& pool_;
+
+    CgiWorkerPoolSession();
+    CgiWorkerPoolSession(const CgiWorkerPoolSession& rhs);
+    CgiWorkerPoolSession& operator=(const CgiWorkerPoolSession& rhs);
+};
+
+}  // namespace server
+
+#endif
@@ -0,0 +1,441 @@
+#include "server/session/fd_session/fastcgi_session.hpp"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "http/fastcgi_record.hpp"
+#include "server/http_processing_module/fastcgi_upstream_pool.hpp"
+#include "utils/data_type.hpp"
+#include "utils/log.hpp"
+
+namespace server
+{
+
+using http::FastCgiRecord;
+
+const size_t FastCgiSession::kMaxPendingOutput;
+
+namespace
+{
+
+// 1接続で同時に1リクエストしか扱わないので、request id は常に 1
+const unsigned int kRequestId = 1;
+
+// 1回に読み込むリクエストボディの量
+const size_t kStdinChunkBytes = 4 * utils::kPageSizeMin;
+
+bool setNonBlockingCloexec_(int fd)
+{
+    const int fl = ::fcntl(fd, F_GETFL, 0);
+    if (fl < 0 || ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0)
+        return false;
+    return ::fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+// "unix:/path" か "host:port"（設定の読み込み時に検証済み）
+Result<int> openSocket_(const std::string& address, struct sockaddr_storage* sa,
+    socklen_t* sa_len)
+{
+    std::memset(sa, 0, sizeof(*sa));
+    if (address.compare(0, 5, "unix:") == 0)
+    {
+        const std::string path = address.substr(5);
+        struct sockaddr_un* un = reinterpret_cast<struct sockaddr_un*>(sa);
+        if (path.size() >= sizeof(un->sun_path))
+            return Result<int>(ERROR, "fastcgi socket path too long");
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+        *sa_len = static_cast<socklen_t>(sizeof(*un));
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return Result<int>(ERROR, "socket() failed");
+        return fd;
+    }
+
+    const std::string::size_type colon = address.rfind(':');
+    if (colon == std::string::npos)
+        return Result<int>(ERROR, "invalid fastcgi address");
+    std::string host = address.substr(0, colon);
+    if (host == "localhost")
+        host = "127.0.0.1";
+    struct sockaddr_in* in = reinterpret_cast<struct sockaddr_in*>(sa);
+    in->sin_family = AF_INET;
+    in->sin_port = htons(static_cast<unsigned short>(
+        std::atoi(address.c_str() + colon + 1)));
+    if (::inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1)
+        return Result<int>(ERROR, "invalid fastcgi address");
+    *sa_len = static_cast<socklen_t>(sizeof(*in));
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return Result<int>(ERROR, "socket() failed");
+    return fd;
+}
+
+}  // namespace
+
+FastCgiSession::FastCgiSession(FdSessionController& controller,
+    FastCgiUpstreamPool& pool, const std::string& address, int sock_fd,
+    bool connecting, bool keep_conn)
+    : FdSession(controller, kDefaultTimeoutSec),
+      pool_(pool),
+      address_(address),
+      sock_fd_(sock_fd),
+      keep_conn_(keep_conn),
+      connecting_(connecting),
+      busy_(false),
+      end_received_(false),
+      stdin_done_(false),
+      send_buf_(),
+      recv_buf_(),
+      out_buf_(),
+      body_fd_(-1),
+      out_fd_(-1)
+{
+}
+
+FastCgiSession::~FastCgiSession()
+{
+    pool_.onClosed(this);
+    closeRequestFds_();
+    if (sock_fd_ >= 0)
+    {
+        controller_.unregisterFd(sock_fd_);
+        ::close(sock_fd_);
+        sock_fd_ = -1;
+    }
+}
+
+Result<int> FastCgiSession::connectTo(
+    const std::string& address, bool* connecting)
+{
+    struct sockaddr_storage sa;
+    socklen_t sa_len = 0;
+    Result<int> s = openSocket_(address, &sa, &sa_len);
+    if (s.isError())
+        return s;
+    const int fd = s.unwrap();
+    if (!setNonBlockingCloexec_(fd))
+    {
+        ::close(fd);
+        return Result<int>(ERROR, "fcntl() failed");
+    }
+
+    *connecting = false;
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&sa), sa_len) < 0)
+    {
+        if (errno != EINPROGRESS)
+        {
+            ::close(fd);
+            return Result<int>(ERROR, "fastcgi connect failed");
+        }
+        *connecting = true;
+    }
+    return fd;
+}
+
+bool FastCgiSession::isComplete() const { return false; }
+
+void FastCgiSession::getInitialWatchSpecs(
+    std::vector<FdSession::FdWatchSpec>* out) const
+{
+    if (out == NULL || sock_fd_ < 0)
+        return;
+    // 接続完了は書き込み可能で分かる。アイドル中は相手の切断だけを見る。
+    out->push_back(FdSession::FdWatchSpec(sock_fd_, !connecting_, connecting_));
+}
+
+// アイドル中に読めるものがあるのは、相手が閉じた（0）か想定外のデータ。
+// どちらも再利用しない。
+bool FastCgiSession::isAlive() const
+{
+    if (busy_ || sock_fd_ < 0)
+        return false;
+    if (connecting_)
+        return true;
+    char c;
+    return ::recv(sock_fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT) < 0;
+}
+
+Result<void> FastCgiSession::startRequest(
+    const std::map<std::string, std::string>& params, const std::string& body,
+    int body_fd, int out_fd)
+{
+    if (busy_)
+    {
+        if (body_fd >= 0)
+            ::close(body_fd);
+        if (out_fd >= 0)
+            ::close(out_fd);
+        return Result<void>(ERROR, "fastcgi connection is busy");
+    }
+
+    busy_ = true;
+    end_received_ = false;
+    stdin_done_ = false;
+    body_fd_ = body_fd;
+    out_fd_ = out_fd;
+    updateLastActiveTime();
+
+    std::string records;
+    FastCgiRecord::appendBeginRequest(kRequestId, keep_conn_, &records);
+    FastCgiRecord::appendParams(kRequestId, params, &records);
+    if (!body.empty())
+        FastCgiRecord::appendStream(FastCgiRecord::kStdin, kRequestId,
+            body.data(), body.size(), &records);
+    if (body_fd_ < 0)
+    {
+        FastCgiRecord::appendStream(
+            FastCgiRecord::kStdin, kRequestId, NULL, 0, &records);
+        stdin_done_ = true;
+    }
+    send_buf_.append(records);
+
+    updateWatches_();
+    return Result<void>();
+}
+
+Result<void> FastCgiSession::handleEvent(const FdEvent& event)
+{
+    updateLastActiveTime();
+
+    if (event.type == kTimeoutEvent)
+    {
+        drop_(busy_ ? "fastcgi upstream timeout" : "");
+        return Result<void>();
+    }
+    if (event.type == kErrorEvent)
+    {
+        drop_(busy_ ? "fastcgi connection error" : "");
+        return Result<void>();
+    }
+
+    Result<void> r;
+    if (event.fd == sock_fd_ && event.type == kWriteEvent)
+        r = handleSocketWrite_();
+    else if (event.fd == sock_fd_ && event.type == kReadEvent)
+        r = handleSocketRead_();
+    else if (event.fd == out_fd_ && event.type == kWriteEvent)
+        r = handleOutput_();
+
+    if (r.isError())
+    {
+        drop_(r.getErrorMessage());
+        return r;
+    }
+    return Result<void>();
+}
+
+Result<void> FastCgiSession::handleSocketWrite_()
+{
+    if (connecting_)
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(sock_fd_, SOL_SOCKET, SO_ERROR, &err, &len) < 0 ||
+            err != 0)
+            return Result<void>(ERROR, "fastcgi connect failed");
+        connecting_ = false;
+    }
+
+    if (busy_)
+    {
+        Result<void> f = fillStdin_();
+        if (f.isError())
+            return f;
+        if (send_buf_.size() > 0 && send_buf_.flushToFd(sock_fd_) < 0)
+            return Result<void>(ERROR, "fastcgi write failed");
+    }
+    updateWatches_();
+    return Result<void>();
+}
+
+// send_buf_ が減ってきたらリクエストボディを読み足す
+Result<void> FastCgiSession::fillStdin_()
+{
+    if (stdin_done_ || body_fd_ < 0 || send_buf_.size() >= kStdinChunkBytes)
+        return Result<void>();
+
+    char buf[kStdinChunkBytes];
+    const ssize_t n = ::read(body_fd_, buf, sizeof(buf));
+    if (n < 0)
+        return Result<void>(ERROR, "internal fd read failed");
+
+    std::string records;
+    if (n == 0)
+    {
+        ::close(body_fd_);
+        body_fd_ = -1;
+        FastCgiRecord::appendStream(
+            FastCgiRecord::kStdin, kRequestId, NULL, 0, &records);
+        stdin_done_ = true;
+    }
+    else
+    {
+        FastCgiRecord::appendStream(FastCgiRecord::kStdin, kRequestId, buf,
+            static_cast<size_t>(n), &records);
+    }
+    send_buf_.append(records);
+    return Result<void>();
+}
+
+Result<void> FastCgiSession::handleSocketRead_()
+{
+    const ssize_t n = recv_buf_.fillFromFd(sock_fd_);
+    if (n < 0)
+        return Result<void>(ERROR, "fastcgi read failed");
+    if (n == 0 || !busy_)
+    {
+        // アイドル中の切断（または想定外のデータ）は静かに捨てる
+        drop_(busy_ ? "fastcgi upstream closed connection" : "");
+        return Result<void>();
+    }
+
+    Result<void> c = consumeRecords_();
+    if (c.isError())
+        return c;
+    return handleOutput_();
+}
+
+Result<void> FastCgiSession::consumeRecords_()
+{
+    FastCgiRecord::Header h;
+    while (!end_received_)
+    {
+        size_t segment_len = 0;
+        const char* record = recv_buf_.frontSegment(&segment_len);
+        const bool has_header =
+            FastCgiRecord::parseHeader(record, segment_len, &h);
+        if (!has_header || segment_len < h.recordSize())
+        {
+            // レコード全体が届いていなければ待つ
+            if (recv_buf_.size() < FastCgiRecord::kHeaderSize ||
+                (has_header && recv_buf_.size() < h.recordSize()))
+                break;
+            // 届いているがラップをまたいでいる場合だけ並べ直す
+            recv_buf_.linearize();
+            continue;
+        }
+        const char* content = record + FastCgiRecord::kHeaderSize;
+
+        if (h.request_id == kRequestId)
+        {
+            if (h.type == FastCgiRecord::kStdout && h.content_length > 0)
+            {
+                out_buf_.append(content, h.content_length);
+            }
+            else if (h.type == FastCgiRecord::kStderr && h.content_length > 0)
+            {
+                utils::Log::error("FastCgiSession", "FastCGI stderr:",
+                    std::string(content, h.content_length));
+            }
+            else if (h.type == FastCgiRecord::kEndRequest)
+            {
+                if (h.content_length < FastCgiRecord::kEndRequestBodySize)
+                    return Result<void>(ERROR, "malformed fastcgi record");
+                if (FastCgiRecord::endRequestProtocolStatus(content) !=
+                    FastCgiRecord::kRequestComplete)
+                    return Result<void>(ERROR, "fastcgi request rejected");
+                end_received_ = true;
+            }
+        }
+        // 管理レコード（request id 0）などは読み捨てる
+        recv_buf_.consume(h.recordSize());
+    }
+    return Result<void>();
+}
+
+Result<void> FastCgiSession::handleOutput_()
+{
+    if (out_buf_.size() > 0)
+    {
+        if (out_fd_ < 0)
+            return Result<void>(ERROR, "cgi output closed");
+        // 読み手（CgiSession / HttpSession）が先に閉じていれば EPIPE
+        if (out_buf_.flushToFd(out_fd_) < 0)
+            return Result<void>(ERROR, "cgi output closed");
+    }
+    finishRequestIfDone_();
+    updateWatches_();
+    return Result<void>();
+}
+
+// END_REQUEST を受け取り、stdout を全部パイプへ渡し終えたら1リクエスト完了
+void FastCgiSession::finishRequestIfDone_()
+{
+    if (!busy_ || !end_received_ || out_buf_.size() > 0)
+        return;
+
+    // out_fd_ を閉じると CgiSession 側に EOF が届く
+    closeRequestFds_();
+    busy_ = false;
+    end_received_ = false;
+
+    // stdin を送り切る前に応答が終わった場合、送りかけのレコードが残るので
+    // この接続は使い回さない
+    if (!keep_conn_ || !stdin_done_ || send_buf_.size() > 0 ||
+        recv_buf_.size() > 0)
+    {
+        drop_("");
+        return;
+    }
+    if (!pool_.release(this))
+        drop_("");
+}
+
+void FastCgiSession::updateWatches_()
+{
+    if (sock_fd_ >= 0)
+    {
+        const bool want_read =
+            !connecting_ && (!busy_ || (!end_received_ &&
+                                           out_buf_.size() < kMaxPendingOutput));
+        const bool want_write =
+            connecting_ ||
+            (busy_ && (send_buf_.size() > 0 || !stdin_done_));
+        (void)controller_.setWatch(sock_fd_, this, want_read, want_write);
+    }
+    if (out_fd_ >= 0)
+        (void)controller_.setWatch(out_fd_, this, false, out_buf_.size() > 0);
+}
+
+void FastCgiSession::closeRequestFds_()
+{
+    if (out_fd_ >= 0)
+    {
+        controller_.unregisterFd(out_fd_);
+        ::close(out_fd_);
+        out_fd_ = -1;
+    }
+    if (body_fd_ >= 0)
+    {
+        ::close(body_fd_);
+        body_fd_ = -1;
+    }
+}
+
+// 接続を捨てる。処理中のリクエストは out_fd_ を閉じて CgiSession に任せる。
+void FastCgiSession::drop_(const std::string& reason)
+{
+    if (!reason.empty())
+        utils::Log::error("FastCgiSession", address_, reason);
+    closeRequestFds_();
+    busy_ = false;
+    if (sock_fd_ >= 0)
+    {
+        controller_.unregisterFd(sock_fd_);
+        ::close(sock_fd_);
+        sock_fd_ = -1;
+    }
+    pool_.forget(this);
+    controller_.requestDelete(this);
+}
+
+}  // namespace server
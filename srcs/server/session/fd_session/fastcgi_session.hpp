@@ -0,0 +1,95 @@
+#ifndef WEBSERV_FASTCGI_SESSION_HPP_
+#define WEBSERV_FASTCGI_SESSION_HPP_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "server/reactor/fd_event.hpp"
+#include "server/session/fd_session.hpp"
+#include "server/session/fd_session_controller.hpp"
+#include "server/session/io_buffer.hpp"
+#include "utils/result.hpp"
+
+namespace server
+{
+using namespace utils::result;
+
+class FastCgiUpstreamPool;
+
+// FastCGI アップストリーム（php-fpm 等）との1本の接続。
+// - keep_conn なら接続を使い回す（FCGI_KEEP_CONN）。同時に扱うリクエストは
+//   1つだけ。keep_conn でなければ1リクエストで閉じる。
+// - FCGI_STDOUT をデコードしたバイト列は out_fd（パイプの書き込み側）へ流す。
+//   読み出し側は通常の CGI と同じく CgiSession が持つので、
+//   レスポンスヘッダの解析や 502/504 の扱いはそのまま使える。
+// - 失敗時は out_fd を閉じるだけで、CgiSession 側はヘッダ前の EOF として
+//   502 を返す。
+class FastCgiSession : public FdSession
+{
+   public:
+    static const long kDefaultTimeoutSec = 30;
+
+    FastCgiSession(FdSessionController& controller, FastCgiUpstreamPool& pool,
+        const std::string& address, int sock_fd, bool connecting,
+        bool keep_conn);
+    virtual ~FastCgiSession();
+
+    virtual Result<void> handleEvent(const FdEvent& event);
+    virtual bool isComplete() const;
+    virtual void getInitialWatchSpecs(std::vector<FdWatchSpec>* out) const;
+
+    // 非ブロッキングで接続を開始する。
+    // 接続中（EINPROGRESS）なら *connecting = true。
+    static Result<int> connectTo(const std::string& address, bool* connecting);
+
+    const std::string& address() const { return address_; }
+    bool isBusy() const { return busy_; }
+    // アイドル中に相手が閉じていないか（プールから取り出す前の確認）
+    bool isAlive() const;
+
+    // リクエストを1つ送り始める。
+    // body_fd / out_fd の所有権を引き取る（失敗時も close 済みにする）。
+    Result<void> startRequest(const std::map<std::string, std::string>& params,
+        const std::string& body, int body_fd, int out_fd);
+
+   private:
+    // out_buf_ がこれを超えたらソケットの読み込みを止める
+    static const size_t kMaxPendingOutput = 64 * 1024;
+
+    FastCgiUpstreamPool& pool_;
+    std::string address_;
+    int sock_fd_;
+
+    bool keep_conn_;
+    bool connecting_;
+    bool busy_;
+    bool end_received_;
+    bool stdin_done_;
+
+    IoBuffer send_buf_;  // FastCGI レコード（送信待ち）
+    IoBuffer recv_buf_;  // FastCGI レコード（受信途中）
+    IoBuffer out_buf_;   // デコード済み stdout（パイプへの書き込み待ち）
+
+    int body_fd_;  // 残りのリクエストボディの読み元。-1 なら無し
+    int out_fd_;   // CgiSession が読むパイプの書き込み側
+
+    FastCgiSession();
+    FastCgiSession(const FastCgiSession& rhs);
+    FastCgiSession& operator=(const FastCgiSession& rhs);
+
+    Result<void> handleSocketWrite_();
+    Result<void> handleSocketRead_();
+    Result<void> handleOutput_();
+    Result<void> fillStdin_();
+    Result<void> consumeRecords_();
+    void finishRequestIfDone_();
+    void updateWatches_();
+    void closeRequestFds_();
+    void drop_(const std::string& reason);
+};
+
+}  // namespace server
+
+#endif
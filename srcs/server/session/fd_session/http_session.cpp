@@ -1,6 +1,9 @@
 #include "server/session/fd_session/http_session.hpp"
 
+#include "server/session/fd_session/http_session/actions/execute_cgi_action.hpp"
+#include "server/session/fd_session/http_session/actions/i_request_action.hpp"
 #include "server/session/fd_session/http_session/states/http_session_states.hpp"
+#include "server/session/fd_session_controller.hpp"
 #include "utils/log.hpp"
 
 namespace server
@@ -26,6 +29,10 @@ HttpSession::~HttpSession()
     if (processing_log_ != NULL && is_counted_as_active_connection_)
         processing_log_->onConnectionClosed();  // ログ計測
     clearBodyWatch_();
+    // 完了待ちのタスクは破棄されずに残るので、通知先だけ外す
+    if (context_.pending_blocking_task != NULL)
+        context_.pending_blocking_task->setWaiter(NULL);
+    module_.cgi_limiter.cancel(this);
     // cleanup is handled by SessionContext destructor
 }
 
@@ -60,6 +67,15 @@ bool HttpSession::isTimedOut() const
     if (dynamic_cast<const ExecuteCgiState*>(context_.current_state) != NULL)
         return false;
 
+    // ワーカーの処理はクライアントの無通信とは関係ない
+    if (dynamic_cast<const WaitBlockingTaskState*>(context_.current_state) !=
+        NULL)
+        return false;
+
+    // CGI の空き待ち。先行する CGI は自身のタイムアウトで必ず枠を返す
+    if (dynamic_cast<const WaitCgiSlotState*>(context_.current_state) != NULL)
+        return false;
+
     // headers は確定したが body が来るまでヘッダ送出を止めている間も、
     // CGI 側の timeout で 504 に差し替えるため HttpSession は timeout
     // させない。
@@ -93,4 +109,75 @@ Result<void> HttpSession::onCgiError(
     return module_.cgi_handler.onCgiError(*this, cgi, message);
 }
 
+Result<void> HttpSession::onCgiRequestBodyDrained(CgiSession& cgi)
+{
+    if (context_.active_cgi_session != &cgi)
+        return Result<void>();
+    return pumpRequestBodyToCgi_();
+}
+
+Result<void> HttpSession::startBlockingTask_(BlockingTask* task)
+{
+    task->setWaiter(this);
+    Result<void> s = module_.blocking_tasks.submit(task);
+    if (s.isOk())
+    {
+        context_.pending_blocking_task = task;
+        changeState(new WaitBlockingTaskState());
+        return updateSocketWatches_();
+    }
+
+    // ワーカーが無い場合はその場で実行する
+    task->run();
+    task->complete();
+    onBlockingTaskDone(*task);
+    delete task;
+    return Result<void>();
+}
+
+void HttpSession::onBlockingTaskDone(BlockingTask& task)
+{
+    context_.pending_blocking_task = NULL;
+
+    // 待っている間に接続が閉じられた
+    IHttpSessionState* state = context_.pending_state ? context_.pending_state
+                                                      : context_.current_state;
+    if (dynamic_cast<CloseWaitState*>(state) != NULL)
+        return;
+
+    context_.response.reset();
+    IRequestAction* action =
+        module_.dispatcher.resumeAfterBlockingTask(context_, task);
+    Result<void> r = action->execute(*this);
+    delete action;
+    if (r.isError())
+    {
+        utils::Log::error("HttpSession",
+            "failed to resume after blocking task:", r.getErrorMessage());
+        changeState(new CloseWaitState());
+        controller_.requestDelete(this);
+    }
+}
+
+void HttpSession::onCgiSlotGranted(const void* key)
+{
+    // 待っている間に接続が閉じられた
+    IHttpSessionState* state = context_.pending_state ? context_.pending_state
+                                                      : context_.current_state;
+    if (dynamic_cast<WaitCgiSlotState*>(state) == NULL)
+    {
+        module_.cgi_limiter.release(key);
+        return;
+    }
+
+    Result<void> r = ExecuteCgiAction::startWithSlot(*this, key);
+    if (r.isError())
+    {
+        utils::Log::error("HttpSession",
+            "failed to start queued cgi:", r.getErrorMessage());
+        changeState(new CloseWaitState());
+        controller_.requestDelete(this);
+    }
+}
+
 }  // namespace server
@@ -7,6 +7,7 @@
 #include "http/http_request.hpp"
 #include "http/http_response.hpp"
 #include "http/http_response_encoder.hpp"
+#include "server/blocking_task/blocking_task.hpp"
 #include "server/http_processing_module/http_processing_module.hpp"
 #include "server/http_processing_module/request_dispatcher.hpp"
 #include "server/http_processing_module/request_processor.hpp"
@@ -39,18 +40,28 @@ using namespace http;
 class CgiSession;
 class RecvRequestState;
 class ExecuteCgiState;
+class WaitBlockingTaskState;
+class WaitCgiSlotState;
 class SendResponseState;
 class CloseWaitState;
 class ProcessRequestAction;
 class SendErrorAction;
 class ExecuteCgiAction;
+class RunBlockingTaskAction;
 
-class HttpSession : public FdSession
+class HttpSession : public FdSession,
+                    public BlockingTask::Waiter,
+                    public CgiLimiter::Waiter
 {
    public:
     static const long kDefaultTimeoutSec = 10;
     static const int kMaxInternalRedirects = 5;
     static const size_t kMaxRecvBufferBytes = 64 * 1024;
+    // パイプライン時に 1 回の flush へまとめるレスポンス数/バイト数の上限
+    static const size_t kMaxPipelinedResponsesPerFlush = 16;
+    static const size_t kMaxSendBatchBytes = 64 * 1024;
+    // 1 回の write イベントで送信バッファに積む body の上限（接続間の公平性）
+    static const size_t kWriteBudgetBytesPerEvent = 128 * 1024;
 
     // テスト用
     const HttpRequest& request() const { return context_.request; }
@@ -82,6 +93,14 @@ class HttpSession : public FdSession
     // CGI通知ハンドラ
     Result<void> onCgiHeadersReady(CgiSession& cgi);
     Result<void> onCgiError(CgiSession& cgi, const std::string& message);
+    // CGI が stdin へボディを書いた（cgi_request_buffering off）
+    Result<void> onCgiRequestBodyDrained(CgiSession& cgi);
+
+    // BlockingTask の完了通知（イベントループのスレッドで呼ばれる）
+    virtual void onBlockingTaskDone(BlockingTask& task);
+
+    // cgi_max_concurrency の待ち行列から順番が回ってきた
+    virtual void onCgiSlotGranted(const void* key);
 
     // 状態遷移
     void changeState(IHttpSessionState* next_state);
@@ -91,12 +110,15 @@ class HttpSession : public FdSession
 
     friend class RecvRequestState;
     friend class ExecuteCgiState;
+    friend class WaitBlockingTaskState;
+    friend class WaitCgiSlotState;
     friend class SendResponseState;
     friend class CloseWaitState;
     friend class SessionCgiHandler;
     friend class ProcessRequestAction;
     friend class SendErrorAction;
     friend class ExecuteCgiAction;
+    friend class RunBlockingTaskAction;
 
    private:
     SessionContext context_;
@@ -129,14 +151,25 @@ class HttpSession : public FdSession
     // http_session_prepare.cpp
     Result<void> consumeRecvBufferWithoutRead_();
     Result<void> prepareResponseOrCgi_();
+    // cgi_request_buffering off: recv_buffer のボディを CGI へ流す
+    Result<void> pumpRequestBodyToCgi_();
+    Result<void> abortBodyStreamToCgi_(http::HttpStatus status);
+    bool isStreamingBodyToCgi_() const;
 
     // http_session_helpers.cpp
     void installBodySourceAndWriter_(utils::OwnedPtr<BodySource> body_source);
     void cleanupCgiOnClose_();
+    Result<void> flushPendingSendBuffer_();
+    // 待機中の状態（ExecuteCgiState / WaitBlockingTaskState /
+    // WaitCgiSlotState）に共通する socket イベント処理と watch 指定
+    Result<void> handleSocketEventWhileWaiting_(const FdEvent& event);
+    void getWaitingWatchFlags_(bool* want_read, bool* want_write) const;
     Result<void> buildErrorOutput_(
         http::HttpStatus status, RequestProcessor::Output* out);
     Result<void> buildProcessorOutputOrServerError_(
-        RequestProcessor::Output* out);
+        RequestProcessor::Output* out, bool may_defer);
+    // 所有権を引き取り、ワーカーで実行して完了を待つ
+    Result<void> startBlockingTask_(BlockingTask* task);
 };
 
 }  // namespace server
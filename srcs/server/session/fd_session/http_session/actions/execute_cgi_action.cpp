@@ -1,7 +1,11 @@
 #include "server/session/fd_session/http_session/actions/execute_cgi_action.hpp"
 
+#include <sstream>
+
+#include "server/session/fd_session/cgi_session.hpp"
 #include "server/session/fd_session/http_session.hpp"
 #include "server/session/fd_session/http_session/actions/send_error_action.hpp"
+#include "server/session/fd_session/http_session/states/http_session_states.hpp"
 
 namespace server
 {
@@ -9,12 +13,73 @@ using namespace utils::result;
 
 Result<void> ExecuteCgiAction::execute(HttpSession& session)
 {
+    SessionContext& ctx = session.context_;
+    const void* key = NULL;
+    unsigned long limit = 0;
+    if (ctx.request_handler.hasLocationRouting())
+    {
+        const LocationRouting& routing =
+            ctx.request_handler.getLocationRouting();
+        key = routing.cgiConcurrencyKey();
+        limit = routing.cgiMaxConcurrency();
+    }
+
+    const CgiLimiter::Admission admission =
+        session.module().cgi_limiter.admit(&session, key, limit);
+    if (admission == CgiLimiter::kQueued)
+    {
+        session.changeState(new WaitCgiSlotState());
+        return session.updateSocketWatches_();
+    }
+    if (admission == CgiLimiter::kRejected)
+    {
+        SendErrorAction reject(http::HttpStatus::SERVICE_UNAVAILABLE);
+        Result<void> r = reject.execute(session);
+        std::ostringstream retry_after;
+        retry_after << CgiLimiter::kRetryAfterSec;
+        (void)ctx.response.setHeader("Retry-After", retry_after.str());
+        return r;
+    }
+    return startWithSlot(session, key);
+}
+
+Result<bool> ExecuteCgiAction::startWithBodyStream(HttpSession& session)
+{
+    HttpRequestHandler& handler = session.context_.request_handler;
+    const LocationRouting& routing = handler.getLocationRouting();
+    const void* key = routing.cgiConcurrencyKey();
+
+    // 待ち行列に並ぶ間はボディを流せないので、枠が空いていなければ溜める
+    if (!session.module().cgi_handler.canStreamRequestBody(session) ||
+        !session.module().cgi_limiter.tryAcquire(
+            key, routing.cgiMaxConcurrency()))
+    {
+        handler.declineBodyStream();
+        return false;
+    }
+    handler.beginBodyStream();
+    Result<void> r = startWithSlot(session, key);
+    if (r.isError())
+        return Result<bool>(ERROR, r.getErrorMessage());
+    return true;
+}
+
+Result<void> ExecuteCgiAction::startWithSlot(
+    HttpSession& session, const void* key)
+{
+    CgiLimiter& limiter = session.module().cgi_limiter;
     Result<void> sr = session.module().cgi_handler.startCgi(session);
     if (sr.isError())
     {
+        limiter.release(key);
         SendErrorAction fallback(http::HttpStatus::SERVER_ERROR);
         return fallback.execute(session);
     }
+    // 以後は CgiSession の破棄で枠を返す
+    if (session.context_.active_cgi_session != NULL)
+        session.context_.active_cgi_session->holdCgiSlot(limiter, key);
+    else
+        limiter.release(key);
     return Result<void>();
 }
 }  // namespace server
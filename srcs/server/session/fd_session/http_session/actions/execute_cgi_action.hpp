@@ -7,7 +7,18 @@ namespace server {
 
 class ExecuteCgiAction : public IRequestAction {
 public:
+    // cgi_max_concurrency の枠を取れたら起動し、取れなければ待つか 503
     virtual utils::result::Result<void> execute(HttpSession& session);
+
+    // 枠（key）を確保済みのセッションで CGI を起動する
+    static utils::result::Result<void> startWithSlot(
+        HttpSession& session, const void* key);
+
+    // ヘッダー受信時点で CGI を起動し、ボディは受信しながら流す
+    // （cgi_request_buffering off）。すぐに起動できなければ false を返し、
+    // ボディは従来どおり溜めてから execute() する。
+    static utils::result::Result<bool> startWithBodyStream(
+        HttpSession& session);
 };
 
 }
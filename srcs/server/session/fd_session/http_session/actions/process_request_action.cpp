@@ -7,13 +7,25 @@ namespace server
 {
 using namespace utils::result;
 
+ProcessRequestAction::ProcessRequestAction() : may_defer_(true) {}
+
+ProcessRequestAction::ProcessRequestAction(bool may_defer)
+    : may_defer_(may_defer)
+{
+}
+
 Result<void> ProcessRequestAction::execute(HttpSession& session)
 {
     RequestProcessor::Output out;
-    Result<void> po = session.buildProcessorOutputOrServerError_(&out);
+    Result<void> po =
+        session.buildProcessorOutputOrServerError_(&out, may_defer_);
     if (po.isError())
         return po;
 
+    // 応答を作る前にブロッキング処理が必要。完了後にやり直す。
+    if (out.blocking_task.get() != NULL)
+        return session.startBlockingTask_(out.blocking_task.release());
+
     session.installBodySourceAndWriter_(out.body_source);
 
     session.context_.should_close_connection =
@@ -7,7 +7,12 @@ namespace server {
 
 class ProcessRequestAction : public IRequestAction {
 public:
+    // may_defer: ディレクトリ走査などをワーカーに回してよいか
+    ProcessRequestAction();
+    explicit ProcessRequestAction(bool may_defer);
     virtual utils::result::Result<void> execute(HttpSession& session);
+private:
+    bool may_defer_;
 };
 
 }
@@ -0,0 +1,20 @@
+#include "server/session/fd_session/http_session/actions/run_blocking_task_action.hpp"
+
+#include "server/blocking_task/blocking_task.hpp"
+#include "server/session/fd_session/http_session.hpp"
+
+namespace server
+{
+using namespace utils::result;
+
+RunBlockingTaskAction::RunBlockingTaskAction(BlockingTask* task) : task_(task)
+{
+}
+
+RunBlockingTaskAction::~RunBlockingTaskAction() {}
+
+Result<void> RunBlockingTaskAction::execute(HttpSession& session)
+{
+    return session.startBlockingTask_(task_.release());
+}
+}  // namespace server
@@ -0,0 +1,22 @@
+#ifndef WEBSERV_RUN_BLOCKING_TASK_ACTION_HPP_
+#define WEBSERV_RUN_BLOCKING_TASK_ACTION_HPP_
+
+#include "server/session/fd_session/http_session/actions/i_request_action.hpp"
+#include "utils/owned_ptr.hpp"
+
+namespace server {
+
+class BlockingTask;
+
+// タスクをワーカーで実行し、完了を待ってから処理を再開する
+class RunBlockingTaskAction : public IRequestAction {
+public:
+    explicit RunBlockingTaskAction(BlockingTask* task);
+    virtual ~RunBlockingTaskAction();
+    virtual utils::result::Result<void> execute(HttpSession& session);
+private:
+    utils::OwnedPtr<BlockingTask> task_;
+};
+
+}
+#endif
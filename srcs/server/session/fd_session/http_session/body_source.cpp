@@ -9,8 +9,27 @@ namespace server
 
 BodySource::~BodySource() {}
 
+bool BodySource::readShared(size_t max_bytes, const utils::Byte** out_data,
+    size_t* out_len, bool* out_eof)
+{
+    (void)max_bytes;
+    (void)out_data;
+    (void)out_len;
+    (void)out_eof;
+    return false;
+}
+
 FileBodySource::FileBodySource(int fd, unsigned long remaining_bytes)
-    : fd_(fd), remaining_bytes_(remaining_bytes)
+    : fd_(fd), offset_(0), remaining_bytes_(remaining_bytes), positioned_(true)
+{
+}
+
+FileBodySource::FileBodySource(
+    int fd, unsigned long offset, unsigned long remaining_bytes)
+    : fd_(fd),
+      offset_(offset),
+      remaining_bytes_(remaining_bytes),
+      positioned_(offset == 0)
 {
 }
 
@@ -47,6 +66,13 @@ Result<BodySource::ReadResult> FileBodySource::read(size_t max_bytes)
         return r;
     }
 
+    if (!positioned_)
+    {
+        if (::lseek(fd_, static_cast<off_t>(offset_), SEEK_SET) < 0)
+            return Result<ReadResult>(ERROR, "FileBodySource seek failed");
+        positioned_ = true;
+    }
+
     r.data.resize(cap);
     const ssize_t n = ::read(fd_, &r.data[0], cap);
 
@@ -75,6 +101,155 @@ Result<BodySource::ReadResult> FileBodySource::read(size_t max_bytes)
     return r;
 }
 
+FileRangesBodySource::FileRangesBodySource(int fd)
+    : fd_(fd), contents_(), segments_(), index_(0), segment_pos_(0)
+{
+}
+
+FileRangesBodySource::FileRangesBodySource(const SharedBytes& contents)
+    : fd_(-1), contents_(contents), segments_(), index_(0), segment_pos_(0)
+{
+}
+
+FileRangesBodySource::~FileRangesBodySource()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void FileRangesBodySource::appendText(const std::string& text)
+{
+    if (text.empty())
+        return;
+    Segment seg;
+    seg.text = text;
+    seg.offset = 0;
+    seg.length = static_cast<unsigned long>(text.size());
+    seg.is_file = false;
+    segments_.push_back(seg);
+}
+
+void FileRangesBodySource::appendFileRange(
+    unsigned long offset, unsigned long length)
+{
+    if (length == 0)
+        return;
+    Segment seg;
+    seg.offset = offset;
+    seg.length = length;
+    seg.is_file = true;
+    segments_.push_back(seg);
+}
+
+unsigned long FileRangesBodySource::totalLength() const
+{
+    unsigned long total = 0;
+    for (size_t i = 0; i < segments_.size(); ++i)
+        total += segments_[i].length;
+    return total;
+}
+
+Result<BodySource::ReadResult> FileRangesBodySource::read(size_t max_bytes)
+{
+    ReadResult r;
+
+    while (r.data.size() < max_bytes && index_ < segments_.size())
+    {
+        const Segment& seg = segments_[index_];
+        size_t want = max_bytes - r.data.size();
+        if (want > static_cast<size_t>(seg.length - segment_pos_))
+            want = static_cast<size_t>(seg.length - segment_pos_);
+
+        if (!seg.is_file)
+        {
+            r.data.insert(r.data.end(), seg.text.begin() + segment_pos_,
+                seg.text.begin() + segment_pos_ + want);
+        }
+        else if (contents_.get() != NULL)
+        {
+            const unsigned long begin = seg.offset + segment_pos_;
+            if (begin + want > contents_->size())
+                return Result<ReadResult>(
+                    ERROR, "FileRangesBodySource range out of bounds");
+            r.data.insert(r.data.end(), contents_->begin() + begin,
+                contents_->begin() + begin + want);
+        }
+        else
+        {
+            if (segment_pos_ == 0 &&
+                ::lseek(fd_, static_cast<off_t>(seg.offset), SEEK_SET) < 0)
+                return Result<ReadResult>(
+                    ERROR, "FileRangesBodySource seek failed");
+
+            const size_t before = r.data.size();
+            r.data.resize(before + want);
+            const ssize_t n = ::read(fd_, &r.data[before], want);
+            if (n < 0)
+                return Result<ReadResult>(
+                    ERROR, "FileRangesBodySource read failed");
+            // 応答途中でファイルが縮んだ場合は Content-Length を守れない
+            if (n == 0)
+                return Result<ReadResult>(
+                    ERROR, "FileRangesBodySource unexpected EOF");
+            r.data.resize(before + static_cast<size_t>(n));
+            want = static_cast<size_t>(n);
+        }
+
+        segment_pos_ += static_cast<unsigned long>(want);
+        if (segment_pos_ == seg.length)
+        {
+            ++index_;
+            segment_pos_ = 0;
+        }
+    }
+
+    r.status = (index_ < segments_.size()) ? READ_OK : READ_EOF;
+    return r;
+}
+
+SharedBytesBodySource::SharedBytesBodySource(
+    const SharedBytes& bytes, size_t offset, size_t length)
+    : bytes_(bytes), pos_(offset), end_(offset + length)
+{
+    const size_t size = (bytes_.get() != NULL) ? bytes_->size() : 0;
+    if (end_ > size)
+        end_ = size;
+    if (pos_ > end_)
+        pos_ = end_;
+}
+
+SharedBytesBodySource::~SharedBytesBodySource() {}
+
+Result<BodySource::ReadResult> SharedBytesBodySource::read(size_t max_bytes)
+{
+    ReadResult r;
+    const utils::Byte* data = NULL;
+    size_t len = 0;
+    bool eof = false;
+
+    (void)readShared(max_bytes, &data, &len, &eof);
+    if (len > 0)
+        r.data.assign(data, data + len);
+    r.status = eof ? READ_EOF : READ_OK;
+    return r;
+}
+
+bool SharedBytesBodySource::readShared(size_t max_bytes,
+    const utils::Byte** out_data, size_t* out_len, bool* out_eof)
+{
+    size_t n = end_ - pos_;
+    if (n > max_bytes)
+        n = max_bytes;
+    *out_data = (n > 0) ? &(*bytes_)[pos_] : NULL;
+    *out_len = n;
+    pos_ += n;
+    *out_eof = (pos_ == end_);
+    return true;
+}
+
 CgiBodySource::CgiBodySource(int fd) : fd_(fd) {}
 
 CgiBodySource::~CgiBodySource()
@@ -6,6 +6,7 @@
 
 #include "utils/data_type.hpp"
 #include "utils/result.hpp"
+#include "utils/shared_ptr.hpp"
 
 namespace server
 {
@@ -35,6 +36,12 @@ class BodySource
     // max_bytes まで読み出す。
     // READ_WOULD_BLOCK の場合は data は空。
     virtual Result<ReadResult> read(size_t max_bytes) = 0;
+
+    // 内部のバッファを直接参照できる source 用。max_bytes までの次の断片を
+    // コピーせずに返して読み進める（領域は source が生きている間有効）。
+    // 対応しない source は false を返すので、read() を使う。
+    virtual bool readShared(size_t max_bytes, const utils::Byte** out_data,
+        size_t* out_len, bool* out_eof);
 };
 
 class FileBodySource : public BodySource
@@ -42,13 +49,17 @@ class FileBodySource : public BodySource
    public:
     // remaining_bytes == 0 の場合は「無制限」扱い（EOF まで読む）
     FileBodySource(int fd, unsigned long remaining_bytes);
+    // offset から remaining_bytes だけ読む（Range 応答用）
+    FileBodySource(int fd, unsigned long offset, unsigned long remaining_bytes);
     virtual ~FileBodySource();
 
     virtual Result<ReadResult> read(size_t max_bytes);
 
    private:
     int fd_;
+    unsigned long offset_;
     unsigned long remaining_bytes_;
+    bool positioned_;
 
     FileBodySource();
     FileBodySource(const FileBodySource& rhs);
@@ -92,6 +103,69 @@ class PrefetchedFdBodySource : public BodySource
     PrefetchedFdBodySource& operator=(const PrefetchedFdBodySource& rhs);
 };
 
+typedef utils::SharedPtr<const std::vector<utils::Byte> > SharedBytes;
+
+// multipart/byteranges の body を供給する。
+// 各パートのヘッダ（文字列）とファイルの部分範囲を順に読み出す。
+// ファイル内容がメモリ上にある場合は fd の代わりにそれを切り出す。
+class FileRangesBodySource : public BodySource
+{
+   public:
+    explicit FileRangesBodySource(int fd);
+    explicit FileRangesBodySource(const SharedBytes& contents);
+    virtual ~FileRangesBodySource();
+
+    // 追加した順に読み出される
+    void appendText(const std::string& text);
+    void appendFileRange(unsigned long offset, unsigned long length);
+    // 読み出される合計バイト数（Content-Length 用）
+    unsigned long totalLength() const;
+
+    virtual Result<ReadResult> read(size_t max_bytes);
+
+   private:
+    struct Segment
+    {
+        std::string text;
+        unsigned long offset;
+        unsigned long length;
+        bool is_file;
+    };
+
+    int fd_;
+    SharedBytes contents_;
+    std::vector<Segment> segments_;
+    size_t index_;
+    unsigned long segment_pos_;
+
+    FileRangesBodySource();
+    FileRangesBodySource(const FileRangesBodySource& rhs);
+    FileRangesBodySource& operator=(const FileRangesBodySource& rhs);
+};
+
+// 共有バッファの [offset, offset + length) を body として供給する。
+// キャッシュ済みのファイル内容を、複数のレスポンスでコピーせずに共有する。
+class SharedBytesBodySource : public BodySource
+{
+   public:
+    SharedBytesBodySource(
+        const SharedBytes& bytes, size_t offset, size_t length);
+    virtual ~SharedBytesBodySource();
+
+    virtual Result<ReadResult> read(size_t max_bytes);
+    virtual bool readShared(size_t max_bytes, const utils::Byte** out_data,
+        size_t* out_len, bool* out_eof);
+
+   private:
+    SharedBytes bytes_;
+    size_t pos_;
+    size_t end_;
+
+    SharedBytesBodySource();
+    SharedBytesBodySource(const SharedBytesBodySource& rhs);
+    SharedBytesBodySource& operator=(const SharedBytesBodySource& rhs);
+};
+
 // 文字列（メモリ）から body を供給する。
 // error page など、ファイルを用意せずに返したい小さめのレスポンスで使用。
 class StringBodySource : public BodySource
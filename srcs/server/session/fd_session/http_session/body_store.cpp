@@ -1,6 +1,9 @@
 #include "server/session/fd_session/http_session/body_store.hpp"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <cstdio>
@@ -11,6 +14,8 @@ namespace server
 
 using namespace utils::result;
 
+const char* const BodyStore::kDefaultTempDir = "/tmp";
+
 static std::string parentDir_(const std::string& path)
 {
     const std::string::size_type pos = path.find_last_of('/');
@@ -52,22 +57,19 @@ static Result<void> writeAll(int fd, const utils::Byte* data, size_t len)
     return Result<void>();
 }
 
-std::string BodyStore::buildPath_(const void* unique_key)
-{
-    std::ostringstream oss;
-    oss << "/tmp/webserv_body_" << reinterpret_cast<unsigned long>(unique_key)
-        << ".tmp";
-    return oss.str();
-}
-
-BodyStore::BodyStore(const void* unique_key)
-    : default_path_(buildPath_(unique_key)),
-      path_(default_path_),
-      write_fd_(-1),
+BodyStore::BodyStore()
+    : temp_dir_(kDefaultTempDir),
+      path_(),
+      fd_(-1),
       size_bytes_(0),
+      memory_limit_(kDefaultMemoryLimit),
+      expected_size_(0),
+      preallocated_end_(0),
+      memory_(),
       remove_on_reset_(true),
       allow_overwrite_(true),
-      is_committed_(false)
+      is_committed_(false),
+      has_file_(false)
 {
 }
 
@@ -75,32 +77,41 @@ BodyStore::~BodyStore() { reset(); }
 
 void BodyStore::reset()
 {
-    if (write_fd_ >= 0)
+    // 一時ファイルは名前が無いので、閉じた時点で消える
+    if (fd_ >= 0)
     {
-        ::close(write_fd_);
-        write_fd_ = -1;
+        ::close(fd_);
+        fd_ = -1;
     }
     size_bytes_ = 0;
+    memory_.clear();
+    // 大きめのボディで広がった領域は keep-alive 中に持ち越さない
+    if (memory_.capacity() > memory_limit_)
+        std::vector<utils::Byte>().swap(memory_);
 
-    // upload_store の場合でも、正常完了（commit）していなければ削除する。
-    if (remove_on_reset_ || !is_committed_)
+    // upload_store は、正常完了（commit）していなければ削除する。
+    if (has_file_ && !remove_on_reset_ && !is_committed_)
     {
-        // 使い回し方針でも「残骸を残さない」ために削除を試みる。
         // 失敗しても致命ではないので、呼び出し側が必要なら結果を確認する。
         (void)removeFile();
     }
 
     // 次のリクエストでは必ず一時ファイルに戻す。
-    path_ = default_path_;
+    temp_dir_ = kDefaultTempDir;
+    path_.clear();
+    memory_limit_ = kDefaultMemoryLimit;
+    expected_size_ = 0;
+    preallocated_end_ = 0;
     remove_on_reset_ = true;
     allow_overwrite_ = true;
     is_committed_ = false;
+    has_file_ = false;
 }
 
 Result<void> BodyStore::configureForUpload(
     const std::string& destination_path, bool allow_overwrite)
 {
-    if (write_fd_ >= 0)
+    if (fd_ >= 0)
         return Result<void>(ERROR, "body store is already opened");
     if (destination_path.empty())
         return Result<void>(ERROR, "destination path is empty");
@@ -124,34 +135,58 @@ Result<void> BodyStore::removeFile()
     return Result<void>(ERROR, "remove() failed");
 }
 
-Result<void> BodyStore::begin()
+// 名前の無い一時ファイルを作る。
+// ディレクトリエントリを残さないので、異常終了しても後始末が要らない。
+Result<void> BodyStore::openTempFile_()
 {
-    if (write_fd_ >= 0)
-        return Result<void>();
+    int fd = -1;
+#if defined(__linux__) && defined(O_TMPFILE)
+    fd = ::open(temp_dir_.c_str(), O_RDWR | O_TMPFILE, 0600);
+#endif
+    if (fd < 0)
+    {
+        // O_TMPFILE 非対応（カーネル/ファイルシステム）: 作成直後に unlink
+        std::string tmpl = temp_dir_;
+        if (tmpl.empty() || tmpl[tmpl.size() - 1] != '/')
+            tmpl += '/';
+        tmpl += "webserv_body_XXXXXX";
+        std::vector<char> name(tmpl.begin(), tmpl.end());
+        name.push_back('\0');
+        fd = ::mkstemp(&name[0]);
+        if (fd < 0)
+        {
+            if (!canCreateFileInDir_(temp_dir_))
+                return Result<void>(ERROR, "forbidden");
+            return Result<void>(ERROR, "open() failed");
+        }
+        (void)::unlink(&name[0]);
+    }
+    fd_ = fd;
+    return Result<void>();
+}
 
+Result<void> BodyStore::openDestinationFile_()
+{
     // 事前に access() で書き込み可否を判定する
-    if (!path_.empty())
+    if (::access(path_.c_str(), F_OK) == 0)
     {
-        if (::access(path_.c_str(), F_OK) == 0)
+        if (allow_overwrite_)
         {
-            if (allow_overwrite_)
-            {
-                if (!canWriteExistingFile_(path_))
-                    return Result<void>(ERROR, "forbidden");
-            }
-            else
-            {
-                // allow_overwrite=false かつ既存ファイルありは open(O_EXCL)
-                // で失敗想定。 ここでは権限ではないので forbidden にしない。
-            }
+            if (!canWriteExistingFile_(path_))
+                return Result<void>(ERROR, "forbidden");
         }
         else
         {
-            const std::string dir = parentDir_(path_);
-            if (!canCreateFileInDir_(dir))
-                return Result<void>(ERROR, "forbidden");
+            // allow_overwrite=false かつ既存ファイルありは open(O_EXCL)
+            // で失敗想定。 ここでは権限ではないので forbidden にしない。
         }
     }
+    else
+    {
+        const std::string dir = parentDir_(path_);
+        if (!canCreateFileInDir_(dir))
+            return Result<void>(ERROR, "forbidden");
+    }
 
     int flags = O_WRONLY | O_CREAT;
     if (allow_overwrite_)
@@ -162,42 +197,239 @@ Result<void> BodyStore::begin()
     const int fd = ::open(path_.c_str(), flags, 0644);
     if (fd < 0)
         return Result<void>(ERROR, "open() failed");
+    fd_ = fd;
+    return Result<void>();
+}
+
+// Content-Length が分かっていれば先に領域を確保して断片化を避ける。
+// Content-Length はクライアントの申告なので、一度に確保するのは書いた位置から
+// kPreallocateAheadBytes 先までとし、書き進めるにつれて延ばす。
+// KEEP_SIZE なのでボディが途中で切れてもファイルサイズは書いた分のまま。
+void BodyStore::preallocate_()
+{
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    if (expected_size_ <= preallocated_end_)
+        return;
+    // 確保済みの残りが半分を切るまでは延ばさない
+    if (size_bytes_ + kPreallocateAheadBytes / 2 < preallocated_end_)
+        return;
+    unsigned long end = size_bytes_ + kPreallocateAheadBytes;
+    if (end > expected_size_)
+        end = expected_size_;
+    if (end <= preallocated_end_)
+        return;
+    if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE,
+            static_cast<off_t>(preallocated_end_),
+            static_cast<off_t>(end - preallocated_end_)) == 0)
+        preallocated_end_ = end;
+#endif
+}
+
+Result<void> BodyStore::begin()
+{
+    if (fd_ >= 0)
+        return Result<void>();
+
+    Result<void> r =
+        remove_on_reset_ ? openTempFile_() : openDestinationFile_();
+    if (r.isError())
+        return r;
 
-    write_fd_ = fd;
     size_bytes_ = 0;
+    preallocated_end_ = 0;
+    has_file_ = true;
+    preallocate_();
     return Result<void>();
 }
 
-Result<void> BodyStore::append(const utils::Byte* data, size_t len)
+// メモリ上のボディをファイルへ移す
+Result<void> BodyStore::spill_()
 {
+    if (fd_ >= 0)
+        return Result<void>();
+
     Result<void> r = begin();
+    if (r.isError())
+        return r;
+    if (memory_.empty())
+        return Result<void>();
+
+    r = writeAll(fd_, &memory_[0], memory_.size());
+    if (r.isError())
+        return r;
+    size_bytes_ = memory_.size();
+    memory_.clear();
+    return Result<void>();
+}
+
+Result<void> BodyStore::append(const utils::Byte* data, size_t len)
+{
+    // upload_store の保存先（remove_on_reset_ == false）は最初からファイルへ
+    if (!has_file_ && remove_on_reset_ && size_bytes_ + len <= memory_limit_)
+    {
+        if (len == 0)
+            return Result<void>();
+        if (data == NULL)
+            return Result<void>(ERROR, "null body data");
+        memory_.insert(memory_.end(), data, data + len);
+        size_bytes_ += len;
+        return Result<void>();
+    }
+
+    Result<void> r = spill_();
     if (r.isError())
         return r;
 
-    r = writeAll(write_fd_, data, len);
+    r = writeAll(fd_, data, len);
     if (r.isError())
         return r;
 
     size_bytes_ += len;
+    preallocate_();
     return Result<void>();
 }
 
 Result<void> BodyStore::finish()
 {
-    if (write_fd_ < 0)
+    // 一時ファイルは名前が無いので、読み終わるまで fd を手放さない
+    if (fd_ < 0 || remove_on_reset_)
         return Result<void>();
 
-    ::close(write_fd_);
-    write_fd_ = -1;
+    ::close(fd_);
+    fd_ = -1;
     return Result<void>();
 }
 
-Result<int> BodyStore::openForRead() const
+Result<int> BodyStore::openForRead()
 {
-    const int fd = ::open(path_.c_str(), O_RDONLY);
+    if (!has_file_)
+    {
+        Result<void> s = spill_();
+        if (s.isError())
+            return Result<int>(ERROR, -1, s.getErrorMessage());
+        (void)finish();
+    }
+
+    if (!remove_on_reset_)
+    {
+        const int fd = ::open(path_.c_str(), O_RDONLY);
+        if (fd < 0)
+            return Result<int>(ERROR, "open() failed");
+        return fd;
+    }
+
+    // 一時ファイル: 複製した fd を先頭に戻して渡す（オフセットは共有される
+    // ので、読み手は同時に1つまで）。
+    const int fd = ::dup(fd_);
     if (fd < 0)
-        return Result<int>(ERROR, "open() failed");
+        return Result<int>(ERROR, "dup() failed");
+    if (::lseek(fd, 0, SEEK_SET) < 0)
+    {
+        ::close(fd);
+        return Result<int>(ERROR, "lseek() failed");
+    }
     return fd;
 }
 
+// 名前の無い一時ファイル（O_TMPFILE）に /proc 経由で名前を付ける。
+// mkstemp にフォールバックしたファイルや別ファイルシステムでは失敗する。
+bool BodyStore::linkTempFile_(const std::string& dest_path)
+{
+#if defined(__linux__) && defined(O_TMPFILE)
+    std::ostringstream proc_path;
+    proc_path << "/proc/self/fd/" << fd_;
+    // O_TMPFILE は 0600 で作っているので、通常のアップロードと揃える
+    (void)::fchmod(fd_, 0644);
+    return ::linkat(AT_FDCWD, proc_path.str().c_str(), AT_FDCWD,
+               dest_path.c_str(), AT_SYMLINK_FOLLOW) == 0;
+#else
+    (void)dest_path;
+    return false;
+#endif
+}
+
+// in_fd の先頭から size 分を out_fd へコピーする（in_fd の位置は動かさない）
+Result<void> BodyStore::copyFd_(int in_fd, size_t size, int out_fd)
+{
+    off_t in_off = 0;
+    const off_t total = static_cast<off_t>(size);
+#if defined(__linux__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+    // カーネル内でコピーする（対応 FS では reflink になる）
+    while (in_off < total)
+    {
+        const ssize_t n = ::copy_file_range(in_fd, &in_off, out_fd, NULL,
+            static_cast<size_t>(total - in_off), 0);
+        if (n > 0)
+            continue;
+        if (n == 0)
+            return Result<void>(ERROR, "internal fd read failed");
+        if (errno != EXDEV && errno != ENOSYS && errno != EINVAL &&
+            errno != EOPNOTSUPP)
+            return Result<void>(ERROR, "internal fd write failed");
+        break;  // 非対応: 続きを read/write で
+    }
+#endif
+    char buf[64 * 1024];
+    while (in_off < total)
+    {
+        const ssize_t n = ::pread(in_fd, buf, sizeof(buf), in_off);
+        if (n <= 0)
+            return Result<void>(ERROR, "internal fd read failed");
+        Result<void> w =
+            writeAll(out_fd, reinterpret_cast<const utils::Byte*>(buf),
+                static_cast<size_t>(n));
+        if (w.isError())
+            return w;
+        in_off += n;
+    }
+    return Result<void>();
+}
+
+Result<bool> BodyStore::saveWithoutCopy(const std::string& dest_path)
+{
+    if (!remove_on_reset_)
+        return Result<bool>(ERROR, "body store is not a temp file");
+
+    if (has_file_)
+    {
+        errno = 0;
+        if (linkTempFile_(dest_path))
+            return true;
+        if (errno == EEXIST)
+            return Result<bool>(ERROR, "open() failed");
+        return false;
+    }
+
+    // メモリ上のボディは memory_limit 以下なので、その場で書いてよい
+    const int out_fd =
+        ::open(dest_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (out_fd < 0)
+        return Result<bool>(ERROR, "open() failed");
+    Result<void> r = writeAll(
+        out_fd, memory_.empty() ? NULL : &memory_[0], memory_.size());
+    ::close(out_fd);
+    if (r.isError())
+    {
+        (void)std::remove(dest_path.c_str());
+        return Result<bool>(ERROR, r.getErrorMessage());
+    }
+    return true;
+}
+
+Result<void> BodyStore::copyToNewFile(
+    int in_fd, size_t size, const std::string& dest_path)
+{
+    const int out_fd =
+        ::open(dest_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (out_fd < 0)
+        return Result<void>(ERROR, "open() failed");
+
+    Result<void> r = copyFd_(in_fd, size, out_fd);
+    ::close(out_fd);
+    if (r.isError())
+        (void)std::remove(dest_path.c_str());
+    return r;
+}
+
 }  // namespace server
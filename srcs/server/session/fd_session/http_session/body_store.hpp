@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <string>
+#include <vector>
 
 #include "utils/data_type.hpp"
 #include "utils/result.hpp"
@@ -10,12 +11,29 @@
 namespace server
 {
 using utils::result::Result;
+// リクエストボディの保存先。
+// - memory_limit 以下のボディはメモリに保持し、一時ファイルを作らない。
+// - 超えた時点（または fd が必要になった時点）でファイルへ書き出す。
+// - 一時ファイルは temp_dir 配下の名前の無いファイル（O_TMPFILE、
+//   非対応なら作成直後に unlink）で、fd を閉じれば必ず消える。
+// - upload_store の保存先を指定された場合は最初からそのファイルに書く。
 class BodyStore
 {
    public:
-    explicit BodyStore(const void* unique_key);
+    static const size_t kDefaultMemoryLimit = 16 * 1024;
+    // 書いた位置からこのバイト数先までしか領域を先に確保しない
+    static const unsigned long kPreallocateAheadBytes = 4 * 1024 * 1024;
+    static const char* const kDefaultTempDir;
+
+    BodyStore();
     ~BodyStore();
 
+    // いずれも reset() まで有効。ファイル作成後の変更は次のリクエストから効く。
+    void setMemoryLimit(size_t bytes) { memory_limit_ = bytes; }
+    void setTempDir(const std::string& dir) { temp_dir_ = dir; }
+    // 分かっていればボディの総バイト数（書き進めながら少し先まで領域を確保する）
+    void setExpectedSize(unsigned long bytes) { expected_size_ = bytes; }
+
     // upload_store 向けに出力先を差し替える。
     // - reset() では削除しない（アップロード結果を保持する）
     // - allow_overwrite=false の場合、既存ファイルがあると open に失敗する
@@ -26,9 +44,28 @@ class BodyStore
     Result<void> append(const utils::Byte* data, size_t len);
     Result<void> finish();
 
-    Result<int> openForRead() const;
+    // メモリ上にある場合は先にファイルへ書き出してから開く。
+    // 返す fd は呼び出し側が close する（先頭から読める）。
+    Result<int> openForRead();
+
+    // 一時ファイルのボディを dest_path として保存する（既存なら失敗）。
+    // temp_dir が同じファイルシステムなら linkat() で名前を付けるだけで、
+    // ボディのコピーは発生しない。メモリ上のボディはそのまま書き出す。
+    // コピーが必要な場合は何もせず false を返すので、openForRead() の fd を
+    // copyToNewFile() に渡す（ブロッキングなのでワーカーで行う想定）。
+    Result<bool> saveWithoutCopy(const std::string& dest_path);
 
-    // unlink/remove の代替として std::remove を許容する前提。
+    // in_fd の先頭から size バイトを新規ファイル dest_path へコピーする。
+    // 失敗時は作りかけのファイルを削除する。他のメンバーに触れないので
+    // 別スレッドから呼んでよい。
+    static Result<void> copyToNewFile(
+        int in_fd, size_t size, const std::string& dest_path);
+
+    // ボディがまだメモリ上にあるか（ファイルを作っていないか）
+    bool isInMemory() const { return !has_file_; }
+    const std::vector<utils::Byte>& memoryData() const { return memory_; }
+
+    // upload_store の保存先を削除する（一時ファイルは閉じるだけで消える）。
     // 失敗した場合は ERROR を返す（未作成/既に削除済みは OK 扱い）。
     Result<void> removeFile();
 
@@ -39,20 +76,29 @@ class BodyStore
     void commit() { is_committed_ = true; }
 
    private:
-    std::string default_path_;
-    std::string path_;
-    int write_fd_;
+    std::string temp_dir_;
+    std::string path_;  // upload_store の保存先（一時ファイルなら空）
+    int fd_;
     size_t size_bytes_;
+    size_t memory_limit_;
+    unsigned long expected_size_;
+    unsigned long preallocated_end_;  // fallocate 済みの終端
+    std::vector<utils::Byte> memory_;
 
-    bool remove_on_reset_;
+    bool remove_on_reset_;  // true: 一時ファイル / false: upload_store
     bool allow_overwrite_;
     bool is_committed_;
+    bool has_file_;  // 今回のリクエストでファイルを作成した
 
-    BodyStore();
     BodyStore(const BodyStore& rhs);
     BodyStore& operator=(const BodyStore& rhs);
 
-    static std::string buildPath_(const void* unique_key);
+    Result<void> openTempFile_();
+    Result<void> openDestinationFile_();
+    void preallocate_();
+    Result<void> spill_();
+    bool linkTempFile_(const std::string& dest_path);
+    static Result<void> copyFd_(int in_fd, size_t size, int out_fd);
 };
 
 }  // namespace server
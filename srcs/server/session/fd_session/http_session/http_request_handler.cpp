@@ -1,5 +1,8 @@
 #include "server/session/fd_session/http_session/http_request_handler.hpp"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <limits>
 
 namespace server
@@ -7,18 +10,23 @@ namespace server
 using namespace utils::result;
 using namespace http;
 
+const size_t HttpRequestHandler::kBodyStreamHighWaterBytes;
+
 HttpRequestHandler::HttpRequestHandler(HttpRequest& request,
     const RequestRouter& router, const IPAddress& server_ip,
-    const PortType& server_port, const void* body_store_key)
+    const PortType& server_port)
     : request_(request),
       router_(router),
       server_ip_(server_ip),
       server_port_(server_port),
-      body_store_(body_store_key),
-      body_sink_(request, body_store_),
+      body_store_(),
+      multipart_writer_(),
+      body_sink_(request, body_store_, multipart_writer_),
       has_routing_(false),
       location_routing_(),
       has_configured_body_store_for_upload_(false),
+      body_stream_state_(kBodyStreamUndecided),
+      body_stream_(),
       next_step_(NEED_MORE_DATA),
       should_close_connection_(false)
 {
@@ -34,6 +42,34 @@ void HttpRequestHandler::reset()
     next_step_ = NEED_MORE_DATA;
     should_close_connection_ = false;
     body_store_.reset();
+    multipart_writer_.reset();
+    body_stream_state_ = kBodyStreamUndecided;
+    body_stream_.consume(body_stream_.size());
+    body_sink_.setStream(NULL);
+}
+
+bool HttpRequestHandler::isBodyStreamPending() const
+{
+    if (body_stream_state_ != kBodyStreamUndecided || !has_routing_)
+        return false;
+    if (!request_.isHeaderComplete() || request_.isParseComplete())
+        return false;
+    if (request_.getMethod() != HttpMethod::POST || !request_.hasBody() ||
+        request_.isPayloadTooLarge())
+        return false;
+    return location_routing_.getNextAction() == RUN_CGI &&
+           !location_routing_.cgiRequestBuffering();
+}
+
+void HttpRequestHandler::beginBodyStream()
+{
+    body_stream_state_ = kBodyStreamOn;
+    body_sink_.setStream(&body_stream_);
+}
+
+void HttpRequestHandler::declineBodyStream()
+{
+    body_stream_state_ = kBodyStreamOff;
 }
 
 Result<void> HttpRequestHandler::consumeFromRecvBuffer(IoBuffer& recv_buffer)
@@ -43,20 +79,28 @@ Result<void> HttpRequestHandler::consumeFromRecvBuffer(IoBuffer& recv_buffer)
         if (request_.isParseComplete())
             break;
 
+        // recv_buffer の先頭の連続領域だけを渡す。そこで1行も進めず、
+        // ラップした後ろ側に続きがある場合だけ並べ直して渡し直す。
+        size_t segment_len = 0;
+        const utils::Byte* data = reinterpret_cast<const utils::Byte*>(
+            recv_buffer.frontSegment(&segment_len));
+
         if (!request_.isHeaderComplete())
         {
-            const utils::Byte* data =
-                reinterpret_cast<const utils::Byte*>(recv_buffer.data());
-            const size_t len = recv_buffer.size();
-
             // ルーティングに応じた Limits を適用したいので、
             // ヘッダー確定時点で一旦止める。
-            Result<size_t> parsed = request_.parse(data, len, NULL, true);
+            Result<size_t> parsed =
+                request_.parse(data, segment_len, NULL, true);
             if (parsed.isError())
                 return Result<void>(ERROR, parsed.getErrorMessage());
 
             if (parsed.unwrap() == 0)
-                break;
+            {
+                if (segment_len == recv_buffer.size())
+                    break;
+                recv_buffer.linearize();
+                continue;
+            }
             recv_buffer.consume(parsed.unwrap());
 
             if (request_.isHeaderComplete())
@@ -72,15 +116,29 @@ Result<void> HttpRequestHandler::consumeFromRecvBuffer(IoBuffer& recv_buffer)
         if (limit_result.isError())
             return limit_result;
 
-        const utils::Byte* data =
-            reinterpret_cast<const utils::Byte*>(recv_buffer.data());
-        const size_t len = recv_buffer.size();
+        // CGI を先に起動するかは呼び出し側が決める
+        if (isBodyStreamPending())
+            break;
+
+        size_t len = segment_len;
+        if (isStreamingBody())
+        {
+            // CGI が読むまでは recv_buffer に残し、ソケットの read を止める
+            if (body_stream_.size() >= kBodyStreamHighWaterBytes)
+                break;
+            len = std::min(len, kBodyStreamHighWaterBytes - body_stream_.size());
+        }
         Result<size_t> parsed = request_.parse(data, len, &body_sink_, false);
         if (parsed.isError())
             return Result<void>(ERROR, parsed.getErrorMessage());
 
         if (parsed.unwrap() == 0)
-            break;
+        {
+            if (segment_len == recv_buffer.size())
+                break;
+            recv_buffer.linearize();
+            continue;
+        }
         recv_buffer.consume(parsed.unwrap());
     }
 
@@ -104,8 +162,9 @@ Result<void> HttpRequestHandler::onRequestReady()
 }
 
 HttpRequestHandler::ConditionalBodySink::ConditionalBodySink(
-    const HttpRequest& request, BodyStore& store)
-    : request_(request), store_(store)
+    const HttpRequest& request, BodyStore& store,
+    MultipartUploadWriter& multipart)
+    : request_(request), store_(store), multipart_(multipart), stream_(NULL)
 {
 }
 
@@ -114,9 +173,28 @@ Result<void> HttpRequestHandler::ConditionalBodySink::write(
 {
     if (request_.getMethod() != HttpMethod::POST)
         return Result<void>();
+    if (stream_ != NULL)
+    {
+        stream_->append(reinterpret_cast<const char*>(data), len);
+        return Result<void>();
+    }
+    if (multipart_.isActive())
+        return multipart_.write(data, len);
     return store_.append(data, len);
 }
 
+// ヘッダー確定後、ボディを受け取る前に一度だけ呼ぶ
+void HttpRequestHandler::configureBodyStore_()
+{
+    body_store_.setMemoryLimit(
+        static_cast<size_t>(location_routing_.clientBodyBufferSize()));
+    const std::string temp_dir = location_routing_.clientBodyTempPath();
+    if (!temp_dir.empty())
+        body_store_.setTempDir(temp_dir);
+    if (!request_.isPayloadTooLarge())
+        body_store_.setExpectedSize(request_.getContentLength());
+}
+
 Result<void> HttpRequestHandler::decideRouting_()
 {
     Result<LocationRouting> route_result =
@@ -136,6 +214,7 @@ Result<void> HttpRequestHandler::ensureRoutingAndApplyBodyLimit_()
         Result<void> routing_result = decideRouting_();
         if (routing_result.isError())
             return routing_result;
+        configureBodyStore_();
     }
 
     // upload_store の場合は、body の保存先を upload_store 配下の
@@ -143,12 +222,15 @@ Result<void> HttpRequestHandler::ensureRoutingAndApplyBodyLimit_()
     if (!has_configured_body_store_for_upload_ &&
         location_routing_.getNextAction() == STORE_BODY)
     {
-        // multipart/form-data はボディ全体をそのまま保存すると envelope まで
-        // 含まれてしまうため、一旦は一時ファイルに保存しておき、リクエスト
-        // 完了後に file part だけを抽出して destination に保存する。
+        // multipart/form-data は受信しながら part を切り出し、file part を
+        // destination へ直接書き出す（BodyStore には溜めない）。
         if (request_.getContentType() == ContentType::MULTIPART_FORM_DATA)
         {
             has_configured_body_store_for_upload_ = true;
+            Result<UploadContext> mp = location_routing_.getUploadContext();
+            if (mp.isOk() && !request_.isPayloadTooLarge())
+                multipart_writer_.begin(
+                    request_.getContentTypeParam("boundary"), mp.unwrap());
         }
 
         Result<UploadContext> up = location_routing_.getUploadContext();
@@ -172,6 +254,12 @@ Result<void> HttpRequestHandler::ensureRoutingAndApplyBodyLimit_()
             }
             else
             {
+                // 保存先と同じファイルシステムに一時ファイルを作っておけば、
+                // finalize は linkat() で名前を付けるだけで済む。
+                const std::string& dest_dir = ctx.destination_dir.str();
+                if (!dest_dir.empty() &&
+                    ::access(dest_dir.c_str(), W_OK | X_OK) == 0)
+                    body_store_.setTempDir(dest_dir);
                 has_configured_body_store_for_upload_ = true;
             }
         }
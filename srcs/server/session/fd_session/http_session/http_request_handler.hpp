@@ -7,6 +7,7 @@
 #include "server/http_processing_module/request_router/location_routing.hpp"
 #include "server/http_processing_module/request_router/request_router.hpp"
 #include "server/session/fd_session/http_session/body_store.hpp"
+#include "server/session/fd_session/http_session/multipart_upload_writer.hpp"
 #include "server/session/io_buffer.hpp"
 #include "utils/result.hpp"
 
@@ -26,9 +27,19 @@ class HttpRequestHandler
         CLOSE_CONNECTION
     };
 
+    // cgi_request_buffering off の CGI へボディを流すか
+    enum BodyStreamState
+    {
+        kBodyStreamUndecided,
+        kBodyStreamOff,
+        kBodyStreamOn
+    };
+
+    // bodyStream() に溜めてよい量。超えた分は recv_buffer に残す
+    static const size_t kBodyStreamHighWaterBytes = 64 * 1024;
+
     HttpRequestHandler(HttpRequest& request, const RequestRouter& router,
-        const IPAddress& server_ip, const PortType& server_port,
-        const void* body_store_key);
+        const IPAddress& server_ip, const PortType& server_port);
 
     ~HttpRequestHandler();
 
@@ -39,6 +50,23 @@ class HttpRequestHandler
     BodyStore& bodyStore() { return body_store_; }
     const BodyStore& bodyStore() const { return body_store_; }
 
+    MultipartUploadWriter& multipartWriter() { return multipart_writer_; }
+
+    // ヘッダーが確定し、ボディを読む前に CGI を起動するか決める必要がある。
+    // 決めるまで consumeFromRecvBuffer() はボディを読まない。
+    bool isBodyStreamPending() const;
+    // 以後のボディは BodyStore ではなく bodyStream() に積む
+    void beginBodyStream();
+    // 従来どおり BodyStore に溜める
+    void declineBodyStream();
+    bool isStreamingBody() const
+    {
+        return body_stream_state_ == kBodyStreamOn;
+    }
+    // デコード済みで、まだ CGI の stdin へ書いていないボディ
+    IoBuffer& bodyStream() { return body_stream_; }
+    const IoBuffer& bodyStream() const { return body_stream_; }
+
     Result<void> onRequestReady();
 
     bool hasLocationRouting() const { return has_routing_; }
@@ -59,13 +87,19 @@ class HttpRequestHandler
     class ConditionalBodySink : public HttpRequest::BodySink
     {
        public:
-        ConditionalBodySink(const HttpRequest& request, BodyStore& store);
+        ConditionalBodySink(const HttpRequest& request, BodyStore& store,
+            MultipartUploadWriter& multipart);
 
         virtual Result<void> write(const utils::Byte* data, size_t len);
 
+        // NULL 以外なら BodyStore の代わりにここへ積む
+        void setStream(IoBuffer* stream) { stream_ = stream; }
+
        private:
         const HttpRequest& request_;
         BodyStore& store_;
+        MultipartUploadWriter& multipart_;
+        IoBuffer* stream_;
 
         ConditionalBodySink();
         ConditionalBodySink(const ConditionalBodySink& rhs);
@@ -73,6 +107,7 @@ class HttpRequestHandler
     };
 
     BodyStore body_store_;
+    MultipartUploadWriter multipart_writer_;
     ConditionalBodySink body_sink_;
 
     bool has_routing_;
@@ -80,6 +115,9 @@ class HttpRequestHandler
 
     bool has_configured_body_store_for_upload_;
 
+    BodyStreamState body_stream_state_;
+    IoBuffer body_stream_;
+
     NextStep next_step_;
     bool should_close_connection_;
 
@@ -88,6 +126,7 @@ class HttpRequestHandler
     HttpRequestHandler& operator=(const HttpRequestHandler& rhs);
 
     Result<void> decideRouting_();
+    void configureBodyStore_();
     Result<void> ensureRoutingAndApplyBodyLimit_();
 };
 
@@ -1,5 +1,7 @@
 #include "server/session/fd_session/http_session/http_response_writer.hpp"
 
+#include <cctype>
+
 namespace server
 {
 
@@ -10,20 +12,142 @@ HttpResponseWriter::HttpResponseWriter(http::HttpResponse& response,
     : response_(response),
       encoder_(options),
       body_(body),
+      compression_(),
+      gzip_(NULL),
       header_written_(false),
+      body_started_(false),
+      eof_written_(false)
+{
+}
+
+HttpResponseWriter::HttpResponseWriter(http::HttpResponse& response,
+    const http::HttpResponseEncoder::Options& options, BodySource* body,
+    const CompressionOptions& compression)
+    : response_(response),
+      encoder_(options),
+      body_(body),
+      compression_(compression),
+      gzip_(NULL),
+      header_written_(false),
+      body_started_(false),
       eof_written_(false)
 {
 }
 
 HttpResponseWriter::~HttpResponseWriter() {}
 
+// ヘッダ送出直前に、このレスポンスを gzip で送るかを決める。
+// CGI のように Content-Type がヘッダ完成まで分からないものもあるため、
+// writer 作成時ではなくここで判定する。
+void HttpResponseWriter::setupCompression_()
+{
+    if (!compression_.enabled)
+        return;
+    // 304 は本体を持たないが、検証子と Vary は 200 と揃える必要がある
+    const int code = response_.getStatus().toInt();
+    const bool not_modified = (code == 304);
+    if (body_ == NULL && !not_modified)
+        return;
+    if (response_.hasHeader("Content-Encoding"))
+        return;
+    if (code < 200 || code == 204 || code == 206)
+        return;
+
+    Result<const std::vector<std::string>&> ct =
+        response_.getHeader("Content-Type");
+    if (ct.isError() || ct.unwrap().empty())
+        return;
+    std::string mime = ct.unwrap()[0].substr(0, ct.unwrap()[0].find(';'));
+    while (!mime.empty() && (mime[mime.size() - 1] == ' ' ||
+                                mime[mime.size() - 1] == '\t'))
+        mime.erase(mime.size() - 1);
+    for (size_t i = 0; i < mime.size(); ++i)
+        mime[i] =
+            static_cast<char>(std::tolower(static_cast<unsigned char>(mime[i])));
+    if (mime != "text/html" &&
+        compression_.types.find(mime) == compression_.types.end())
+        return;
+
+    if (response_.hasExpectedContentLength() &&
+        response_.expectedContentLength() < compression_.min_length)
+        return;
+
+    // 圧縮後の長さは事前に分からないので chunked（1.0 は close 区切り）にする
+    (void)response_.removeHeader("Content-Length");
+    // 圧縮後のバイト列に対する範囲指定は受け付けない
+    (void)response_.removeHeader("Accept-Ranges");
+    // 元の表現と同じ strong ETag を名乗れないので、nginx と同じく弱い検証子に
+    // する（If-None-Match は弱い比較なので一致し、If-Range は一致しない）
+    Result<const std::vector<std::string>&> etag = response_.getHeader("ETag");
+    if (etag.isOk() && !etag.unwrap().empty() &&
+        etag.unwrap()[0].compare(0, 2, "W/") != 0)
+    {
+        const std::string weak = "W/" + etag.unwrap()[0];
+        (void)response_.setHeader("ETag", weak);
+    }
+    if (not_modified)
+    {
+        (void)response_.appendHeader("Vary", "Accept-Encoding");
+        return;
+    }
+    (void)response_.setHeader("Content-Encoding", "gzip");
+    (void)response_.appendHeader("Vary", "Accept-Encoding");
+    gzip_.reset(new http::GzipEncoder(compression_.level));
+}
+
+// body の断片を（必要なら圧縮して）エンコードし、send_buffer に積む。
+// 本体は data から send_buffer へ直接書き込み、枠だけを encoder から受け取る。
+Result<void> HttpResponseWriter::appendBody_(IoBuffer& send_buffer,
+    const utils::Byte* data, size_t len, bool is_last)
+{
+    std::vector<utils::Byte> compressed;
+    if (gzip_.get() != NULL)
+    {
+        if (len > 0)
+            gzip_->update(data, len, &compressed);
+        if (is_last)
+            gzip_->finish(&compressed);
+        data = compressed.empty() ? NULL : &compressed[0];
+        len = compressed.size();
+    }
+    if (len == 0)
+        return Result<void>();
+
+    std::vector<utils::Byte> prefix;
+    std::vector<utils::Byte> suffix;
+    Result<bool> framed =
+        encoder_.encodeBodyFrame(response_, len, &prefix, &suffix);
+    if (framed.isError())
+        return Result<void>(ERROR, framed.getErrorMessage());
+
+    if (framed.unwrap())
+    {
+        if (!prefix.empty())
+            send_buffer.append(
+                reinterpret_cast<const char*>(&prefix[0]), prefix.size());
+        send_buffer.append(reinterpret_cast<const char*>(data), len);
+        if (!suffix.empty())
+            send_buffer.append(
+                reinterpret_cast<const char*>(&suffix[0]), suffix.size());
+    }
+    body_started_ = true;
+    return Result<void>();
+}
+
 Result<HttpResponseWriter::PumpResult> HttpResponseWriter::pump(
     IoBuffer& send_buffer)
+{
+    return pump(send_buffer, kDefaultChunkBytes);
+}
+
+Result<HttpResponseWriter::PumpResult> HttpResponseWriter::pump(
+    IoBuffer& send_buffer, size_t max_body_bytes)
 {
     PumpResult pr;
 
     if (!header_written_)
     {
+        setupCompression_();
         Result<std::vector<utils::Byte> > h = encoder_.encodeHeader(response_);
         if (h.isError())
             return Result<PumpResult>(ERROR, h.getErrorMessage());
@@ -68,33 +192,39 @@ Result<HttpResponseWriter::PumpResult> HttpResponseWriter::pump(
         return pr;
     }
 
-    // 読み出し
-    Result<BodySource::ReadResult> rr = body_->read(kDefaultChunkBytes);
-    if (rr.isError())
-        return Result<PumpResult>(ERROR, rr.getErrorMessage());
-
-    BodySource::ReadResult r = rr.unwrap();
-
-    if (r.status == BodySource::READ_WOULD_BLOCK)
+    // 読み出し（共有バッファを持つ source はコピーせずに参照する）
+    bool is_eof = false;
+    const utils::Byte* shared = NULL;
+    size_t shared_len = 0;
+    if (body_->readShared(max_body_bytes, &shared, &shared_len, &is_eof))
     {
-        pr.step = NEED_MORE;
-        return pr;
+        Result<void> appended =
+            appendBody_(send_buffer, shared, shared_len, is_eof);
+        if (appended.isError())
+            return Result<PumpResult>(ERROR, appended.getErrorMessage());
     }
-
-    if (!r.data.empty())
+    else
     {
-        Result<std::vector<utils::Byte> > enc =
-            encoder_.encodeBodyChunk(response_, &r.data[0], r.data.size());
-        if (enc.isError())
-            return Result<PumpResult>(ERROR, enc.getErrorMessage());
+        Result<BodySource::ReadResult> rr = body_->read(max_body_bytes);
+        if (rr.isError())
+            return Result<PumpResult>(ERROR, rr.getErrorMessage());
 
-        const std::vector<utils::Byte>& bytes = enc.unwrap();
-        if (!bytes.empty())
-            send_buffer.append(
-                reinterpret_cast<const char*>(&bytes[0]), bytes.size());
+        BodySource::ReadResult r = rr.unwrap();
+
+        if (r.status == BodySource::READ_WOULD_BLOCK)
+        {
+            pr.step = NEED_MORE;
+            return pr;
+        }
+
+        is_eof = (r.status == BodySource::READ_EOF);
+        Result<void> appended = appendBody_(send_buffer,
+            r.data.empty() ? NULL : &r.data[0], r.data.size(), is_eof);
+        if (appended.isError())
+            return Result<PumpResult>(ERROR, appended.getErrorMessage());
     }
 
-    if (r.status == BodySource::READ_EOF)
+    if (is_eof)
     {
         Result<std::vector<utils::Byte> > eof = encoder_.encodeEof(response_);
         if (eof.isError())
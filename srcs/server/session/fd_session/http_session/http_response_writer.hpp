@@ -2,10 +2,15 @@
 #define WEBSERV_HTTP_RESPONSE_WRITER_HPP_
 
 #include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
 
+#include "http/gzip_encoder.hpp"
 #include "http/http_response_encoder.hpp"
 #include "server/session/fd_session/http_session/body_source.hpp"
 #include "server/session/io_buffer.hpp"
+#include "utils/owned_ptr.hpp"
 #include "utils/result.hpp"
 
 namespace server
@@ -30,28 +35,62 @@ class HttpResponseWriter
         PumpResult() : step(NEED_MORE), should_close_connection(false) {}
     };
 
+    // 送出時圧縮の設定。enabled はクライアントが gzip を受理する場合のみ
+    // true にする。実際に圧縮するかはヘッダ送出時にレスポンスを見て決める。
+    struct CompressionOptions
+    {
+        std::set<std::string> types;
+        unsigned long min_length;
+        int level;
+        bool enabled;
+
+        CompressionOptions()
+            : types(), min_length(0), level(1), enabled(false)
+        {
+        }
+    };
+
     HttpResponseWriter(http::HttpResponse& response,
         const http::HttpResponseEncoder::Options& options, BodySource* body);
+    HttpResponseWriter(http::HttpResponse& response,
+        const http::HttpResponseEncoder::Options& options, BodySource* body,
+        const CompressionOptions& compression);
     ~HttpResponseWriter();
 
     // send_buffer に追加できる分だけエンコードして積む（ソケットwriteは別）
     Result<PumpResult> pump(IoBuffer& send_buffer);
+    // body を最大 max_body_bytes まで読み出して積む版。
+    // fd の readiness に依存しない body（ファイル等）をまとめて積む用途。
+    Result<PumpResult> pump(IoBuffer& send_buffer, size_t max_body_bytes);
 
     // エラー等で body をこれ以上送れない場合に、可能ならレスポンスの終端を
     // send_buffer に積む。chunked の場合は "0\r\n\r\n" を送る。
     // close-delimited の場合は何も積まれない（接続 close が EOF）。
     Result<void> writeEof(IoBuffer& send_buffer);
 
+    // ヘッダは積んだが body の最初のバイト（または終端）をまだ積んでいない
+    bool isWaitingForFirstBody() const
+    {
+        return header_written_ && !body_started_ && !eof_written_;
+    }
+
    private:
     static const size_t kDefaultChunkBytes = 8192;
 
     http::HttpResponse& response_;
     http::HttpResponseEncoder encoder_;
     BodySource* body_;
+    CompressionOptions compression_;
+    utils::OwnedPtr<http::GzipEncoder> gzip_;
 
     bool header_written_;
+    bool body_started_;
     bool eof_written_;
 
+    void setupCompression_();
+    Result<void> appendBody_(IoBuffer& send_buffer, const utils::Byte* data,
+        size_t len, bool is_last);
+
     HttpResponseWriter();
     HttpResponseWriter(const HttpResponseWriter& rhs);
     HttpResponseWriter& operator=(const HttpResponseWriter& rhs);
@@ -2,6 +2,7 @@
 
 #include "server/session/fd_session/cgi_session.hpp"
 #include "server/session/fd_session/http_session.hpp"
+#include "server/session/fd_session/http_session/states/http_session_states.hpp"
 
 namespace server
 {
@@ -24,8 +25,11 @@ void HttpSession::installBodySourceAndWriter_(
 
     http::HttpResponseEncoder::Options opt =
         module_.makeEncoderOptions(context_.request);
+    const HttpResponseWriter::CompressionOptions compression =
+        module_.makeCompressionOptions(context_.request,
+            context_.socket_fd.getServerIp(), context_.socket_fd.getServerPort());
     context_.response_writer = new HttpResponseWriter(
-        context_.response, opt, context_.body_source.get());
+        context_.response, opt, context_.body_source.get(), compression);
 }
 
 void HttpSession::cleanupCgiOnClose_()
@@ -51,6 +55,82 @@ void HttpSession::cleanupCgiOnClose_()
     context_.pause_write_until_body_ready = false;
 }
 
+// パイプラインで先行したレスポンスの残りを socket へ書き出す。
+// SendResponseState 以外（次のリクエスト受信中 / CGI 実行中）でも、
+// send_buffer に残ったバイトはここから送る。
+Result<void> HttpSession::flushPendingSendBuffer_()
+{
+    if (context_.send_buffer.size() == 0)
+        return Result<void>();
+
+    const ssize_t n = context_.send_buffer.flushToFd(context_.socket_fd.getFd());
+    if (n < 0)
+        return Result<void>(ERROR, "event fd write failed");
+    return updateSocketWatches_();
+}
+
+// 待機中（CGI 実行中 / ブロッキング処理中 / CGI スロット待ち）の socket
+// イベント。受信した分は recv_buffer に積み、パイプラインで先行した
+// レスポンスが send_buffer に残っていれば送る。
+// peer のハーフクローズは peer_closed に記録するだけで、待ちをやめるか
+// どうかは各状態が決める。
+Result<void> HttpSession::handleSocketEventWhileWaiting_(const FdEvent& event)
+{
+    if (event.fd != context_.socket_fd.getFd())
+        return Result<void>();
+
+    if (event.type == kReadEvent)
+    {
+        if (context_.recv_buffer.size() < kMaxRecvBufferBytes)
+        {
+            const ssize_t n =
+                context_.recv_buffer.fillFromFd(context_.socket_fd.getFd());
+            if (n < 0)
+            {
+                changeState(new CloseWaitState());
+                return Result<void>(ERROR, "event fd read failed");
+            }
+            if (n == 0)
+            {
+                context_.peer_closed = true;
+                context_.should_close_connection = true;
+            }
+        }
+        (void)updateSocketWatches_();
+    }
+
+    if (event.type == kWriteEvent)
+    {
+        Result<void> f = flushPendingSendBuffer_();
+        if (f.isError())
+        {
+            changeState(new CloseWaitState());
+            return f;
+        }
+    }
+
+    if (event.is_opposite_close)
+    {
+        context_.peer_closed = true;
+        context_.should_close_connection = true;
+    }
+    return Result<void>();
+}
+
+void HttpSession::getWaitingWatchFlags_(bool* want_read, bool* want_write) const
+{
+    if (want_read)
+    {
+        // peer が閉じた後は EOF が読め続けるので read watch を止める
+        *want_read = !context_.peer_closed &&
+                     context_.recv_buffer.size() < kMaxRecvBufferBytes;
+    }
+    if (want_write)
+    {
+        *want_write = (context_.send_buffer.size() > 0);
+    }
+}
+
 // processError を試み、失敗したら setSimpleErrorResponse_
 // で最低限のヘッダだけ作る。 fallback の場合 out->body_source は NULL
 // になる。
@@ -61,9 +141,9 @@ Result<void> HttpSession::buildErrorOutput_(
 }
 
 Result<void> HttpSession::buildProcessorOutputOrServerError_(
-    RequestProcessor::Output* out)
+    RequestProcessor::Output* out, bool may_defer)
 {
-    return module_.buildProcessorOutputOrServerError(context_, out);
+    return module_.buildProcessorOutputOrServerError(context_, out, may_defer);
 }
 
 }  // namespace server
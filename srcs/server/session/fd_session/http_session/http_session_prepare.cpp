@@ -1,6 +1,8 @@
 #include <string>
 
+#include "server/session/fd_session/cgi_session.hpp"
 #include "server/session/fd_session/http_session.hpp"
+#include "server/session/fd_session/http_session/actions/execute_cgi_action.hpp"
 #include "server/session/fd_session/http_session/actions/send_error_action.hpp"
 #include "server/session/fd_session/http_session/states/http_session_states.hpp"
 #include "utils/log.hpp"
@@ -10,6 +12,41 @@ namespace server
 
 using namespace utils::result;
 
+// リクエストを受け取り終えたときのログ
+static void logAcceptedRequest_(const SessionContext& ctx)
+{
+    std::string request_host = ctx.socket_fd.getServerIp().toString() + ":" +
+                               ctx.socket_fd.getServerPort().toString();
+    Result<const std::vector<std::string>&> host_header =
+        ctx.request.getHeader("Host");
+    if (host_header.isOk())
+    {
+        const std::vector<std::string>& values = host_header.unwrap();
+        if (!values.empty() && !values[0].empty() && request_host != values[0])
+            request_host = request_host + "(" + values[0] + ")";
+    }
+
+    // infoログ
+    const std::string info_msg =
+        std::string("Host: ") + request_host + " Accepted request " +
+        ctx.request.getMethod().toString() + " " + ctx.request.getPath() +
+        " from " + ctx.socket_fd.getClientIp().toString() + ":" +
+        ctx.socket_fd.getClientPort().toString();
+    utils::Log::info(info_msg);
+
+    // debugログ
+    const std::string& query = ctx.request.getQueryString();
+    const std::string target = query.empty()
+                                   ? ctx.request.getPath()
+                                   : (ctx.request.getPath() + "?" + query);
+    const std::string debug_msg =
+        std::string("Host: ") + request_host + " Accepted request " +
+        ctx.request.getMethod().toString() + " " + ctx.request.getPath() +
+        " from " + ctx.socket_fd.getClientIp().toString() + ":" +
+        ctx.socket_fd.getClientPort().toString() + " " + target;
+    utils::Log::debug(debug_msg);
+}
+
 Result<void> HttpSession::prepareResponseOrCgi_()
 {
     context_.response.reset();
@@ -48,41 +85,17 @@ Result<void> HttpSession::consumeRecvBufferWithoutRead_()
 
         // ログ出力のための実装
         if (!was_parse_complete && context_.request.isParseComplete())
+            logAcceptedRequest_(context_);
+
+        // cgi_request_buffering off: ボディを読む前に CGI を起動する
+        if (context_.request_handler.isBodyStreamPending())
         {
-            std::string request_host =
-                context_.socket_fd.getServerIp().toString() + ":" +
-                context_.socket_fd.getServerPort().toString();
-            Result<const std::vector<std::string>&> host_header =
-                context_.request.getHeader("Host");
-            if (host_header.isOk())
-            {
-                const std::vector<std::string>& values = host_header.unwrap();
-                if (!values.empty() && !values[0].empty() &&
-                    request_host != values[0])
-                    request_host = request_host + "(" + values[0] + ")";
-            }
-
-            // infoログ
-            const std::string info_msg =
-                std::string("Host: ") + request_host + " Accepted request " +
-                context_.request.getMethod().toString() + " " +
-                context_.request.getPath() + " from " +
-                context_.socket_fd.getClientIp().toString() + ":" +
-                context_.socket_fd.getClientPort().toString();
-            utils::Log::info(info_msg);
-
-            // debugログ
-            const std::string& query = context_.request.getQueryString();
-            const std::string target =
-                query.empty() ? context_.request.getPath()
-                              : (context_.request.getPath() + "?" + query);
-            const std::string debug_msg =
-                std::string("Host: ") + request_host + " Accepted request " +
-                context_.request.getMethod().toString() + " " +
-                context_.request.getPath() + " from " +
-                context_.socket_fd.getClientIp().toString() + ":" +
-                context_.socket_fd.getClientPort().toString() + " " + target;
-            utils::Log::debug(debug_msg);
+            Result<bool> started = ExecuteCgiAction::startWithBodyStream(*this);
+            if (started.isError())
+                return Result<void>(ERROR, started.getErrorMessage());
+            if (started.unwrap())
+                return pumpRequestBodyToCgi_();
+            continue;  // 起動できなかったので BodyStore に溜める
         }
 
         if (context_.request.isParseComplete())
@@ -96,4 +109,60 @@ Result<void> HttpSession::consumeRecvBufferWithoutRead_()
     return Result<void>();
 }
 
+bool HttpSession::isStreamingBodyToCgi_() const
+{
+    return context_.request_handler.isStreamingBody() &&
+           !context_.request.isParseComplete() &&
+           context_.active_cgi_session != NULL;
+}
+
+// CGI が読んだ分だけ recv_buffer からボディを移す。bodyStream() が一杯の間は
+// recv_buffer に残るので、recv_buffer も一杯になればソケットの read が止まり、
+// クライアントの送信も TCP のウィンドウで止まる。
+Result<void> HttpSession::pumpRequestBodyToCgi_()
+{
+    if (!context_.request_handler.isStreamingBody() ||
+        context_.active_cgi_session == NULL)
+        return Result<void>();
+
+    if (!context_.request.isParseComplete())
+    {
+        Result<void> c = module_.dispatcher.consumeFromRecvBuffer(context_);
+        if (c.isError())
+        {
+            http::HttpStatus st = context_.request.getParseErrorStatus();
+            if (st == http::HttpStatus::OK)
+                st = http::HttpStatus::BAD_REQUEST;
+            return abortBodyStreamToCgi_(st);
+        }
+        if (context_.request.isPayloadTooLarge())
+            return abortBodyStreamToCgi_(http::HttpStatus::PAYLOAD_TOO_LARGE);
+        if (context_.request.isParseComplete())
+            logAcceptedRequest_(context_);
+    }
+
+    context_.active_cgi_session->onRequestBodyAvailable();
+    return updateSocketWatches_();
+}
+
+// ボディの途中でエラーになった。CGI は既に一部を受け取っているので止める。
+Result<void> HttpSession::abortBodyStreamToCgi_(http::HttpStatus status)
+{
+    cleanupCgiOnClose_();
+
+    // CGI のレスポンスをまだ送り始めていなければエラーを返せる
+    IHttpSessionState* state =
+        context_.pending_state ? context_.pending_state : context_.current_state;
+    if (dynamic_cast<ExecuteCgiState*>(state) != NULL)
+    {
+        SendErrorAction action(status);
+        return action.execute(*this);
+    }
+
+    changeState(new CloseWaitState());
+    context_.socket_fd.shutdown();
+    controller_.requestDelete(this);
+    return Result<void>();
+}
+
 }  // namespace server
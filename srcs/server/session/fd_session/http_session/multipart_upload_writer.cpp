@@ -0,0 +1,464 @@
+#include "server/session/fd_session/http_session/multipart_upload_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+#include "http/content_types.hpp"
+#include "server/session/fd_session/http_session/upload_path.hpp"
+#include "utils/timestamp.hpp"
+
+namespace server
+{
+using namespace utils::result;
+
+namespace
+{
+
+std::string toLowerAscii_(const std::string& s)
+{
+    std::string out = s;
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+        out[i] =
+            static_cast<char>(std::tolower(static_cast<unsigned char>(out[i])));
+    }
+    return out;
+}
+
+std::string trimAsciiOws_(const std::string& s)
+{
+    std::string::size_type b = 0;
+    while (b < s.size() && (s[b] == ' ' || s[b] == '\t'))
+        ++b;
+    std::string::size_type e = s.size();
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t'))
+        --e;
+    return s.substr(b, e - b);
+}
+
+bool startsWithNoCase_(const std::string& s, const char* prefix)
+{
+    const std::string p(prefix);
+    if (s.size() < p.size())
+        return false;
+    for (size_t i = 0; i < p.size(); ++i)
+    {
+        const unsigned char a = static_cast<unsigned char>(s[i]);
+        const unsigned char b = static_cast<unsigned char>(p[i]);
+        if (std::tolower(a) != std::tolower(b))
+            return false;
+    }
+    return true;
+}
+
+std::string headerValueAfterColon_(const std::string& line)
+{
+    std::string::size_type pos = line.find(':');
+    if (pos == std::string::npos)
+        return std::string();
+    return trimAsciiOws_(line.substr(pos + 1));
+}
+
+std::string stripPathComponents_(const std::string& filename)
+{
+    std::string::size_type p1 = filename.find_last_of('/');
+    std::string::size_type p2 = filename.find_last_of('\\');
+    std::string::size_type p = std::string::npos;
+    if (p1 != std::string::npos)
+        p = p1;
+    if (p2 != std::string::npos)
+        p = (p == std::string::npos) ? p2 : std::max(p, p2);
+    return (p == std::string::npos) ? filename : filename.substr(p + 1);
+}
+
+void splitStemAndExt_(
+    const std::string& name, std::string* out_stem, std::string* out_ext)
+{
+    if (out_stem)
+        *out_stem = name;
+    if (out_ext)
+        out_ext->clear();
+
+    const std::string base = stripPathComponents_(name);
+    std::string::size_type dot = base.find_last_of('.');
+    if (dot == std::string::npos || dot == 0 || dot + 1 >= base.size())
+    {
+        if (out_stem)
+            *out_stem = base;
+        return;
+    }
+    if (out_stem)
+        *out_stem = base.substr(0, dot);
+    if (out_ext)
+        *out_ext = base.substr(dot + 1);
+}
+
+bool parseContentDispositionFilename_(const std::string& line,
+    bool* has_filename_param, std::string* out_filename)
+{
+    if (has_filename_param)
+        *has_filename_param = false;
+    if (out_filename)
+        out_filename->clear();
+
+    if (!startsWithNoCase_(line, "Content-Disposition:"))
+        return false;
+
+    std::string v = headerValueAfterColon_(line);
+    std::string lower = toLowerAscii_(v);
+    std::string::size_type p = lower.find("filename=");
+    if (p == std::string::npos)
+        return true;
+
+    if (has_filename_param)
+        *has_filename_param = true;
+
+    std::string raw = v.substr(p + std::string("filename=").size());
+    raw = trimAsciiOws_(raw);
+    if (raw.empty())
+        return true;
+    if (raw[0] == '"')
+    {
+        std::string::size_type end = raw.find('"', 1);
+        if (end == std::string::npos)
+            return true;
+        raw = raw.substr(1, end - 1);
+    }
+    else
+    {
+        std::string::size_type semi = raw.find(';');
+        if (semi != std::string::npos)
+            raw = raw.substr(0, semi);
+        raw = trimAsciiOws_(raw);
+    }
+
+    if (out_filename)
+        *out_filename = stripPathComponents_(raw);
+    return true;
+}
+
+}  // namespace
+
+MultipartUploadWriter::MultipartUploadWriter()
+    : state_(kInactive),
+      boundary_line_(),
+      delimiter_(),
+      upload_(),
+      request_stem_(),
+      request_ext_(),
+      error_(),
+      buf_(),
+      part_has_filename_(false),
+      part_filename_(),
+      part_has_content_type_(false),
+      part_content_type_(),
+      out_fd_(-1),
+      out_path_(),
+      file_count_(0),
+      created_paths_()
+{
+}
+
+MultipartUploadWriter::~MultipartUploadWriter() { reset(); }
+
+void MultipartUploadWriter::reset()
+{
+    // finish() まで届かなかったリクエストのファイルは残さない
+    removeCreatedFiles_();
+    state_ = kInactive;
+    boundary_line_.clear();
+    delimiter_.clear();
+    upload_ = UploadContext();
+    request_stem_.clear();
+    request_ext_.clear();
+    error_.clear();
+    std::string().swap(buf_);
+    part_has_filename_ = false;
+    part_filename_.clear();
+    part_has_content_type_ = false;
+    part_content_type_.clear();
+    file_count_ = 0;
+}
+
+void MultipartUploadWriter::begin(
+    const std::string& boundary, const UploadContext& upload)
+{
+    reset();
+    upload_ = upload;
+    state_ = kPreamble;
+    if (boundary.empty())
+    {
+        fail_("missing multipart boundary");
+        return;
+    }
+    boundary_line_ = "--" + boundary;
+    delimiter_ = "\r\n" + boundary_line_;
+    splitStemAndExt_(upload_.request_leaf_name, &request_stem_, &request_ext_);
+
+    if (!upload_.destination_dir.empty() &&
+        ::access(upload_.destination_dir.str().c_str(), W_OK | X_OK) != 0)
+        fail_("forbidden");
+}
+
+Result<void> MultipartUploadWriter::write(const utils::Byte* data, size_t len)
+{
+    if (state_ == kInactive || state_ == kEpilogue || state_ == kFailed)
+        return Result<void>();
+    if (data == NULL || len == 0)
+        return Result<void>();
+
+    buf_.append(reinterpret_cast<const char*>(data), len);
+    while (step_())
+    {
+    }
+    return Result<void>();
+}
+
+Result<void> MultipartUploadWriter::finish()
+{
+    switch (state_)
+    {
+        case kInactive:
+            return Result<void>();
+        case kFailed:
+            return Result<void>(ERROR, error_);
+        case kEpilogue:
+            if (file_count_ == 0)
+                return Result<void>(ERROR, "no file part found");
+            // 保存できたファイルは以後 reset() でも消さない
+            created_paths_.clear();
+            return Result<void>();
+        case kPreamble:
+            fail_("multipart boundary not found");
+            return Result<void>(ERROR, error_);
+        default:
+            fail_("unexpected EOF");
+            return Result<void>(ERROR, error_);
+    }
+}
+
+// buf_ を現在の状態で1段処理する。さらに進められるなら true。
+bool MultipartUploadWriter::step_()
+{
+    std::string line;
+    switch (state_)
+    {
+        case kPreamble:
+            if (!takeLine_(&line))
+                return false;
+            if (line == boundary_line_)
+            {
+                state_ = kPartHeaders;
+            }
+            else if (line == boundary_line_ + "--")
+            {
+                fail_("multipart boundary not found");
+                return false;
+            }
+            return true;
+
+        case kPartHeaders:
+            if (!takeLine_(&line))
+                return false;
+            if (!line.empty())
+            {
+                onPartHeaderLine_(line);
+                return true;
+            }
+            if ((part_has_filename_ || part_has_content_type_) &&
+                !openPartFile_())
+                return false;
+            state_ = kPartBody;
+            return true;
+
+        case kPartBody:
+        {
+            const std::string::size_type pos = buf_.find(delimiter_);
+            if (pos != std::string::npos)
+            {
+                if (!writeOut_(buf_.data(), pos))
+                    return false;
+                buf_.erase(0, pos + delimiter_.size());
+                state_ = kBoundarySuffix;
+                return true;
+            }
+            // 区切りが受信データの境目にまたがる可能性がある分だけ残す
+            const size_t keep = delimiter_.size() - 1;
+            if (buf_.size() > keep)
+            {
+                const size_t n = buf_.size() - keep;
+                if (!writeOut_(buf_.data(), n))
+                    return false;
+                buf_.erase(0, n);
+            }
+            return false;
+        }
+
+        case kBoundarySuffix:
+            if (buf_.size() < 2)
+                return false;
+            if (buf_.compare(0, 2, "--") == 0)
+            {
+                closePartFile_();
+                state_ = kEpilogue;
+                buf_.clear();
+                return false;
+            }
+            if (buf_.compare(0, 2, "\r\n") == 0)
+            {
+                closePartFile_();
+                buf_.erase(0, 2);
+                part_has_filename_ = false;
+                part_filename_.clear();
+                part_has_content_type_ = false;
+                part_content_type_.clear();
+                state_ = kPartHeaders;
+                return true;
+            }
+            fail_("invalid boundary suffix");
+            return false;
+
+        default:
+            buf_.clear();
+            return false;
+    }
+}
+
+bool MultipartUploadWriter::takeLine_(std::string* out_line)
+{
+    const std::string::size_type pos = buf_.find("\r\n");
+    if (pos == std::string::npos)
+    {
+        if (buf_.size() > kMaxHeaderLineBytes)
+            fail_("multipart header too long");
+        return false;
+    }
+    if (pos > kMaxHeaderLineBytes)
+    {
+        fail_("multipart header too long");
+        return false;
+    }
+    out_line->assign(buf_, 0, pos);
+    buf_.erase(0, pos + 2);
+    return true;
+}
+
+void MultipartUploadWriter::onPartHeaderLine_(const std::string& line)
+{
+    bool has_fn = false;
+    std::string fn;
+    (void)parseContentDispositionFilename_(line, &has_fn, &fn);
+    if (has_fn)
+    {
+        part_has_filename_ = true;
+        part_filename_ = fn;
+    }
+    if (startsWithNoCase_(line, "Content-Type:"))
+    {
+        part_has_content_type_ = true;
+        part_content_type_ = headerValueAfterColon_(line);
+    }
+}
+
+// 保存名: filename の stem + Content-Type 由来の拡張子（不明なら bin）。
+// filename が無い最初の file part は、URL がファイル指定ならその名前を使う。
+std::string MultipartUploadWriter::decideLeafName_() const
+{
+    std::string part_ext = "bin";
+    if (part_has_content_type_)
+    {
+        const http::ContentType part_ct =
+            http::ContentType::parseHeaderValue(part_content_type_, NULL);
+        if (part_ct != http::ContentType::UNKNOWN)
+            part_ext = http::ContentType(part_ct).toExtention();
+    }
+
+    std::string stem;
+    if (!part_filename_.empty())
+    {
+        splitStemAndExt_(part_filename_, &stem, NULL);
+    }
+    else if (file_count_ == 0 && !upload_.request_target_is_directory &&
+             !upload_.request_leaf_name.empty())
+    {
+        stem = request_stem_;
+        if (!part_has_content_type_ && !request_ext_.empty())
+            part_ext = request_ext_;
+    }
+    if (stem.empty())
+        stem = utils::Timestamp::nowYmdHmsCompact() + "_uploaded";
+
+    return UploadPath::uniqueLeafName(
+        upload_.destination_dir.str(), stem, part_ext);
+}
+
+bool MultipartUploadWriter::openPartFile_()
+{
+    out_path_ =
+        UploadPath::join(upload_.destination_dir.str(), decideLeafName_());
+    out_fd_ = ::open(out_path_.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (out_fd_ < 0)
+    {
+        out_path_.clear();
+        fail_("open() failed");
+        return false;
+    }
+    created_paths_.push_back(out_path_);
+    ++file_count_;
+    return true;
+}
+
+bool MultipartUploadWriter::writeOut_(const char* data, size_t len)
+{
+    if (out_fd_ < 0)
+        return true;  // file 以外の part は読み捨てる
+
+    size_t off = 0;
+    while (off < len)
+    {
+        const ssize_t w = ::write(out_fd_, data + off, len - off);
+        if (w <= 0)
+        {
+            fail_("internal fd write failed");
+            return false;
+        }
+        off += static_cast<size_t>(w);
+    }
+    return true;
+}
+
+void MultipartUploadWriter::closePartFile_()
+{
+    if (out_fd_ >= 0)
+    {
+        ::close(out_fd_);
+        out_fd_ = -1;
+    }
+    out_path_.clear();
+}
+
+// 書きかけの part を閉じ、このリクエストで作ったファイルをすべて削除する
+void MultipartUploadWriter::removeCreatedFiles_()
+{
+    closePartFile_();
+    for (size_t i = 0; i < created_paths_.size(); ++i)
+        (void)std::remove(created_paths_[i].c_str());
+    created_paths_.clear();
+}
+
+void MultipartUploadWriter::fail_(const std::string& message)
+{
+    if (state_ == kFailed)
+        return;
+    // 途中で失敗したリクエストは、先に書き終えた part の分も残さない
+    removeCreatedFiles_();
+    error_ = message;
+    state_ = kFailed;
+    std::string().swap(buf_);
+}
+
+}  // namespace server
@@ -0,0 +1,92 @@
+#ifndef WEBSERV_MULTIPART_UPLOAD_WRITER_HPP_
+#define WEBSERV_MULTIPART_UPLOAD_WRITER_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "server/http_processing_module/request_router/location_routing.hpp"
+#include "utils/data_type.hpp"
+#include "utils/result.hpp"
+
+namespace server
+{
+using utils::result::Result;
+
+// multipart/form-data のボディを受信しながら解析し、file part を
+// upload_store の保存先へ直接書き出す（RFC 7578 / RFC 2046 Section 5.1）。
+// - ボディを一時ファイルに溜めて読み直さないので、書き込みは1回で済む。
+// - 途中で不正を検出しても受信は止めず（keep-alive のため読み捨てる）、
+//   エラーは finish() で返す。
+// - エラー時、および finish() が成功しないまま reset() されたときは、
+//   このリクエストで作ったファイルを（書き終えた part の分も）すべて削除する。
+class MultipartUploadWriter
+{
+   public:
+    // part ヘッダー行の上限（preamble の行にも適用する）
+    static const size_t kMaxHeaderLineBytes = 8 * 1024;
+
+    MultipartUploadWriter();
+    ~MultipartUploadWriter();
+
+    // ボディ受信前に呼ぶ。boundary が空でも有効化し、finish() でエラーにする。
+    void begin(const std::string& boundary, const UploadContext& upload);
+    bool isActive() const { return state_ != kInactive; }
+
+    // 常に OK を返す（エラーは内部に記録して以降を読み捨てる）。
+    Result<void> write(const utils::Byte* data, size_t len);
+
+    // ボディ受信完了後に呼ぶ。保存できた file part が無ければエラー。
+    Result<void> finish();
+
+    void reset();
+
+   private:
+    enum State
+    {
+        kInactive,
+        kPreamble,
+        kPartHeaders,
+        kPartBody,
+        kBoundarySuffix,
+        kEpilogue,
+        kFailed
+    };
+
+    State state_;
+    std::string boundary_line_;  // "--" + boundary
+    std::string delimiter_;      // "\r\n--" + boundary
+    UploadContext upload_;
+    std::string request_stem_;
+    std::string request_ext_;
+    std::string error_;
+    std::string buf_;  // 未処理の受信データ
+
+    // 解析中の part
+    bool part_has_filename_;
+    std::string part_filename_;
+    bool part_has_content_type_;
+    std::string part_content_type_;
+    int out_fd_;
+    std::string out_path_;
+    size_t file_count_;
+    // このリクエストで作成したファイル（finish() が成功したら手放す）
+    std::vector<std::string> created_paths_;
+
+    MultipartUploadWriter(const MultipartUploadWriter& rhs);
+    MultipartUploadWriter& operator=(const MultipartUploadWriter& rhs);
+
+    bool step_();
+    bool takeLine_(std::string* out_line);
+    void onPartHeaderLine_(const std::string& line);
+    bool openPartFile_();
+    std::string decideLeafName_() const;
+    bool writeOut_(const char* data, size_t len);
+    void closePartFile_();
+    void removeCreatedFiles_();
+    void fail_(const std::string& message);
+};
+
+}  // namespace server
+
+#endif
@@ -36,8 +36,9 @@ SessionContext::SessionContext(int fd, const SocketAddress& server_addr,
       has_request_start_time(false),
       request_start_time_seconds(0),
       active_cgi_session(NULL),
+      pending_blocking_task(NULL),
       request_handler(
-          request, rt, socket_fd.getServerIp(), socket_fd.getServerPort(), this)
+          request, rt, socket_fd.getServerIp(), socket_fd.getServerPort())
 {
 }
 
@@ -19,6 +19,7 @@ class HttpResponseWriter;
 class RequestRouter;
 class CgiSession;
 class IHttpSessionState;
+class BlockingTask;
 
 struct SessionContext
 {
@@ -64,6 +65,8 @@ struct SessionContext
     long request_start_time_seconds;
 
     CgiSession* active_cgi_session;
+    // 完了待ちの BlockingTask（所有は BlockingTaskPool 側）
+    BlockingTask* pending_blocking_task;
     HttpRequestHandler request_handler;
 
     SessionContext(int fd, const SocketAddress& server_addr,
@@ -10,36 +10,24 @@ using namespace utils::result;
 Result<void> ExecuteCgiState::handleEvent(
     HttpSession& context, const FdEvent& event)
 {
+    Result<void> w = context.handleSocketEventWhileWaiting_(event);
+    if (w.isError())
+        return w;
+
+    // cgi_request_buffering off: 読んだボディを CGI へ流す
     if (event.fd == context.context_.socket_fd.getFd() &&
         event.type == kReadEvent)
     {
-        if (context.context_.recv_buffer.size() <
-            HttpSession::kMaxRecvBufferBytes)
-        {
-            const ssize_t n = context.context_.recv_buffer.fillFromFd(
-                context.context_.socket_fd.getFd());
-            if (n < 0)
-            {
-                context.changeState(new CloseWaitState());
-                return Result<void>(ERROR, "event fd read failed");
-            }
-            if (n == 0)
-            {
-                context.context_.peer_closed = true;
-                context.context_.should_close_connection = true;
-            }
-        }
+        Result<void> p = context.pumpRequestBodyToCgi_();
+        if (p.isError())
+            return p;
         context.updateSocketWatches_();
     }
 
-    if (event.is_opposite_close &&
-        event.fd == context.context_.socket_fd.getFd())
-    {
-        context.context_.peer_closed = true;
-        context.context_.should_close_connection = true;
-    }
-
-    if (context.context_.peer_closed)
+    // パイプラインで先行したレスポンスが send_buffer に残っている間は
+    // 閉じずに送り続け、送り切ってから閉じる
+    if (context.context_.peer_closed &&
+        context.context_.send_buffer.size() == 0)
     {
         context.changeState(new CloseWaitState());
         context.context_.socket_fd.shutdown();
@@ -53,15 +41,7 @@ Result<void> ExecuteCgiState::handleEvent(
 void ExecuteCgiState::getWatchFlags(
     const HttpSession& session, bool* want_read, bool* want_write) const
 {
-    if (want_read)
-    {
-        *want_read = (session.context_.recv_buffer.size() <
-                      HttpSession::kMaxRecvBufferBytes);
-    }
-    if (want_write)
-    {
-        *want_write = false;
-    }
+    session.getWaitingWatchFlags_(want_read, want_write);
 }
 
 }  // namespace server
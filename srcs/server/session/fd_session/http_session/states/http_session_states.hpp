@@ -26,6 +26,26 @@ class ExecuteCgiState : public IHttpSessionState
         const HttpSession& session, bool* want_read, bool* want_write) const;
 };
 
+// BlockingTask の完了待ち。完了は HttpSession::onBlockingTaskDone で受ける。
+class WaitBlockingTaskState : public IHttpSessionState
+{
+   public:
+    virtual utils::result::Result<void> handleEvent(
+        HttpSession& context, const FdEvent& event);
+    virtual void getWatchFlags(
+        const HttpSession& session, bool* want_read, bool* want_write) const;
+};
+
+// cgi_max_concurrency の空き待ち。順番が来たら HttpSession::onCgiSlotGranted
+class WaitCgiSlotState : public IHttpSessionState
+{
+   public:
+    virtual utils::result::Result<void> handleEvent(
+        HttpSession& context, const FdEvent& event);
+    virtual void getWatchFlags(
+        const HttpSession& session, bool* want_read, bool* want_write) const;
+};
+
 class SendResponseState : public IHttpSessionState
 {
    public:
@@ -37,6 +57,9 @@ class SendResponseState : public IHttpSessionState
    private:
     utils::result::Result<void> switchToInternalServerErrorAndClose_(
         HttpSession& session, const std::string& message) const;
+    utils::result::Result<void> batchPipelinedResponses_(
+        HttpSession& context) const;
+    void finishResponse_(HttpSession& context, bool flushed) const;
 };
 
 class CloseWaitState : public IHttpSessionState
@@ -40,6 +40,28 @@ Result<void> RecvRequestState::handleEvent(
         saw_peer_half_close = true;
     }
 
+    // パイプラインで先行したレスポンスが send_buffer に残っていれば送る
+    if (event.type == kWriteEvent)
+    {
+        Result<void> f = context.flushPendingSendBuffer_();
+        if (f.isError())
+        {
+            context.changeState(new CloseWaitState());
+            return f;
+        }
+        if (context.context_.send_buffer.size() == 0 &&
+            context.context_.peer_closed &&
+            isRequestParsingNotStarted_(context.context_.request) &&
+            context.context_.recv_buffer.size() == 0)
+        {
+            context.changeState(new CloseWaitState());
+            context.context_.socket_fd.shutdown();
+            context.cleanupCgiOnClose_();
+            context.controller_.requestDelete(&context);
+        }
+        return Result<void>();
+    }
+
     if (event.type == kReadEvent)
     {
         // まず、すでにバッファに溜まっている分を先に消費する（read()しない）。
@@ -148,6 +170,12 @@ Result<void> RecvRequestState::handleEvent(
         if (isRequestParsingNotStarted_(context.context_.request) &&
             context.context_.recv_buffer.size() == 0)
         {
+            // 先行レスポンスの送信が残っていれば、送り切ってから閉じる
+            if (context.context_.send_buffer.size() > 0)
+            {
+                (void)context.updateSocketWatches_();
+                return Result<void>();
+            }
             context.changeState(new CloseWaitState());
             context.context_.socket_fd.shutdown();
             context.cleanupCgiOnClose_();
@@ -172,7 +200,7 @@ void RecvRequestState::getWatchFlags(
     }
     if (want_write)
     {
-        *want_write = false;
+        *want_write = (session.context_.send_buffer.size() > 0);
     }
 }
 
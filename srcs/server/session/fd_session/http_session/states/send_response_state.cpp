@@ -49,8 +49,9 @@ Result<void> SendResponseState::switchToInternalServerErrorAndClose_(
         return Result<void>();
     }
 
-    // 送信途中のデータは破棄し、500 に差し替える。
-    session.context_.send_buffer.consume(session.context_.send_buffer.size());
+    // このレスポンスはまだ 1 byte も積んでいないので、500 に差し替える。
+    // send_buffer に残っているのはパイプラインで先行したレスポンスなので
+    // 破棄せずそのまま送る。
 
     RequestProcessor::Output out;
     Result<void> bo =
@@ -75,9 +76,163 @@ Result<void> SendResponseState::switchToInternalServerErrorAndClose_(
 
 using namespace utils::result;
 
+// 1レスポンス分の送出が（send_buffer への積み込みまで）完了した後始末。
+// ログ出力と writer/body/request の破棄を行い、次のリクエストを受けられる
+// 状態に戻す。状態遷移は呼び出し側が決める。
+// flushed == false はパイプラインで後続を積むために、バイトがまだ
+// send_buffer に残ったまま後始末する場合（ログは "Queued" とする）。
+void SendResponseState::finishResponse_(
+    HttpSession& context, bool flushed) const
+{
+    // リクエスト処理時間（最初の recv 〜 send 完了）を記録　ログ計測
+    if (context.processingLog() != NULL &&
+        context.context_.has_request_start_time)
+    {
+        const long end_seconds = utils::Timestamp::nowEpochSeconds();
+        long elapsed =
+            end_seconds - context.context_.request_start_time_seconds;
+        if (elapsed < 0)
+            elapsed = 0;
+        context.processingLog()->recordRequestTimeSeconds(elapsed);
+    }
+    context.context_.has_request_start_time = false;
+    context.context_.request_start_time_seconds = 0;
+
+    // レスポンス送信完了ログ（1回だけ）
+    std::string request_host =
+        context.context_.socket_fd.getServerIp().toString() + ":" +
+        context.context_.socket_fd.getServerPort().toString();
+    Result<const std::vector<std::string>&> host_header =
+        context.context_.request.getHeader("Host");
+    if (host_header.isOk())
+    {
+        const std::vector<std::string>& values = host_header.unwrap();
+        if (!values.empty() && !values[0].empty() && request_host != values[0])
+            request_host = request_host + "(" + values[0] + ")";
+    }
+
+    const http::HttpStatus status = context.context_.response.getStatus();
+    std::string reason = context.context_.response.getReasonPhrase();
+    if (reason.empty())
+        reason = status.getMessage();
+
+    std::ostringstream oss;
+    oss << "Host: " << request_host
+        << (flushed ? " Sent response " : " Queued response ")
+        << status.getCode()
+        << " " << reason << " to "
+        << context.context_.socket_fd.getClientIp().toString() << ":"
+        << context.context_.socket_fd.getClientPort().toString();
+    utils::Log::info(oss.str());
+
+    // 保留中の末尾セグメントを即座に送出する
+    context.context_.socket_fd.setCork(false);
+
+    // 1レスポンス完了
+    if (context.context_.response_writer != NULL)
+    {
+        delete context.context_.response_writer;
+        context.context_.response_writer = NULL;
+    }
+
+    // CGI が紐づいていればここで確実に回収する（zombie/リーク防止）
+    if (context.getContext().active_cgi_session != NULL)
+    {
+        context.controller_.requestDelete(
+            context.getContext().active_cgi_session);
+        context.getContext().active_cgi_session = NULL;
+    }
+    // context_.body_source は writer に渡しただけなので、ここで破棄
+    context.clearBodyWatch_();
+    context.context_.body_source.reset(NULL);
+
+    context.context_.response.reset();
+    context.getContext().request_handler.reset();
+    context.context_.request = http::HttpRequest();
+    context.context_.pause_write_until_body_ready = false;
+}
+
+// 完了したレスポンスの直後に、recv_buffer に既に届いている次のリクエストを
+// 処理し、そのレスポンスを send_buffer の後ろへ続けて積む。
+// send_buffer 上の並びがそのまま送信順になるので、リクエスト順は保たれる。
+// CGI（ExecuteCgiState へ遷移）や、リクエストが未完の場合はそこで止める。
+// それらの状態でも send_buffer に残ったバイトは flush される。
+Result<void> SendResponseState::batchPipelinedResponses_(
+    HttpSession& context) const
+{
+    SessionContext& ctx = context.context_;
+
+    for (size_t n = 0; n < HttpSession::kMaxPipelinedResponsesPerFlush; ++n)
+    {
+        if (!ctx.response.isComplete() || ctx.should_close_connection ||
+            ctx.body_watch_fd >= 0 || ctx.recv_buffer.size() == 0 ||
+            ctx.send_buffer.size() >= HttpSession::kMaxSendBatchBytes)
+            return Result<void>();
+
+        finishResponse_(context, false);
+        context.changeState(new RecvRequestState());
+        Result<void> c = context.consumeRecvBufferWithoutRead_();
+        if (c.isError())
+            return c;
+
+        if (dynamic_cast<SendResponseState*>(ctx.pending_state) == NULL ||
+            ctx.response_writer == NULL || ctx.body_watch_fd >= 0)
+            return Result<void>();
+
+        while (!ctx.response.isComplete() &&
+               ctx.send_buffer.size() < HttpSession::kMaxSendBatchBytes)
+        {
+            const size_t before = ctx.send_buffer.size();
+            Result<HttpResponseWriter::PumpResult> pumped =
+                ctx.response_writer->pump(ctx.send_buffer);
+            if (pumped.isError())
+                return switchToInternalServerErrorAndClose_(
+                    context, pumped.getErrorMessage());
+            if (pumped.unwrap().should_close_connection)
+                ctx.should_close_connection = true;
+            if (ctx.send_buffer.size() == before)
+                break;
+        }
+    }
+    return Result<void>();
+}
+
 Result<void> SendResponseState::handleEvent(
     HttpSession& context, const FdEvent& event)
 {
+    // cgi_request_buffering off: CGI がボディを読み切る前に応答を始めた。
+    // 送信と並行して、ボディの残りを受信して CGI へ流し続ける。
+    if (event.type == kReadEvent &&
+        event.fd == context.context_.socket_fd.getFd() &&
+        context.isStreamingBodyToCgi_())
+    {
+        if (context.context_.recv_buffer.size() <
+            HttpSession::kMaxRecvBufferBytes)
+        {
+            const ssize_t n = context.context_.recv_buffer.fillFromFd(
+                context.context_.socket_fd.getFd());
+            if (n < 0)
+            {
+                context.changeState(new CloseWaitState());
+                return Result<void>(ERROR, "event fd read failed");
+            }
+            if (n == 0)
+            {
+                // ボディの途中で切れた。CGI の入力も完結しないので止める
+                context.changeState(new CloseWaitState());
+                context.context_.socket_fd.shutdown();
+                context.cleanupCgiOnClose_();
+                context.controller_.requestDelete(&context);
+                return Result<void>();
+            }
+        }
+        Result<void> p = context.pumpRequestBodyToCgi_();
+        if (p.isError())
+            return p;
+        (void)context.updateSocketWatches_();
+        return Result<void>();
+    }
+
     // CGI stdout (body fd) の read イベント: body が来たら pump して socket
     // へ流す
     if (event.type == kReadEvent && context.context_.body_watch_fd >= 0 &&
@@ -101,14 +256,17 @@ Result<void> SendResponseState::handleEvent(
 
         context.context_.pause_write_until_body_ready = false;
 
-        // send_buffer が空なら pump して積む
+        // send_buffer が空なら pump して積む。
+        // read イベントで readiness が保証されているので、パイプに溜まって
+        // いる分を 1 回の read でまとめて取り出す。
         if (context.context_.send_buffer.size() == 0 &&
             context.context_.response_writer != NULL &&
             !context.context_.response.isComplete())
         {
             Result<HttpResponseWriter::PumpResult> pumped =
                 context.context_.response_writer->pump(
-                    context.context_.send_buffer);
+                    context.context_.send_buffer,
+                    HttpSession::kWriteBudgetBytesPerEvent);
             if (pumped.isError())
                 return switchToInternalServerErrorAndClose_(
                     context, pumped.getErrorMessage());
@@ -148,43 +306,67 @@ Result<void> SendResponseState::handleEvent(
         return Result<void>(ERROR, "missing response writer");
     }
 
-    // 送信バッファが空なら積む
-    if (context.context_.send_buffer.size() == 0)
+    SessionContext& ctx = context.context_;
+    if (ctx.body_watch_fd >= 0)
     {
         // body fd を watch している（典型: CGI stdout）場合、write イベントで
         // body を read しに行くと「まだ body が来ていない」タイミングで
         // read(-1) となり、送信途中に 500 を差し込む原因になる。 send_buffer
         // が空で response が未完了なら、body の read イベントを待つ。
-        if (context.context_.body_watch_fd >= 0 &&
-            !context.context_.response.isComplete())
+        if (ctx.send_buffer.size() == 0 && !ctx.response.isComplete())
         {
-            context.context_.pause_write_until_body_ready = true;
+            ctx.pause_write_until_body_ready = true;
             (void)context.updateSocketWatches_();
             return Result<void>();
         }
+    }
+    else
+    {
+        // ファイル等、readiness に依存しない body は 1 回の write イベントで
+        // kWriteBudgetBytesPerEvent まで積んでまとめて送る。
+        // 予算で打ち切るので、大きなダウンロード 1 本が他の接続の処理を
+        // 待たせ続けることはない（残りは次の write イベントで続きを積む）。
+        while (!ctx.response.isComplete() &&
+               ctx.send_buffer.size() < HttpSession::kWriteBudgetBytesPerEvent)
+        {
+            const size_t before = ctx.send_buffer.size();
+            Result<HttpResponseWriter::PumpResult> pumped =
+                ctx.response_writer->pump(ctx.send_buffer,
+                    HttpSession::kWriteBudgetBytesPerEvent - before);
+            if (pumped.isError())
+                return switchToInternalServerErrorAndClose_(
+                    context, pumped.getErrorMessage());
+            if (pumped.unwrap().should_close_connection)
+                ctx.should_close_connection = true;
+            if (ctx.send_buffer.size() == before)
+                break;
+        }
 
-        Result<HttpResponseWriter::PumpResult> pumped =
-            context.context_.response_writer->pump(
-                context.context_.send_buffer);
-        if (pumped.isError())
-            return switchToInternalServerErrorAndClose_(
-                context, pumped.getErrorMessage());
-
-        const HttpResponseWriter::PumpResult pr = pumped.unwrap();
-        if (pr.should_close_connection)
-            context.context_.should_close_connection = true;
-
-        // pump しても何も積めない場合（典型: CGI body が would-block）は
-        // write watch を止め、body fd の read を待つ。
-        if (context.context_.send_buffer.size() == 0 &&
-            !context.context_.response.isComplete())
+        // pump しても何も積めない場合は write watch を止める
+        if (ctx.send_buffer.size() == 0 && !ctx.response.isComplete())
         {
-            context.context_.pause_write_until_body_ready = true;
+            ctx.pause_write_until_body_ready = true;
             (void)context.updateSocketWatches_();
             return Result<void>();
         }
     }
 
+    // ヘッダだけを積んで最初の body を待っている間だけ cork し、ヘッダのみの
+    // 小さなセグメントを出さない。body が積まれたら外して、以後の chunk
+    // （CGI の逐次出力など）は保留せずに送る。body が来なくてもカーネルが
+    // 短い期限で保留分を送出する。
+    // 待っているレスポンスは未完なので、下のパイプライン処理は走らない。
+    const bool hold_headers = ctx.response_writer->isWaitingForFirstBody();
+
+    // パイプライン: 先頭のレスポンスを積み終えていれば、recv_buffer
+    // に届いている後続リクエストのレスポンスも続けて積み、1回の write
+    // でまとめて送る。
+    Result<void> batched = batchPipelinedResponses_(context);
+    if (batched.isError())
+        return batched;
+
+    context.context_.socket_fd.setCork(hold_headers);
+
     // flush
     if (context.context_.send_buffer.size() > 0)
     {
@@ -212,68 +394,7 @@ Result<void> SendResponseState::handleEvent(
     if (context.context_.send_buffer.size() == 0 &&
         context.context_.response.isComplete())
     {
-        // リクエスト処理時間（最初の recv 〜 send 完了）を記録　ログ計測
-        if (context.processingLog() != NULL &&
-            context.context_.has_request_start_time)
-        {
-            const long end_seconds = utils::Timestamp::nowEpochSeconds();
-            long elapsed =
-                end_seconds - context.context_.request_start_time_seconds;
-            if (elapsed < 0)
-                elapsed = 0;
-            context.processingLog()->recordRequestTimeSeconds(elapsed);
-        }
-        context.context_.has_request_start_time = false;
-        context.context_.request_start_time_seconds = 0;
-
-        // レスポンス送信完了ログ（1回だけ）
-        std::string request_host =
-            context.context_.socket_fd.getServerIp().toString() + ":" +
-            context.context_.socket_fd.getServerPort().toString();
-        Result<const std::vector<std::string>&> host_header =
-            context.context_.request.getHeader("Host");
-        if (host_header.isOk())
-        {
-            const std::vector<std::string>& values = host_header.unwrap();
-            if (!values.empty() && !values[0].empty() &&
-                request_host != values[0])
-                request_host = request_host + "(" + values[0] + ")";
-        }
-
-        const http::HttpStatus status = context.context_.response.getStatus();
-        std::string reason = context.context_.response.getReasonPhrase();
-        if (reason.empty())
-            reason = status.getMessage();
-
-        std::ostringstream oss;
-        oss << "Host: " << request_host << " Sent response " << status.getCode()
-            << " " << reason << " to "
-            << context.context_.socket_fd.getClientIp().toString() << ":"
-            << context.context_.socket_fd.getClientPort().toString();
-        utils::Log::info(oss.str());
-
-        // 1レスポンス完了
-        if (context.context_.response_writer != NULL)
-        {
-            delete context.context_.response_writer;
-            context.context_.response_writer = NULL;
-        }
-
-        // CGI が紐づいていればここで確実に回収する（zombie/リーク防止）
-        if (context.getContext().active_cgi_session != NULL)
-        {
-            context.controller_.requestDelete(
-                context.getContext().active_cgi_session);
-            context.getContext().active_cgi_session = NULL;
-        }
-        // context_.body_source は writer に渡しただけなので、ここで破棄
-        context.clearBodyWatch_();
-        context.context_.body_source.reset(NULL);
-
-        context.context_.response.reset();
-        context.getContext().request_handler.reset();
-        context.context_.request = http::HttpRequest();
-        context.context_.pause_write_until_body_ready = false;
+        finishResponse_(context, true);
 
         if (context.context_.should_close_connection)
         {
@@ -294,16 +415,19 @@ Result<void> SendResponseState::handleEvent(
         return context.consumeRecvBufferWithoutRead_();
     }
 
+    // パイプラインで次の状態へ進んでいる場合、その状態の watch を反映する
+    (void)context.updateSocketWatches_();
     return Result<void>();
 }
 
 void SendResponseState::getWatchFlags(
     const HttpSession& session, bool* want_read, bool* want_write) const
 {
-    (void)session;
     if (want_read)
     {
-        *want_read = false;
+        *want_read = session.isStreamingBodyToCgi_() &&
+                     session.context_.recv_buffer.size() <
+                         HttpSession::kMaxRecvBufferBytes;
     }
     if (want_write)
     {
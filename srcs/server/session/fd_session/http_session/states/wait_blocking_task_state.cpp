@@ -0,0 +1,23 @@
+#include "server/session/fd_session/http_session.hpp"
+#include "server/session/fd_session/http_session/states/http_session_states.hpp"
+
+namespace server
+{
+using namespace utils::result;
+
+// ExecuteCgiState と同様に、待っている間も受信と先行レスポンスの送信は続ける。
+// peer がハーフクローズしてもレスポンスは読めるので、タスクの完了を待って
+// SendResponseState と同じように送る（送信後に接続を閉じる）。
+Result<void> WaitBlockingTaskState::handleEvent(
+    HttpSession& context, const FdEvent& event)
+{
+    return context.handleSocketEventWhileWaiting_(event);
+}
+
+void WaitBlockingTaskState::getWatchFlags(
+    const HttpSession& session, bool* want_read, bool* want_write) const
+{
+    session.getWaitingWatchFlags_(want_read, want_write);
+}
+
+}  // namespace server
@@ -0,0 +1,37 @@
+#include "server/session/fd_session/http_session.hpp"
+#include "server/session/fd_session/http_session/states/http_session_states.hpp"
+#include "server/session/fd_session_controller.hpp"
+
+namespace server
+{
+using namespace utils::result;
+
+// ExecuteCgiState と同様に、待っている間も受信と先行レスポンスの送信は続ける
+Result<void> WaitCgiSlotState::handleEvent(
+    HttpSession& context, const FdEvent& event)
+{
+    Result<void> w = context.handleSocketEventWhileWaiting_(event);
+    if (w.isError())
+        return w;
+
+    // 応答先が無いので列から抜ける。
+    // ただし先行レスポンスが send_buffer に残っていれば送り切ってから閉じる
+    if (context.context_.peer_closed)
+        context.module_.cgi_limiter.cancel(&context);
+    if (context.context_.peer_closed &&
+        context.context_.send_buffer.size() == 0)
+    {
+        context.changeState(new CloseWaitState());
+        context.context_.socket_fd.shutdown();
+        context.controller_.requestDelete(&context);
+    }
+    return Result<void>();
+}
+
+void WaitCgiSlotState::getWatchFlags(
+    const HttpSession& session, bool* want_read, bool* want_write) const
+{
+    session.getWaitingWatchFlags_(want_read, want_write);
+}
+
+}  // namespace server
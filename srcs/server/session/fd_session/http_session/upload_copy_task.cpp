@@ -0,0 +1,36 @@
+#include "server/session/fd_session/http_session/upload_copy_task.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "server/session/fd_session/http_session/body_store.hpp"
+#include "utils/result.hpp"
+
+namespace server
+{
+
+using namespace utils::result;
+
+UploadCopyTask::UploadCopyTask(
+    int in_fd, size_t size, const std::string& dest_path)
+    : in_fd_(in_fd), size_(size), dest_path_(dest_path)
+{
+    // コピー中に CGI が fork されても子へ渡らないようにする
+    if (in_fd_ >= 0)
+        (void)::fcntl(in_fd_, F_SETFD, FD_CLOEXEC);
+}
+
+UploadCopyTask::~UploadCopyTask()
+{
+    if (in_fd_ >= 0)
+        ::close(in_fd_);
+}
+
+void UploadCopyTask::run()
+{
+    Result<void> r = BodyStore::copyToNewFile(in_fd_, size_, dest_path_);
+    if (r.isError())
+        setError_(r.getErrorMessage());
+}
+
+}  // namespace server
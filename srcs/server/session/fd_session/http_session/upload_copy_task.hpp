@@ -0,0 +1,35 @@
+#ifndef WEBSERV_UPLOAD_COPY_TASK_HPP_
+#define WEBSERV_UPLOAD_COPY_TASK_HPP_
+
+#include <cstddef>
+#include <string>
+
+#include "server/blocking_task/blocking_task.hpp"
+
+namespace server
+{
+
+// 一時ファイルのボディを upload_store の保存先へコピーする。
+// linkat() で名前を付けられなかった場合（別ファイルシステム等）に使う。
+// fd は所有して閉じる。失敗時のエラーメッセージは BodyStore と同じ。
+class UploadCopyTask : public BlockingTask
+{
+   public:
+    UploadCopyTask(int in_fd, size_t size, const std::string& dest_path);
+    virtual ~UploadCopyTask();
+
+    virtual void run();
+
+   private:
+    int in_fd_;
+    size_t size_;
+    std::string dest_path_;
+
+    UploadCopyTask();
+    UploadCopyTask(const UploadCopyTask& rhs);
+    UploadCopyTask& operator=(const UploadCopyTask& rhs);
+};
+
+}  // namespace server
+
+#endif
@@ -0,0 +1,56 @@
+#include "server/session/fd_session/http_session/upload_path.hpp"
+
+#include <sys/stat.h>
+
+#include <sstream>
+
+#include "utils/timestamp.hpp"
+
+namespace server
+{
+
+namespace
+{
+
+bool fileExists_(const std::string& path)
+{
+    struct stat st;
+    return (::stat(path.c_str(), &st) == 0);
+}
+
+}  // namespace
+
+std::string UploadPath::join(const std::string& dir, const std::string& leaf)
+{
+    if (dir.empty())
+        return leaf;
+    if (!leaf.empty() && leaf[0] == '/')
+        return dir + leaf;
+    if (dir[dir.size() - 1] == '/')
+        return dir + leaf;
+    return dir + "/" + leaf;
+}
+
+std::string UploadPath::uniqueLeafName(
+    const std::string& dir, const std::string& stem, const std::string& ext)
+{
+    const std::string safe_stem = stem.empty() ? "file" : stem;
+    const std::string safe_ext = ext.empty() ? "bin" : ext;
+
+    std::string leaf = safe_stem + "." + safe_ext;
+    if (!fileExists_(join(dir, leaf)))
+        return leaf;
+
+    for (int i = 0; i < 1000000; ++i)
+    {
+        std::ostringstream oss;
+        oss << safe_stem << "_" << i << "." << safe_ext;
+        leaf = oss.str();
+        if (!fileExists_(join(dir, leaf)))
+            return leaf;
+    }
+    return safe_stem + "_" + utils::Timestamp::nowYmdHmsCompact() + "." +
+           safe_ext;
+}
+
+}  // namespace server
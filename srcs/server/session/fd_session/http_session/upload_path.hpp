@@ -0,0 +1,29 @@
+#ifndef WEBSERV_UPLOAD_PATH_HPP_
+#define WEBSERV_UPLOAD_PATH_HPP_
+
+#include <string>
+
+namespace server
+{
+
+// upload_store 配下の保存先パスの組み立て
+class UploadPath
+{
+   public:
+    static std::string join(const std::string& dir, const std::string& leaf);
+
+    // dir 配下で未使用の "stem.ext"（衝突時は "stem_N.ext"）を返す。
+    // stem/ext が空なら "file" / "bin" を使う。
+    static std::string uniqueLeafName(
+        const std::string& dir, const std::string& stem, const std::string& ext);
+
+   private:
+    UploadPath();
+    UploadPath(const UploadPath& other);
+    UploadPath& operator=(const UploadPath& other);
+    ~UploadPath();
+};
+
+}  // namespace server
+
+#endif
@@ -1,50 +1,140 @@
 #include "server/session/io_buffer.hpp"
 
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <cstring>
 
 #include "utils/data_type.hpp"
 
 namespace server
 {
 
-IoBuffer::IoBuffer() : storage_(), read_pos_(0), write_pos_(0) {}
+namespace
+{
+
+// 1回の fillFromFd で読み込む上限
+const size_t kMaxFillBytes = 16 * utils::kPageSizeMin;
+
+size_t roundUpPowerOfTwo_(size_t n)
+{
+    size_t cap = utils::kPageSizeMin;
+    while (cap < n)
+        cap <<= 1;
+    return cap;
+}
+
+}  // namespace
 
-IoBuffer::~IoBuffer() {}
+IoBuffer::IoBuffer() : storage_(NULL), capacity_(0), head_(0), size_(0) {}
+
+IoBuffer::~IoBuffer() { delete[] storage_; }
+
+// 読み出し可能領域を最大2セグメントで返す
+size_t IoBuffer::readableSegments_(struct iovec* iov) const
+{
+    if (size_ == 0)
+        return 0;
+    const size_t first = (head_ + size_ <= capacity_) ? size_
+                                                      : (capacity_ - head_);
+    iov[0].iov_base = storage_ + head_;
+    iov[0].iov_len = first;
+    if (first == size_)
+        return 1;
+    iov[1].iov_base = storage_;
+    iov[1].iov_len = size_ - first;
+    return 2;
+}
+
+// 書き込み可能（空き）領域を最大2セグメントで返す
+size_t IoBuffer::writableSegments_(struct iovec* iov)
+{
+    const size_t free_bytes = capacity_ - size_;
+    if (free_bytes == 0)
+        return 0;
+    const size_t tail = tail_();
+    const size_t to_end = capacity_ - tail;
+    const size_t first_len = (to_end < free_bytes) ? to_end : free_bytes;
+    iov[0].iov_base = storage_ + tail;
+    iov[0].iov_len = first_len;
+    if (first_len == free_bytes)
+        return 1;
+    iov[1].iov_base = storage_;
+    iov[1].iov_len = free_bytes - first_len;
+    return 2;
+}
+
+// 新しい領域を確保し、既存データを先頭から並べ直す。拡張時のみ呼ばれる。
+void IoBuffer::reallocate_(size_t new_capacity)
+{
+    utils::Byte* next = new utils::Byte[new_capacity];
+    struct iovec iov[2];
+    const size_t segs = readableSegments_(iov);
+    size_t off = 0;
+    for (size_t i = 0; i < segs; ++i)
+    {
+        std::memcpy(next + off, iov[i].iov_base, iov[i].iov_len);
+        off += iov[i].iov_len;
+    }
+    delete[] storage_;
+    storage_ = next;
+    capacity_ = new_capacity;
+    head_ = 0;
+}
+
+void IoBuffer::reserveFree_(size_t n)
+{
+    if (capacity_ - size_ >= n)
+        return;
+    reallocate_(roundUpPowerOfTwo_(size_ + n));
+}
+
+// [head_, capacity_) と [0, tail) に分かれたデータを、storage_ 全体を
+// head_ だけ左に回転させて [0, size_) に並べる（new[] はしない）
+void IoBuffer::linearizeInPlace_() const
+{
+    if (size_ == 0 || head_ + size_ <= capacity_)
+        return;
+    std::rotate(storage_, storage_ + head_, storage_ + capacity_);
+    head_ = 0;
+}
 
 const char* IoBuffer::data() const
 {
     static const char kEmpty[1] = {0};
     if (size() == 0)
         return kEmpty;
-    return reinterpret_cast<const char*>(&storage_[read_pos_]);
+    linearizeInPlace_();
+    return reinterpret_cast<const char*>(storage_ + head_);
+}
+
+const char* IoBuffer::frontSegment(size_t* out_len) const
+{
+    static const char kEmpty[1] = {0};
+    struct iovec iov[2];
+    if (readableSegments_(iov) == 0)
+    {
+        *out_len = 0;
+        return kEmpty;
+    }
+    *out_len = iov[0].iov_len;
+    return reinterpret_cast<const char*>(iov[0].iov_base);
 }
 
 void IoBuffer::consume(size_t n)
 {
     if (n == 0)
         return;
-    if (n >= size())
+    if (n >= size_)
     {
-        storage_.clear();
-        read_pos_ = 0;
-        write_pos_ = 0;
+        // 空になったら先頭に戻し、以後のデータがラップしにくいようにする
+        head_ = 0;
+        size_ = 0;
         return;
     }
-    read_pos_ += n;
-
-    // 軽いコンパクション（先頭側が大きく空いたら詰める）
-    if (read_pos_ > utils::kPageSizeMin)
-    {
-        const size_t remaining = size();
-        std::copy(storage_.begin() + static_cast<std::ptrdiff_t>(read_pos_),
-            storage_.begin() + static_cast<std::ptrdiff_t>(write_pos_),
-            storage_.begin());
-        storage_.resize(remaining);
-        read_pos_ = 0;
-        write_pos_ = remaining;
-    }
+    head_ = (head_ + n) & mask_();
+    size_ -= n;
 }
 
 void IoBuffer::append(const char* data, size_t n)
@@ -52,23 +142,46 @@ void IoBuffer::append(const char* data, size_t n)
     if (data == NULL || n == 0)
         return;
 
-    if (storage_.size() < write_pos_ + n)
-        storage_.resize(write_pos_ + n);
+    reserveFree_(n);
 
-    std::copy(data, data + n,
-        storage_.begin() + static_cast<std::ptrdiff_t>(write_pos_));
-    write_pos_ += n;
+    struct iovec iov[2];
+    const size_t segs = writableSegments_(iov);
+    size_t off = 0;
+    for (size_t i = 0; i < segs && off < n; ++i)
+    {
+        size_t len = n - off;
+        if (len > iov[i].iov_len)
+            len = iov[i].iov_len;
+        std::memcpy(iov[i].iov_base, data + off, len);
+        off += len;
+    }
+    size_ += n;
 }
 
 void IoBuffer::append(const std::string& s) { append(s.data(), s.size()); }
 
 ssize_t IoBuffer::fillFromFd(int fd)
 {
-    // 読み込み量は適当なチャンク
-    char buf[utils::kPageSizeMin];
-    ssize_t n = ::read(fd, buf, sizeof(buf));
+    reserveFree_(utils::kPageSizeMin);
+
+    struct iovec iov[2];
+    size_t segs = writableSegments_(iov);
+
+    // 一度に読み込む量は kMaxFillBytes まで
+    size_t total = 0;
+    for (size_t i = 0; i < segs; ++i)
+    {
+        if (total + iov[i].iov_len > kMaxFillBytes)
+        {
+            iov[i].iov_len = kMaxFillBytes - total;
+            segs = i + 1;
+        }
+        total += iov[i].iov_len;
+    }
+
+    const ssize_t n = ::readv(fd, iov, static_cast<int>(segs));
     if (n > 0)
-        append(buf, static_cast<size_t>(n));
+        size_ += static_cast<size_t>(n);
     return n;
 }
 
@@ -76,7 +189,9 @@ ssize_t IoBuffer::flushToFd(int fd)
 {
     if (size() == 0)
         return 0;
-    ssize_t n = ::write(fd, data(), size());
+    struct iovec iov[2];
+    const size_t segs = readableSegments_(iov);
+    const ssize_t n = ::writev(fd, iov, static_cast<int>(segs));
     if (n > 0)
         consume(static_cast<size_t>(n));
     return n;
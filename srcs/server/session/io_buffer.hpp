@@ -2,22 +2,43 @@
 #define WEBSERV_IO_BUFFER_HPP_
 
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <cstddef>
 #include <string>
-#include <vector>
 
 #include "utils/data_type.hpp"
 
 namespace server
 {
 
+// 2のべき乗容量のリングバッファ。
+// - consume はポインタを進めるだけで、先頭への詰め直し(memmove)をしない。
+// - 領域確保は new[]（ゼロ初期化しない）で行い、拡張時のみ既存データを
+//   先頭から並べ直してコピーする。
+// - 解析側は frontSegment() で先頭の連続領域だけを見る。ラップをまたぐ
+//   データが必要なときだけ linearize() で（確保なしに）その場で並べ直す。
+// - fd との入出力は readv/writev で最大2セグメントを一度に扱う。
 class IoBuffer
 {
    private:
-    std::vector<utils::Byte> storage_;
-    size_t read_pos_;   // 次に読み出す位置
-    size_t write_pos_;  // 次に書き込む（追記する）位置
+    utils::Byte* storage_;
+    size_t capacity_;  // 常に 0 または 2のべき乗
+    // data() はラップ時にその場で線形化するため mutable にしている
+    mutable size_t head_;  // 次に読み出す位置（storage_ 内のインデックス）
+    size_t size_;              // 読み出し可能なバイト数
+
+    size_t mask_() const { return capacity_ - 1; }
+    size_t tail_() const { return (head_ + size_) & mask_(); }
+
+    void reserveFree_(size_t n);
+    void reallocate_(size_t new_capacity);
+    void linearizeInPlace_() const;
+    size_t readableSegments_(struct iovec* iov) const;
+    size_t writableSegments_(struct iovec* iov);
+
+    IoBuffer(const IoBuffer& rhs);
+    IoBuffer& operator=(const IoBuffer& rhs);
 
    public:
     IoBuffer();
@@ -30,8 +51,14 @@ class IoBuffer
     ssize_t flushToFd(int fd);
 
     // データの取得、消費（ポインタ操作）などのユーティリティ
+    // data() は読み出し可能な全バイトを連続領域として返す。
+    // ラップしている場合は linearize() してから返す。
     const char* data() const;
-    size_t size() const { return write_pos_ - read_pos_; }
+    // 先頭から連続して読める部分（ラップしていれば末尾側の1セグメント）
+    const char* frontSegment(size_t* out_len) const;
+    // ラップしていれば、領域を確保し直さずにその場で先頭へ並べ直す
+    void linearize() { linearizeInPlace_(); }
+    size_t size() const { return size_; }
     void consume(size_t n);  // 処理済みデータを捨てる
 
     // テストや組み立て用途でバッファへ追記
@@ -9,9 +9,11 @@ ProcessingLog::ProcessingLog()
       last_flush_epoch_seconds_(0),
       active_connections_(0),
       cgi_count_(0),
+      cgi_queue_count_(0),
       loop_time_max_seconds_(0),
       req_time_max_seconds_(0),
       block_io_count_(0),
+      cgi_reject_count_(0),
       cached_lines_()
 {
 }
@@ -61,6 +63,12 @@ void ProcessingLog::onCgiFinished()
         --cgi_count_;
 }
 
+void ProcessingLog::onCgiDequeued()
+{
+    if (cgi_queue_count_ > 0)
+        --cgi_queue_count_;
+}
+
 void ProcessingLog::recordLoopTimeSeconds(long seconds)
 {
     if (seconds > loop_time_max_seconds_)
@@ -86,7 +94,8 @@ void ProcessingLog::cacheCurrentLine_()
     std::ostringstream oss;
     oss << Timestamp::now() << ", " << active_connections_ << ", "
         << loop_time_max_seconds_ << ", " << req_time_max_seconds_ << ", "
-        << cgi_count_ << ", " << block_io_count_;
+        << cgi_count_ << ", " << block_io_count_ << ", " << cgi_queue_count_
+        << ", " << cgi_reject_count_;
     cached_lines_.push_back(oss.str());
 }
 
@@ -36,6 +36,11 @@ class ProcessingLog
     void onCgiStarted() { ++cgi_count_; }
     void onCgiFinished();
 
+    // cgi_max_concurrency による待ち行列
+    void onCgiQueued() { ++cgi_queue_count_; }
+    void onCgiDequeued();
+    void onCgiRejected() { ++cgi_reject_count_; }
+
     void recordLoopTimeSeconds(long seconds);
 
     void recordRequestTimeSeconds(long seconds);
@@ -51,11 +56,13 @@ class ProcessingLog
     // snapshot系（最新値を保持して出力する）
     long active_connections_;
     long cgi_count_;
+    long cgi_queue_count_;
 
     // period系（1秒毎に集計してクリアする）
     long loop_time_max_seconds_;
     long req_time_max_seconds_;
     long block_io_count_;
+    long cgi_reject_count_;
 
     std::vector<std::string> cached_lines_;
 
@@ -66,6 +73,7 @@ class ProcessingLog
         loop_time_max_seconds_ = 0;
         req_time_max_seconds_ = 0;
         block_io_count_ = 0;
+        cgi_reject_count_ = 0;
     }
 
     void cacheCurrentLine_();
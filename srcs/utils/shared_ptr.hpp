@@ -0,0 +1,83 @@
+#ifndef UTILS_SHARED_PTR_HPP_
+#define UTILS_SHARED_PTR_HPP_
+
+#include <cstddef>
+
+namespace utils
+{
+
+// C++98 向けの最小参照カウント付きスマートポインタ。
+// - 最後の1つが破棄されたときに delete する
+// - シングルスレッド前提（カウントは非アトミック）
+template <typename T>
+class SharedPtr
+{
+   public:
+    explicit SharedPtr(T* ptr = NULL)
+        : ptr_(ptr), count_(ptr != NULL ? new size_t(1) : NULL)
+    {
+    }
+
+    SharedPtr(const SharedPtr& rhs) : ptr_(rhs.ptr_), count_(rhs.count_)
+    {
+        if (count_ != NULL)
+            ++*count_;
+    }
+
+    SharedPtr& operator=(const SharedPtr& rhs)
+    {
+        if (this == &rhs || ptr_ == rhs.ptr_)
+            return *this;
+
+        release_();
+        ptr_ = rhs.ptr_;
+        count_ = rhs.count_;
+        if (count_ != NULL)
+            ++*count_;
+        return *this;
+    }
+
+    ~SharedPtr() { release_(); }
+
+    T* get() const { return ptr_; }
+
+    void reset(T* ptr = NULL)
+    {
+        SharedPtr tmp(ptr);
+        swap(tmp);
+    }
+
+    void swap(SharedPtr& rhs)
+    {
+        T* p = ptr_;
+        size_t* c = count_;
+        ptr_ = rhs.ptr_;
+        count_ = rhs.count_;
+        rhs.ptr_ = p;
+        rhs.count_ = c;
+    }
+
+    size_t useCount() const { return count_ != NULL ? *count_ : 0; }
+
+    T& operator*() const { return *ptr_; }
+    T* operator->() const { return ptr_; }
+
+   private:
+    T* ptr_;
+    size_t* count_;
+
+    void release_()
+    {
+        if (count_ != NULL && --*count_ == 0)
+        {
+            delete ptr_;
+            delete count_;
+        }
+        ptr_ = NULL;
+        count_ = NULL;
+    }
+};
+
+}  // namespace utils
+
+#endif
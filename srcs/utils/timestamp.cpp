@@ -6,6 +6,43 @@
 
 namespace utils
 {
+namespace
+{
+
+const char* const kWeekdayNames[7] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+const char* const kMonthNames[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+// 1970-01-01 からの日数（proleptic Gregorian）。timegm の代替。
+long daysFromCivil_(long y, long m, long d)
+{
+    y -= (m <= 2) ? 1 : 0;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const long yoe = y - era * 400;
+    const long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+bool parseDigits_(const std::string& s, size_t pos, size_t n, long* out)
+{
+    if (pos + n > s.size())
+        return false;
+    long v = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const char c = s[pos + i];
+        if (c < '0' || c > '9')
+            return false;
+        v = v * 10 + (c - '0');
+    }
+    *out = v;
+    return true;
+}
+
+}  // namespace
+
 std::string Timestamp::now()
 {
     return formatHmsFromEpochSeconds(nowEpochSeconds());
@@ -42,4 +79,52 @@ std::string Timestamp::nowYmdHmsCompact()
        << std::setw(2) << std::setfill('0') << lt->tm_sec;
     return ss.str();
 }
+
+std::string Timestamp::formatHttpDate(long epoch_seconds)
+{
+    const std::time_t t = static_cast<std::time_t>(epoch_seconds);
+    std::tm* gt = std::gmtime(&t);
+
+    std::stringstream ss;
+    ss << kWeekdayNames[gt->tm_wday] << ", " << std::setw(2)
+       << std::setfill('0') << gt->tm_mday << " " << kMonthNames[gt->tm_mon]
+       << " " << std::setw(4) << std::setfill('0') << (gt->tm_year + 1900)
+       << " " << std::setw(2) << std::setfill('0') << gt->tm_hour << ":"
+       << std::setw(2) << std::setfill('0') << gt->tm_min << ":"
+       << std::setw(2) << std::setfill('0') << gt->tm_sec << " GMT";
+    return ss.str();
+}
+
+// "Sun, 06 Nov 1994 08:49:37 GMT"
+//  0    5  8   12   17 20 23 26
+bool Timestamp::parseHttpDate(const std::string& s, long* out_epoch_seconds)
+{
+    if (out_epoch_seconds == NULL || s.size() != 29)
+        return false;
+    if (s.compare(3, 2, ", ") != 0 || s[7] != ' ' || s[11] != ' ' ||
+        s[16] != ' ' || s[19] != ':' || s[22] != ':' ||
+        s.compare(25, 4, " GMT") != 0)
+        return false;
+
+    long day = 0;
+    long year = 0;
+    long hour = 0;
+    long min = 0;
+    long sec = 0;
+    if (!parseDigits_(s, 5, 2, &day) || !parseDigits_(s, 12, 4, &year) ||
+        !parseDigits_(s, 17, 2, &hour) || !parseDigits_(s, 20, 2, &min) ||
+        !parseDigits_(s, 23, 2, &sec))
+        return false;
+
+    long month = 0;
+    while (month < 12 && s.compare(8, 3, kMonthNames[month]) != 0)
+        ++month;
+    if (month == 12 || day < 1 || day > 31 || hour > 23 || min > 59 ||
+        sec > 60)
+        return false;
+
+    *out_epoch_seconds = daysFromCivil_(year, month + 1, day) * 86400 +
+                         hour * 3600 + min * 60 + sec;
+    return true;
+}
 }  // namespace utils
@@ -21,6 +21,11 @@ class Timestamp
     // 現在時刻を YYYYMMDDHHMMSS で返す（アップロードファイル名用途）。
     static std::string nowYmdHmsCompact();
 
+    // RFC 9110 Section 5.6.7: IMF-fixdate（例: "Sun, 06 Nov 1994 08:49:37 GMT"）
+    static std::string formatHttpDate(long epoch_seconds);
+    // IMF-fixdate をエポック秒に変換する。形式が不正なら false。
+    static bool parseHttpDate(const std::string& s, long* out_epoch_seconds);
+
    private:
     Timestamp();
     Timestamp(const Timestamp& other);